@@ -3,11 +3,21 @@
 #ifndef ZULOID_AGENT_H
 #define ZULOID_AGENT_H
 
+#include <stdio.h>
+
 struct Agent;
 
 struct Agent *
 agent_new(void);
 
+/* Memory-maps a binary weights file (see "core/weights.h") and points the
+ * network layers into it. The previous weights, if any, are kept on failure. */
+int
+agent_load_weights(struct Agent *agent, const char *path);
+
+int
+agent_save_weights(const struct Agent *agent, FILE *stream);
+
 void
 agent_delete(struct Agent *agent);
 
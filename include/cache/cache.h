@@ -8,22 +8,30 @@
 #include <stdint.h>
 #include <stdlib.h>
 
+/* Direct-mapped cache of static evaluations by Zobrist hash: each position has
+ * a single slot, and newer positions simply overwrite older ones. There's no
+ * locking, so caches must not be shared between threads. */
 struct Cache;
 
 struct CacheEntry
 {
-	uint8_t evaluation;
-	uint8_t dispersion;
+	/* As given by the evaluation function. */
+	float evaluation;
+	/* Uncertainty of `evaluation`, if the evaluation function has any notion
+	 * of it, or zero. */
+	float dispersion;
 };
 
 struct Cache *
 cache_new(size_t size_in_bytes);
 
+/* The entry of `pos`. It's empty (see `cache_entry_is_empty`) if `pos` wasn't
+ * there already, and then it's up to the caller to fill it. */
 struct CacheEntry *
 cache_get(struct Cache *cache, const struct Board *pos);
 
 bool
-cache_entry_is_empty(struct CacheEntry *entry);
+cache_entry_is_empty(const struct CacheEntry *entry);
 
 size_t
 cache_clear(struct Cache *cache);
@@ -0,0 +1,34 @@
+/* SPDX-License-Identifier: GPL-3.0-only */
+
+#ifndef ZULOID_CHESS_ATTACK_MAPS_H
+#define ZULOID_CHESS_ATTACK_MAPS_H
+
+#include "chess/color.h"
+#include "chess/coordinates.h"
+#include "chess/lanes.h"
+#include "chess/position.h"
+
+/* Everything a side attacks, regardless of pins and of whose turn it is.
+ * Knight attacks are kept apart by jump and slider attacks by direction: no
+ * two pieces attack the same square with the same jump or along the same
+ * direction, so their popcounts are also move counts. */
+struct AttackMaps
+{
+	Bitboard pawns;
+	Bitboard knights[LANES_COUNT];
+	/* Diagonally for bishops and orthogonally for rooks, i.e. both for
+	 * queens. */
+	Bitboard sliders[DIRECTIONS_COUNT];
+	Bitboard king;
+	/* All of the above. */
+	Bitboard all;
+	/* Squares attacked at least twice. */
+	Bitboard double_attacks;
+};
+
+/* Computes the attack maps of both sides in one pass over all directions and
+ * jumps at once. */
+void
+position_attack_maps(const struct Board *pos, struct AttackMaps maps[COLORS_COUNT]);
+
+#endif
@@ -0,0 +1,60 @@
+/* SPDX-License-Identifier: GPL-3.0-only */
+
+#ifndef ZULOID_CHESS_BOARD_BATCH_H
+#define ZULOID_CHESS_BOARD_BATCH_H
+
+#include "chess/coordinates.h"
+#include "chess/lanes.h"
+#include "chess/position.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+enum
+{
+	BOARD_BATCH_SIZE = LANES_COUNT,
+};
+
+/* Several positions side by side, for bulk work like perft and training data
+ * generation. It's a structure of arrays: lane `i` of every field belongs to
+ * the `i`-th position, so that a whole batch can go through each bitboard
+ * operation at once (see chess/lanes.h). Unused lanes are empty boards. */
+struct BoardBatch
+{
+	Bitboard bb[POSITION_BB_COUNT][BOARD_BATCH_SIZE];
+	Bitboard en_passant[BOARD_BATCH_SIZE];
+	uint8_t side_to_move[BOARD_BATCH_SIZE];
+	uint8_t castling_rights[BOARD_BATCH_SIZE];
+	size_t count;
+} __attribute__((aligned(64)));
+
+struct BoardBatchResults
+{
+	/* Squares threatened by the side not to move. The king of the side to move
+	 * doesn't block any threats, so that it can't step back along a ray. */
+	Bitboard threats[BOARD_BATCH_SIZE];
+	/* Pieces giving check. */
+	Bitboard checkers[BOARD_BATCH_SIZE];
+	size_t legal_moves_count[BOARD_BATCH_SIZE];
+};
+
+void
+board_batch_clear(struct BoardBatch *batch);
+
+/* Adds `board` to the next free lane. Returns false if the batch is full. */
+bool
+board_batch_push(struct BoardBatch *batch, const struct Board *board);
+
+static inline bool
+board_batch_is_full(const struct BoardBatch *batch)
+{
+	return batch->count == BOARD_BATCH_SIZE;
+}
+
+/* Computes threats, checkers and the number of legal moves of all positions in
+ * `batch` at once. Only standard castling is supported, like in
+ * `gen_legal_moves`. */
+void
+board_batch_analyze(const struct BoardBatch *batch, struct BoardBatchResults *results);
+
+#endif
@@ -0,0 +1,47 @@
+/* SPDX-License-Identifier: GPL-3.0-only */
+
+#ifndef ZULOID_CHESS_BOOK_H
+#define ZULOID_CHESS_BOOK_H
+
+/* Polyglot opening books, see docs/polyglot.html. Books are mapped into memory
+ * and searched in place, so opening them is cheap no matter their size. */
+
+#include "chess/move.h"
+#include "chess/position.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+enum
+{
+	BOOK_ENTRY_SIZE = 16,
+};
+
+struct Book;
+
+/* Returns NULL if `path` can't be read or is not a Polyglot book. */
+struct Book *
+book_open(const char *path);
+
+void
+book_close(struct Book *book);
+
+/* The Polyglot key of `pos`. It's the same as `pos->hash`, except that the en
+ * passant file only counts if a pawn can actually capture en passant. */
+uint64_t
+position_polyglot_key(const struct Board *pos);
+
+/* The Polyglot encoding of `mv`, which must be legal. */
+uint16_t
+book_move_encode(const struct Move *mv);
+
+/* Picks one of the book moves for `pos`, at random with probability
+ * proportional to their weights, or the heaviest one if `best_only`. `random`
+ * is any random number. Returns false if there are no legal book moves. */
+bool
+book_probe(const struct Book *book,
+           const struct Board *pos,
+           bool best_only,
+           uint64_t random,
+           struct Move *mv);
+
+#endif
@@ -21,6 +21,12 @@ position_init_from_fen_fields(struct Board *pos, const char **fieldsptr);
 int
 position_init_from_fen(struct Board *pos, const char *fen);
 
+/* Parses an EPD record in place: the first four FEN fields, optionally
+ * followed by the move counters, which many EPD files have anyway. `*operations`
+ * is set to the rest of the line. */
+int
+position_init_from_epd(struct Board *pos, char *line, char **operations);
+
 extern const char FEN_OF_INITIAL_POSITION[FEN_SIZE];
 
 #endif
@@ -0,0 +1,32 @@
+/* SPDX-License-Identifier: GPL-3.0-only */
+
+#ifndef ZULOID_CHESS_GENERATED_THREATS_H
+#define ZULOID_CHESS_GENERATED_THREATS_H
+
+#include "chess/coordinates.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+/* Defined by the output of tools/gen_threats.c, which the build runs before
+ * compiling the engine. The attack tables of each square start at its offset,
+ * and are indexed by magic hashing of the relevant obstacles (see
+ * `magic_index`), with `BB_FILL_*` set for black magics. */
+
+extern const Bitboard THREATS_BY_KNIGHT[SQUARES_COUNT];
+extern const Bitboard THREATS_BY_KING[SQUARES_COUNT];
+
+extern const Bitboard BB_MASK_BISHOP[SQUARES_COUNT];
+extern const Bitboard BB_FILL_BISHOP[SQUARES_COUNT];
+extern const uint64_t BB_MULTIPLIERS_BISHOP[SQUARES_COUNT];
+extern const unsigned char BB_SHIFTS_BISHOP[SQUARES_COUNT];
+extern const size_t BB_OFFSETS_BISHOP[SQUARES_COUNT];
+extern const Bitboard BB_ATTACKS_BISHOP[];
+
+extern const Bitboard BB_MASK_ROOK[SQUARES_COUNT];
+extern const Bitboard BB_FILL_ROOK[SQUARES_COUNT];
+extern const uint64_t BB_MULTIPLIERS_ROOK[SQUARES_COUNT];
+extern const unsigned char BB_SHIFTS_ROOK[SQUARES_COUNT];
+extern const size_t BB_OFFSETS_ROOK[SQUARES_COUNT];
+extern const Bitboard BB_ATTACKS_ROOK[];
+
+#endif
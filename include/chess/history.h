@@ -0,0 +1,57 @@
+/* SPDX-License-Identifier: GPL-3.0-only */
+
+#ifndef ZULOID_CHESS_HISTORY_H
+#define ZULOID_CHESS_HISTORY_H
+
+/* The Zobrist keys of the positions of a game, oldest first, for draw
+ * detection. The last key is that of the current position. */
+
+#include "chess/position.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+enum
+{
+	/* Plies without captures or pawn moves after which either side can claim
+	 * a draw. */
+	FIFTY_MOVES_RULE_PLIES = 100,
+};
+
+struct History
+{
+	uint64_t *keys;
+	size_t count;
+	size_t capacity;
+};
+
+void
+history_init(struct History *history);
+
+/* `history` must be initialized already, and it's overwritten. */
+void
+history_copy(struct History *history, const struct History *other);
+
+void
+history_delete(struct History *history);
+
+/* Forgets all positions and starts over from `pos`. */
+void
+history_reset(struct History *history, const struct Board *pos);
+
+void
+history_push(struct History *history, uint64_t key);
+
+void
+history_pop(struct History *history);
+
+uint64_t
+history_last(const struct History *history);
+
+/* True if the current position already occurred within the last
+ * `reversible_moves_count` plies, i.e. since the last capture or pawn move.
+ * Only positions with the same side to move are compared. */
+bool
+history_is_repetition(const struct History *history, int reversible_moves_count);
+
+#endif
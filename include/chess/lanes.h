@@ -0,0 +1,253 @@
+/* SPDX-License-Identifier: GPL-3.0-only */
+
+#ifndef ZULOID_CHESS_LANES_H
+#define ZULOID_CHESS_LANES_H
+
+/* Eight bitboards side by side, operated on all at once. Lanes can hold
+ * different positions (see `struct BoardBatch`) or the same position looked at
+ * in different directions. */
+
+#include "chess/coordinates.h"
+#include "feature_flags.h"
+#include <string.h>
+
+enum
+{
+	LANES_COUNT = 8,
+};
+
+#if ZULOID_ENABLE_SIMD
+// All helpers are inlined, so vectors never actually cross function boundaries.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+/* The compiler maps it onto whatever vector registers the target has, e.g. one
+ * AVX-512 register, two AVX2 registers or four SSE2 registers. */
+typedef Bitboard Lanes __attribute__((vector_size(LANES_COUNT * sizeof(Bitboard))));
+#else
+typedef struct
+{
+	Bitboard lane[LANES_COUNT];
+} Lanes;
+#endif
+
+#define LANES_RANK_1 0x0101010101010101ULL
+#define LANES_RANK_2 0x0202020202020202ULL
+#define LANES_RANK_3 0x0404040404040404ULL
+#define LANES_RANK_6 0x2020202020202020ULL
+#define LANES_RANK_7 0x4040404040404040ULL
+#define LANES_RANK_8 0x8080808080808080ULL
+#define LANES_FILE_A 0x00000000000000ffULL
+#define LANES_FILE_B 0x000000000000ff00ULL
+#define LANES_FILE_G 0x00ff000000000000ULL
+#define LANES_FILE_H 0xff00000000000000ULL
+
+static inline Lanes
+lanes_load(const Bitboard src[LANES_COUNT])
+{
+	Lanes x;
+	memcpy(&x, src, sizeof(x));
+	return x;
+}
+
+static inline void
+lanes_store(Bitboard dst[LANES_COUNT], Lanes x)
+{
+	memcpy(dst, &x, sizeof(x));
+}
+
+static inline Lanes
+lanes_splat(Bitboard bb)
+{
+	Bitboard bbs[LANES_COUNT];
+	for (size_t i = 0; i < LANES_COUNT; i++) {
+		bbs[i] = bb;
+	}
+	return lanes_load(bbs);
+}
+
+#if ZULOID_ENABLE_SIMD
+
+static inline Lanes
+lanes_and(Lanes a, Lanes b)
+{
+	return a & b;
+}
+
+static inline Lanes
+lanes_or(Lanes a, Lanes b)
+{
+	return a | b;
+}
+
+static inline Lanes
+lanes_andnot(Lanes a, Lanes b)
+{
+	return a & ~b;
+}
+
+/* Left if `shift` is positive, right otherwise. */
+static inline Lanes
+lanes_shift(Lanes a, int shift)
+{
+	return shift > 0 ? a << shift : a >> -shift;
+}
+
+/* Rotates each lane left by its own amount, from 0 to 63. */
+static inline Lanes
+lanes_rotate(Lanes a, Lanes amounts)
+{
+	return (a << amounts) | (a >> ((64 - amounts) & 63));
+}
+
+/* All ones in the lanes where `a` is not empty. */
+static inline Lanes
+lanes_nonzero(Lanes a)
+{
+	return (Lanes)(a != 0);
+}
+
+/* Lanes with more than one bit set. */
+static inline Lanes
+lanes_several(Lanes a)
+{
+	return (Lanes)((a & (a - 1)) != 0);
+}
+
+#else
+
+#define LANES_FOR(i) for (size_t i = 0; i < LANES_COUNT; i++)
+
+static inline Lanes
+lanes_and(Lanes a, Lanes b)
+{
+	LANES_FOR(i) a.lane[i] &= b.lane[i];
+	return a;
+}
+
+static inline Lanes
+lanes_or(Lanes a, Lanes b)
+{
+	LANES_FOR(i) a.lane[i] |= b.lane[i];
+	return a;
+}
+
+static inline Lanes
+lanes_andnot(Lanes a, Lanes b)
+{
+	LANES_FOR(i) a.lane[i] &= ~b.lane[i];
+	return a;
+}
+
+static inline Lanes
+lanes_shift(Lanes a, int shift)
+{
+	LANES_FOR(i) a.lane[i] = shift > 0 ? a.lane[i] << shift : a.lane[i] >> -shift;
+	return a;
+}
+
+static inline Lanes
+lanes_rotate(Lanes a, Lanes amounts)
+{
+	LANES_FOR(i)
+	a.lane[i] = (a.lane[i] << amounts.lane[i]) | (a.lane[i] >> ((64 - amounts.lane[i]) & 63));
+	return a;
+}
+
+static inline Lanes
+lanes_nonzero(Lanes a)
+{
+	LANES_FOR(i) a.lane[i] = a.lane[i] ? ~0ULL : 0;
+	return a;
+}
+
+static inline Lanes
+lanes_several(Lanes a)
+{
+	LANES_FOR(i) a.lane[i] = (a.lane[i] & (a.lane[i] - 1)) ? ~0ULL : 0;
+	return a;
+}
+
+#endif
+
+static inline Lanes
+lanes_not(Lanes a)
+{
+	return lanes_andnot(lanes_splat(~0ULL), a);
+}
+
+/* `a` where `mask` is set, `b` elsewhere. */
+static inline Lanes
+lanes_select(Lanes mask, Lanes a, Lanes b)
+{
+	return lanes_or(lanes_and(mask, a), lanes_andnot(b, mask));
+}
+
+enum Direction
+{
+	DIRECTION_N,
+	DIRECTION_S,
+	DIRECTION_E,
+	DIRECTION_W,
+	DIRECTION_NE,
+	DIRECTION_SW,
+	DIRECTION_NW,
+	DIRECTION_SE,
+	DIRECTIONS_COUNT,
+};
+
+/* Opposite directions share an axis, i.e. a line a pinned piece can move on. */
+#define DIRECTION_AXIS(dir) ((dir) / 2)
+
+enum
+{
+	AXES_COUNT = DIRECTIONS_COUNT / 2,
+};
+
+/* A step towards a direction, or a knight jump. Squares are `file * 8 + rank`,
+ * so moving along a file shifts by 1 and along a rank by 8. `mask` drops
+ * whatever wrapped around to the other edge, be it after a shift or a
+ * rotation. */
+struct LanesStep
+{
+	int shift;
+	Bitboard mask;
+};
+
+static const struct LanesStep DIRECTIONS[DIRECTIONS_COUNT] = {
+	[DIRECTION_N] = { 1, ~LANES_RANK_1 },
+	[DIRECTION_S] = { -1, ~LANES_RANK_8 },
+	[DIRECTION_E] = { 8, ~LANES_FILE_A },
+	[DIRECTION_W] = { -8, ~LANES_FILE_H },
+	[DIRECTION_NE] = { 9, ~(LANES_RANK_1 | LANES_FILE_A) },
+	[DIRECTION_SW] = { -9, ~(LANES_RANK_8 | LANES_FILE_H) },
+	[DIRECTION_NW] = { -7, ~(LANES_RANK_1 | LANES_FILE_H) },
+	[DIRECTION_SE] = { 7, ~(LANES_RANK_8 | LANES_FILE_A) },
+};
+
+static const struct LanesStep KNIGHT_JUMPS[LANES_COUNT] = {
+	{ 8 + 2, ~(LANES_RANK_1 | LANES_RANK_2 | LANES_FILE_A) },
+	{ 8 - 2, ~(LANES_RANK_7 | LANES_RANK_8 | LANES_FILE_A) },
+	{ -8 + 2, ~(LANES_RANK_1 | LANES_RANK_2 | LANES_FILE_H) },
+	{ -8 - 2, ~(LANES_RANK_7 | LANES_RANK_8 | LANES_FILE_H) },
+	{ 16 + 1, ~(LANES_RANK_1 | LANES_FILE_A | LANES_FILE_B) },
+	{ 16 - 1, ~(LANES_RANK_8 | LANES_FILE_A | LANES_FILE_B) },
+	{ -16 + 1, ~(LANES_RANK_1 | LANES_FILE_G | LANES_FILE_H) },
+	{ -16 - 1, ~(LANES_RANK_8 | LANES_FILE_G | LANES_FILE_H) },
+};
+
+/* All lanes one step towards `dir`. */
+static inline Lanes
+lanes_step(Lanes x, enum Direction dir)
+{
+	return lanes_and(lanes_shift(x, DIRECTIONS[dir].shift), lanes_splat(DIRECTIONS[dir].mask));
+}
+
+/* All lanes after the `i`-th knight jump. */
+static inline Lanes
+lanes_jump(Lanes x, size_t i)
+{
+	return lanes_and(lanes_shift(x, KNIGHT_JUMPS[i].shift), lanes_splat(KNIGHT_JUMPS[i].mask));
+}
+
+#endif
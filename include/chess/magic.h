@@ -4,23 +4,51 @@
 #define ZULOID_CHESS_MAGIC_H
 
 #include "chess/coordinates.h"
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
+/* Hashes the relevant obstacles of a slider into the index of its attacks, see
+ * `magic_index`. "Black" magics hash `occupancy | ~premask` rather than
+ * `occupancy & premask`, which tends to keep indices low. */
 struct Magic
 {
 	Bitboard premask;
 	uint64_t multiplier;
 	short rshift;
 	Bitboard postmask;
+	bool black;
 };
 
+size_t
+magic_index(const struct Magic *magic, Bitboard occupancy);
+
+/* Lays out the attack tables of all squares in a single array, which the
+ * caller must free. A square only takes entries up to its highest index in
+ * use, and tables are packed into each other's gaps wherever their entries
+ * don't conflict. Returns NULL if out of memory. */
+Bitboard *
+magics_build_attacks(const struct Magic magics[SQUARES_COUNT],
+                     Bitboard (*slider)(Square, Bitboard),
+                     size_t offsets[SQUARES_COUNT],
+                     size_t *size);
+
+/* Searches magics for all squares on `threads_count` threads, trying
+ * `attempts_count` multipliers for each square and table size. White and black
+ * candidates alike are tried with smaller and smaller shifts, keeping the ones
+ * with the smallest tables. The results only depend on `seed`. */
 void
-magic_find_rook(struct Magic *magic, Square square);
+magics_find_rook(struct Magic magics[SQUARES_COUNT],
+                 size_t threads_count,
+                 size_t attempts_count,
+                 uint64_t seed);
 
 void
-magic_find_bishop(struct Magic *magic, Square square);
+magics_find_bishop(struct Magic magics[SQUARES_COUNT],
+                   size_t threads_count,
+                   size_t attempts_count,
+                   uint64_t seed);
 
 int
 magics_export(const struct Magic *magics, const char *identifier, FILE *stream);
@@ -23,6 +23,13 @@ struct Move
 	enum PieceType capture;
 	bool castling;
 	int castling_side;
+	/* Set by `position_do_move`, like `capture`. */
+	bool en_passant;
+	/* The irreversible state before the move, saved by `position_do_move` for
+	 * `position_undo_move`. */
+	uint8_t previous_castling_rights;
+	Square previous_en_passant_target;
+	uint8_t previous_reversible_moves_count;
 };
 
 const struct Move MOVE_IDENTITY;
@@ -47,11 +54,25 @@ position_do_move(struct Board *pos, struct Move *mv);
 void
 position_do_move_and_flip(struct Board *pos, struct Move *mv);
 
+/* Plays `mv` as part of an actual game, flipping the side to move and keeping
+ * the move counters up to date. `position_take_back_move` undoes it. */
+void
+position_play_move(struct Board *pos, struct Move *mv);
+void
+position_take_back_move(struct Board *pos, const struct Move *mv);
+
 void
 position_undo_move(struct Board *pos, const struct Move *mv);
 void
 position_undo_move_and_flip(struct Board *pos, const struct Move *mv);
 
+/* Passes the turn to the other side, as in null move pruning. `mv` is set to
+ * MOVE_IDENTITY, with the state that `position_undo_null_move` needs. */
+void
+position_do_null_move(struct Board *pos, struct Move *mv);
+void
+position_undo_null_move(struct Board *pos, const struct Move *mv);
+
 int
 move_file_diff(struct Move *mv);
 
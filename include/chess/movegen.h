@@ -44,9 +44,14 @@ gen_attacks_against_from(struct Move moves[],
                          enum Color attacker,
                          Square en_passant_target,
                          bool castle);
+/* True if any piece of `attacker` threatens `square`. */
+bool
+position_is_attacked(const struct Board *pos, Square square, enum Color attacker);
 bool
 position_is_illegal(struct Board *pos);
 bool
+position_is_check(struct Board *pos);
+bool
 position_is_stalemate(struct Board *pos);
 
 #endif
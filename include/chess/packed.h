@@ -0,0 +1,81 @@
+/* SPDX-License-Identifier: GPL-3.0-only */
+
+#ifndef ZULOID_CHESS_PACKED_H
+#define ZULOID_CHESS_PACKED_H
+
+#include "chess/coordinates.h"
+#include "chess/position.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+/* Packed files are headerless arrays of `struct PackedPosition` in native byte
+ * order, so they can be concatenated, split, and shuffled with standard tools.
+ * Readers map them into memory for random access. */
+
+enum
+{
+	PACKED_POSITION_SIZE = 32,
+	PACKED_WRITER_BUFFER_SIZE = 4096,
+
+	PACKED_RESULT_LOSS = 0,
+	PACKED_RESULT_DRAW = 1,
+	PACKED_RESULT_WIN = 2,
+	PACKED_RESULT_UNKNOWN = 3,
+
+	/* Positions from EPD and PGN files often have no score. */
+	PACKED_SCORE_NONE = INT16_MIN,
+};
+
+/* A labelled position in exactly 32 bytes, for training data. Both `score` and
+ * `result` are from the point of view of the side to move. */
+struct PackedPosition
+{
+	Bitboard occupancy;
+	/* One nibble per piece, in the same order as the bits of `occupancy`. */
+	uint8_t pieces[16];
+	/* Bit 0 is the side to move, bits 1-4 are the castling rights. */
+	uint8_t flags;
+	int8_t en_passant_target;
+	uint8_t reversible_moves_count;
+	uint8_t result;
+	/* Centipawns, or PACKED_SCORE_NONE. */
+	int16_t score;
+	uint16_t moves_count;
+};
+
+void
+packed_from_position(struct PackedPosition *packed, const struct Board *pos);
+
+void
+position_init_from_packed(struct Board *pos, const struct PackedPosition *packed);
+
+struct PackedWriter;
+
+/* Truncates `path` and returns a buffered writer to it, or NULL on failure. */
+struct PackedWriter *
+packed_writer_open(const char *path);
+
+int
+packed_writer_push(struct PackedWriter *writer, const struct PackedPosition *packed);
+
+/* Flushes any buffered positions and closes the file. */
+int
+packed_writer_close(struct PackedWriter *writer);
+
+struct PackedReader;
+
+/* Maps a packed file into memory. Returns NULL on failure, including files
+ * whose size isn't a multiple of PACKED_POSITION_SIZE. */
+struct PackedReader *
+packed_reader_open(const char *path);
+
+size_t
+packed_reader_count(const struct PackedReader *reader);
+
+const struct PackedPosition *
+packed_reader_get(const struct PackedReader *reader, size_t i);
+
+void
+packed_reader_close(struct PackedReader *reader);
+
+#endif
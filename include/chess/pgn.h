@@ -0,0 +1,60 @@
+/* SPDX-License-Identifier: GPL-3.0-only */
+
+#ifndef ZULOID_CHESS_PGN_H
+#define ZULOID_CHESS_PGN_H
+
+/* A streaming PGN parser. It's fed one line at a time and only follows the main
+ * line of each game; comments, variations and annotation glyphs are skipped.
+ * Moves are parsed as SAN against the legal moves of the current position. */
+
+#include "chess/move.h"
+#include "chess/position.h"
+#include <stdbool.h>
+
+/* White's score in half points, same as packed results. */
+enum PgnResult
+{
+	PGN_RESULT_BLACK_WINS = 0,
+	PGN_RESULT_DRAW = 1,
+	PGN_RESULT_WHITE_WINS = 2,
+	PGN_RESULT_UNKNOWN = 3,
+};
+
+struct PgnParser
+{
+	/* The position before the next move. */
+	struct Board board;
+	enum PgnResult result;
+	/* Games with illegal moves or FEN tags are invalid from that point on. */
+	bool is_valid;
+	bool has_moves;
+	/* Nesting levels of comments and variations, which may span several
+	 * lines. */
+	int comment_depth;
+	int variation_depth;
+	/* Called before each valid move is played on `board`. */
+	void (*on_move)(void *data, const struct Board *pos, const struct Move *mv);
+	/* Called at the end of each game, valid or not. A nonzero return value
+	 * is handed back to the caller. */
+	int (*on_game)(void *data, const struct PgnParser *parser);
+	void *data;
+};
+
+void
+pgn_parser_init(struct PgnParser *parser,
+                void (*on_move)(void *, const struct Board *, const struct Move *),
+                int (*on_game)(void *, const struct PgnParser *),
+                void *data);
+
+/* `line` is only modified temporarily. */
+int
+pgn_parser_feed(struct PgnParser *parser, char *line);
+
+/* Ends the last game, in case it lacks a termination marker. */
+int
+pgn_parser_finish(struct PgnParser *parser);
+
+enum PgnResult
+string_to_pgn_result(const char *str);
+
+#endif
@@ -6,6 +6,7 @@
 #include "chess/color.h"
 #include "chess/coordinates.h"
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 
 enum PieceType
@@ -38,6 +39,18 @@ struct Piece
 
 extern const struct Piece PIECE_NONE;
 
+/* Pieces as stored in the mailbox of `struct Board`, one byte each: the type
+ * in the low nibble and the color in the high one. Empty squares are zero. */
+#define PIECE_CODE(type, color) ((uint8_t)((type) | ((color) << 4)))
+#define PIECE_CODE_TYPE(code) ((enum PieceType)((code)&0xf))
+#define PIECE_CODE_COLOR(code) ((enum Color)((code) >> 4))
+
+uint8_t
+piece_to_code(struct Piece piece);
+
+struct Piece
+code_to_piece(uint8_t code);
+
 char
 piece_to_char(struct Piece pc);
 
@@ -6,7 +6,9 @@
 #include "chess/color.h"
 #include "chess/coordinates.h"
 #include "chess/pieces.h"
+#include "chess/zobrist.h"
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -16,31 +18,83 @@ enum
 	CASTLING_RIGHT_KINGSIDE = 0x1,
 	CASTLING_RIGHT_QUEENSIDE = 0x2,
 	CASTLING_RIGHTS_ALL = 0xf,
+	/* The castling rights of each color take two bits. */
+	CASTLING_RIGHTS_BITS_PER_COLOR = 2,
 
 	POSITION_BB_COUNT = COLORS_COUNT + PRIMITIVE_PIECE_TYPES_COUNT,
 };
 
+#define CASTLING_RIGHT(side, color) ((side) << (CASTLING_RIGHTS_BITS_PER_COLOR * (color)))
+
 /* Parses a FEN field into castling rights. */
 int
 string_to_castling_rights(const char *str);
 
+/* Board state is kept small so that search can copy it around instead of
+ * undoing moves: the bitboards and the hash fill the first cache line, the
+ * mailbox the second, and the pawn hash and the remaining state take a few
+ * more bytes.
+ * The full move number only matters to FEN and game records, and it takes
+ * what would otherwise be padding. */
 struct Board
 {
 	Bitboard bb[POSITION_BB_COUNT];
-	enum Color side_to_move;
+	/* Zobrist hash of the whole position (see `chess/zobrist.h`), kept up to
+	 * date incrementally. */
+	uint64_t hash;
+	/* Mailbox, kept in sync with `bb`: the piece on each square, as given by
+	 * `piece_to_code`. */
+	uint8_t squares[SQUARES_COUNT];
+	/* Same, but of pawns alone. Pawn structure evaluation is cached by it. */
+	uint64_t pawn_hash;
+	uint8_t side_to_move;
+	uint8_t castling_rights;
 	Square en_passant_target;
-	int castling_rights;
-	size_t reversible_moves_count;
-	size_t moves_count;
+	uint8_t reversible_moves_count;
+	uint16_t moves_count;
 };
 
-/* Randomly sets up the chess position from Chess 960. */
+/* Randomly sets up the chess position from Chess 960, drawing from
+ * `prng_state` (see `prng_next`). */
 void
-position_init_960(struct Board *position);
+position_init_960(struct Board *position, uint64_t *prng_state);
 
-void
+/* Computes the Zobrist hash of `position` from scratch. Use it after
+ * changing the position's fields directly, e.g. when parsing FEN. */
+uint64_t
 position_zobrist(const struct Board *position);
 
+/* Same as `position_zobrist`, for `pawn_hash`. */
+uint64_t
+position_pawn_zobrist(const struct Board *position);
+
+/* Toggles the Zobrist key of `piece` on `square` in the hashes of `pos`. */
+static inline void
+position_hash_piece(struct Board *pos, uint8_t piece, Square square)
+{
+	uint64_t key = zobrist_piece(piece, square);
+	pos->hash ^= key;
+	if (PIECE_CODE_TYPE(piece) == PIECE_TYPE_PAWN) {
+		pos->pawn_hash ^= key;
+	}
+}
+
+/* Toggles the bitboards of `piece` (see `PIECE_CODE`) on the squares of
+ * `mask`, leaving the mailbox untouched. Queens live in both the bishop and
+ * the rook bitboards. */
+static inline void
+position_xor_piece(struct Board *pos, uint8_t piece, Bitboard mask)
+{
+	enum PieceType ptype = PIECE_CODE_TYPE(piece);
+	if (ptype == PIECE_TYPE_QUEEN) {
+		pos->bb[PIECE_TYPE_BISHOP] ^= mask;
+		pos->bb[PIECE_TYPE_ROOK] ^= mask;
+	} else {
+		pos->bb[ptype] ^= mask;
+	}
+	pos->bb[PIECE_CODE_COLOR(piece)] ^= mask;
+}
+
 /* Removes a piece from the board and replaces it with another one. */
 void
 position_set_piece_at_square(struct Board *position, Square square, struct Piece piece);
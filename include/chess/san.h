@@ -0,0 +1,16 @@
+/* SPDX-License-Identifier: GPL-3.0-only */
+
+#ifndef ZULOID_CHESS_SAN_H
+#define ZULOID_CHESS_SAN_H
+
+#include "chess/move.h"
+#include "chess/position.h"
+#include <stdlib.h>
+
+/* Parses a move in Standard Algebraic Notation (e.g. "Nbxd7+", "e8=Q",
+ * "O-O-O") and resolves it against the legal moves of `pos`. Returns the number
+ * of characters read, or 0 if the move is malformed, illegal, or ambiguous. */
+size_t
+string_to_move_san(const char *str, struct Board *pos, struct Move *mv);
+
+#endif
@@ -5,8 +5,9 @@
 
 #include "chess/coordinates.h"
 
-void
-init_threats(void);
+/* Table lookups. The tables are generated at build time by
+ * tools/gen_threats.c and live in read-only memory, so they need no
+ * initialization and all engines (and processes) share them. */
 
 Bitboard
 threats_by_king(Square sq);
@@ -16,11 +17,21 @@ threats_by_knight(Square sq);
 
 Bitboard
 threats_by_rook(Square sq, Bitboard obstacles);
-Bitboard
-threats_by_rook_no_init(Square sq, Bitboard obstacles);
 
 Bitboard
 threats_by_bishop(Square sq, Bitboard obstacles);
+
+/* The same threats, computed from scratch. See src/chess/rays.c. */
+
+Bitboard
+threats_by_king_no_init(Square sq);
+
+Bitboard
+threats_by_knight_no_init(Square sq);
+
+Bitboard
+threats_by_rook_no_init(Square sq, Bitboard obstacles);
+
 Bitboard
 threats_by_bishop_no_init(Square sq, Bitboard obstacles);
 
@@ -0,0 +1,67 @@
+/* SPDX-License-Identifier: GPL-3.0-only */
+
+#ifndef ZULOID_CHESS_ZOBRIST_H
+#define ZULOID_CHESS_ZOBRIST_H
+
+/* Zobrist hashing with the keys of Polyglot opening books: the hash of a
+ * position is the XOR of the keys of its pieces, castling rights, en passant
+ * file and side to move. Unlike Polyglot, the en passant file is hashed
+ * whenever there's an en passant target, capturing pawns or not. */
+
+#include "chess/color.h"
+#include "chess/coordinates.h"
+#include "chess/pieces.h"
+#include <stdint.h>
+
+enum
+{
+	ZOBRIST_KEYS_COUNT = 781,
+	ZOBRIST_OFFSET_CASTLING = 768,
+	ZOBRIST_OFFSET_EN_PASSANT = 772,
+	ZOBRIST_OFFSET_TURN = 780,
+};
+
+extern const uint64_t ZOBRIST_KEYS[ZOBRIST_KEYS_COUNT];
+
+/* `piece` is in mailbox encoding, see `PIECE_CODE`. */
+static inline uint64_t
+zobrist_piece(uint8_t piece, Square square)
+{
+	// Polyglot orders pieces by type first and color second, black first.
+	static const uint8_t KINDS[PIECE_TYPE_QUEEN + 1] = {
+		[PIECE_TYPE_PAWN] = 0, [PIECE_TYPE_KNIGHT] = 2, [PIECE_TYPE_BISHOP] = 4,
+		[PIECE_TYPE_ROOK] = 6, [PIECE_TYPE_QUEEN] = 8,  [PIECE_TYPE_KING] = 10,
+	};
+	int kind = KINDS[PIECE_CODE_TYPE(piece)] + (PIECE_CODE_COLOR(piece) == COLOR_WHITE);
+	// Polyglot enumerates squares rank-first.
+	return ZOBRIST_KEYS[64 * kind + 8 * (square % RANKS_COUNT) + square / RANKS_COUNT];
+}
+
+static inline uint64_t
+zobrist_castling_rights(int castling_rights)
+{
+	uint64_t hash = 0;
+	for (int i = 0; i < 4; i++) {
+		if (castling_rights & (1 << i)) {
+			hash ^= ZOBRIST_KEYS[ZOBRIST_OFFSET_CASTLING + i];
+		}
+	}
+	return hash;
+}
+
+static inline uint64_t
+zobrist_en_passant(Square en_passant_target)
+{
+	if (en_passant_target == SQUARE_NONE) {
+		return 0;
+	}
+	return ZOBRIST_KEYS[ZOBRIST_OFFSET_EN_PASSANT + en_passant_target / RANKS_COUNT];
+}
+
+static inline uint64_t
+zobrist_turn(enum Color side_to_move)
+{
+	return side_to_move == COLOR_WHITE ? ZOBRIST_KEYS[ZOBRIST_OFFSET_TURN] : 0;
+}
+
+#endif
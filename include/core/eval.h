@@ -4,12 +4,81 @@
 #define ZULOID_CORE_EVAL_H
 
 #include "chess/color.h"
+#include "chess/coordinates.h"
+#include "chess/pieces.h"
 #include "chess/position.h"
+#include "core/pawns.h"
+#include <stdio.h>
+
+/* All tunable evaluation parameters. It must only contain floats, as the tuner
+ * treats it as a flat array of EVAL_PARAMS_COUNT of them. */
+struct EvalParams
+{
+	/* Indexed by primitive piece type. Queens count as both bishops and
+	 * rooks. */
+	float material[PIECE_TYPE_LAST_PRIMITIVE + 1];
+	/* Bonus for the side to move. */
+	float tempo;
+	/* Material multipliers by square. */
+	float weights_by_pos[SQUARES_COUNT];
+	/* Per attacked square that's neither ours nor attacked by enemy pawns, by
+	 * primitive piece type. */
+	float mobility[PIECE_TYPE_LAST_PRIMITIVE + 1];
+	/* Per attacked square next to the enemy king, and again if it's attacked
+	 * twice. */
+	float king_zone_attacks;
+	float king_zone_double_attacks;
+	/* Per enemy piece (other than pawns) that we attack and they don't
+	 * defend. */
+	float hanging_pieces;
+	/* Per passed pawn, by rank from its own side's point of view. */
+	float passed_pawns[RANKS_COUNT];
+	float isolated_pawns;
+	float doubled_pawns;
+	float backward_pawns;
+	/* Per knight or bishop that a pawn of ours defends and that enemy pawns
+	 * can never attack. */
+	float outposts;
+};
+
+enum
+{
+	EVAL_PARAMS_COUNT = sizeof(struct EvalParams) / sizeof(float),
+};
 
 float
 position_eval_color(const struct Board *pos, enum Color side);
 
+/* From White's point of view, in pawns. */
 float
 position_eval(const struct Board *pos);
 
+/* Same as `position_eval`, but pawn structures go through `pawn_table`. */
+float
+position_eval_with_pawn_table(const struct Board *pos, struct PawnTable *pawn_table);
+
+/* Same as `position_eval`, but with arbitrary parameters. If `gradient` is not
+ * NULL, the gradient of the evaluation w.r.t. `params`, multiplied by `scale`,
+ * is added to it. */
+float
+position_eval_with_params(const struct Board *pos,
+                          const struct EvalParams *params,
+                          struct EvalParams *gradient,
+                          float scale);
+
+/* The largest change to the evaluation that moving a single piece other than
+ * the king can make through `EVAL_PARAMS.weights_by_pos`, captures aside. King
+ * steps are left out, as the king's material value dwarfs everything else. */
+float
+eval_max_move_swing(void);
+
+/* How much a single step of `side`'s king can gain through
+ * `EVAL_PARAMS.weights_by_pos`, from where it stands now. */
+float
+eval_king_step_gain(const struct Board *pos, enum Color side);
+
+/* Writes `params` as a C definition named `identifier`. */
+int
+eval_params_export(const struct EvalParams *params, const char *identifier, FILE *stream);
+
 #endif
@@ -0,0 +1,10 @@
+/* SPDX-License-Identifier: GPL-3.0-only */
+
+#ifndef ZULOID_CORE_GENERATED_EVAL_PARAMS_H
+#define ZULOID_CORE_GENERATED_EVAL_PARAMS_H
+
+#include "core/eval.h"
+
+extern const struct EvalParams EVAL_PARAMS;
+
+#endif
@@ -0,0 +1,50 @@
+/* SPDX-License-Identifier: GPL-3.0-only */
+
+#ifndef ZULOID_CORE_PAWNS_H
+#define ZULOID_CORE_PAWNS_H
+
+#include "chess/color.h"
+#include "chess/coordinates.h"
+#include "chess/position.h"
+#include <stdint.h>
+#include <stdlib.h>
+
+/* Pawn structure features, which only depend on the pawns. They're counts
+ * rather than scores, so that the evaluation stays linear in its parameters
+ * (see `struct EvalParams`). Ranks are relative to each side. */
+struct PawnEntry
+{
+	uint64_t pawn_hash;
+	/* Squares that pawns attack, now or after advancing. */
+	Bitboard attack_spans[COLORS_COUNT];
+	uint8_t passed_by_rank[COLORS_COUNT][RANKS_COUNT];
+	uint8_t isolated_count[COLORS_COUNT];
+	uint8_t doubled_count[COLORS_COUNT];
+	uint8_t backward_count[COLORS_COUNT];
+};
+
+enum
+{
+	/* Enough for the pawn structures of a typical search. */
+	PAWN_TABLE_SIZE_IN_BYTES = 1 << 20,
+};
+
+/* Cache of pawn structures by `pawn_hash`. It's meant for a single thread, so
+ * there's no locking at all. */
+struct PawnTable;
+
+void
+pawn_entry_init(struct PawnEntry *entry, const struct Board *pos);
+
+struct PawnTable *
+pawn_table_new(size_t size_in_bytes);
+
+void
+pawn_table_delete(struct PawnTable *table);
+
+/* The entry of `pos`, computed on the spot if it's not there already (or if
+ * it's been overwritten since). */
+const struct PawnEntry *
+pawn_table_probe(struct PawnTable *table, const struct Board *pos);
+
+#endif
@@ -0,0 +1,138 @@
+/* SPDX-License-Identifier: GPL-3.0-only */
+
+#ifndef ZULOID_CORE_SEARCH_H
+#define ZULOID_CORE_SEARCH_H
+
+#include "chess/history.h"
+#include "chess/move.h"
+#include "chess/position.h"
+#include <plibsys.h>
+#include <stdlib.h>
+
+/* Scores are in pawns, from the point of view of the side to move. */
+#define SCORE_MATE 100000.0
+
+enum
+{
+	QUIESCENCE_MAX_PLIES = 16,
+	SEARCH_MAX_DEPTH = 64,
+	/* Upper bound for `Config.multipv`. */
+	SEARCH_MAX_MULTIPV = 16,
+	/* Each search caches static evaluations in this much memory. */
+	SEARCH_EVAL_CACHE_SIZE_IN_BYTES = 1 << 22,
+};
+
+struct Config;
+
+int
+score_to_centipawns(float score);
+
+/* Moves until mate, negative if it's the side to move getting mated, or 0 if
+ * `score` is not a mate score. */
+int
+score_to_mate_in_moves(float score);
+
+/* A root move, its score and the principal variation that follows. */
+struct SearchLine
+{
+	float centipawns;
+	int pv_length;
+	struct Move pv[SEARCH_MAX_DEPTH];
+};
+
+/* Search counters, for debugging and tuning. They're only kept if
+ * ZULOID_ENABLE_SEARCH_DEBUGGING is set, and stay zero otherwise. */
+struct SearchStats
+{
+	/* Nodes with children, i.e. not counting leaves. */
+	size_t interior_nodes_count;
+	size_t leaves_count;
+	/* Checkmates and stalemates. */
+	size_t terminal_nodes_count;
+	/* Repetitions and fifty-move rule draws. */
+	size_t draws_count;
+	/* Leaves whose static evaluation was already cached. */
+	size_t eval_cache_hits_count;
+	/* Captures searched past the leaves. */
+	size_t qnodes_count;
+	/* Nodes where a move failed high, and how many of them on their very
+	 * first move, which tells how good move ordering is. */
+	size_t beta_cutoffs_count;
+	size_t first_move_cutoffs_count;
+	/* Nodes cut short by reverse futility pruning, null moves or ProbCut. */
+	size_t pruned_nodes_count;
+	/* Moves skipped by futility and late move pruning. */
+	size_t pruned_moves_count;
+	/* Null moves tried, and how many of them failed high. */
+	size_t null_moves_count;
+	size_t null_move_cutoffs_count;
+	/* Late move reductions, and how many of them failed high and had to be
+	 * searched again at full depth. */
+	size_t reductions_count;
+	size_t reduction_researches_count;
+	/* Null-window searches that failed high and had to be repeated with the
+	 * full window. */
+	size_t researches_count;
+	/* Nodes visited by each completed iteration. */
+	size_t iterations_count;
+	size_t nodes_count_by_iteration[SEARCH_MAX_DEPTH];
+};
+
+/* How many times more nodes the last completed iteration took than the one
+ * before, or 0 if unknown. */
+double
+search_stats_branching_factor(const struct SearchStats *stats, size_t iteration_i);
+
+struct SearchResults
+{
+	struct Move best_move;
+	/* The expected reply to `best_move`, or MOVE_IDENTITY if unknown. */
+	struct Move ponder_move;
+	float centipawns;
+	int depth;
+	/* The deepest plie the search reached. */
+	int seldepth;
+	size_t nodes_count;
+	/* The best `Config.multipv` root moves, best first. */
+	struct SearchLine lines[SEARCH_MAX_MULTIPV];
+	size_t lines_count;
+	struct SearchStats stats;
+};
+
+/* Lets other threads steer a running search. All fields are accessed
+ * atomically. */
+struct SearchSignals
+{
+	volatile pint stop;
+	/* Pondering (and infinite) searches ignore the time limit, and they must
+	 * not report their results until told otherwise. */
+	volatile pint ponder;
+	/* Milliseconds since `timer` was reset; 0 means no time limit. */
+	volatile pint time_limit_in_ms;
+	PTimeProfiler *timer;
+};
+
+/* True if the search should be interrupted as soon as possible. */
+bool
+search_signals_should_stop(struct SearchSignals *signals);
+
+/* Searches `board` up to `max_depth` plies, within the limits set by `config`
+ * and `signals` (which may be NULL). `history` holds the game so far, ending
+ * with `board`, for repetition detection; it may be NULL. It doesn't touch any
+ * global state, so multiple searches can run concurrently on different
+ * threads. */
+void
+position_search(const struct Board *board,
+                const struct History *history,
+                const struct Config *config,
+                int max_depth,
+                struct SearchSignals *signals,
+                struct SearchResults *results);
+
+/* Searches captures only, until `board` is quiet. `board` is left untouched.
+ * If `leaf` is not NULL, it's set to the quiet position at the end of the
+ * principal variation. */
+float
+position_quiesce(struct Board *board, float alpha, float beta, struct Board *leaf);
+
+#endif
@@ -0,0 +1,73 @@
+/* SPDX-License-Identifier: GPL-3.0-only */
+
+#ifndef ZULOID_CORE_WEIGHTS_H
+#define ZULOID_CORE_WEIGHTS_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* Binary network weights. A weights file is laid out as follows:
+ *
+ *  1. a `struct WeightsHeader`,
+ *  2. `tensors_count` instances of `struct WeightsTensor`,
+ *  3. the payload, where each tensor starts at a WEIGHTS_ALIGNMENT boundary
+ *     (relative to the start of the file) and is zero-padded.
+ *
+ * All integers are little-endian. The file is mapped read-only into memory,
+ * so tensors are used in place and all engine processes on the same host share
+ * the same page cache copy. The checksum is XXH64 of the whole payload. */
+
+enum
+{
+	WEIGHTS_VERSION = 1,
+	WEIGHTS_ALIGNMENT = 64,
+	WEIGHTS_TENSOR_NAME_SIZE = 32,
+};
+
+extern const char WEIGHTS_MAGIC[8];
+
+struct WeightsHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t tensors_count;
+	uint64_t payload_offset;
+	uint64_t payload_size;
+	uint64_t checksum;
+	uint8_t reserved[24];
+};
+
+struct WeightsTensor
+{
+	char name[WEIGHTS_TENSOR_NAME_SIZE];
+	/* Absolute offset from the start of the file. */
+	uint64_t offset;
+	uint64_t size_in_bytes;
+};
+
+struct Weights;
+
+/* Maps a weights file into memory and validates its header and checksum.
+ * Returns NULL on failure. */
+struct Weights *
+weights_open(const char *path);
+
+/* Finds a tensor by name. The returned pointer is WEIGHTS_ALIGNMENT-aligned and
+ * stays valid until `weights_close`. */
+const void *
+weights_tensor(const struct Weights *weights, const char *name, size_t *size_in_bytes);
+
+void
+weights_close(struct Weights *weights);
+
+/* Serializes `count` tensors into `stream`. `names`, `data`, and `sizes` are
+ * parallel arrays. */
+int
+weights_write(FILE *stream,
+              const char *const names[],
+              const void *const data[],
+              const size_t sizes[],
+              size_t count);
+
+#endif
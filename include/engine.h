@@ -4,10 +4,13 @@
 #define ZULOID_ENGINE_H
 
 #include "cache/cache.h"
+#include "chess/history.h"
 #include "chess/position.h"
 #include "chess/termination.h"
+#include "core/search.h"
 #include "eval.h"
 #include "time/game_clock.h"
+#include <plibsys.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -15,6 +18,11 @@
 #define ENGINE_LOGF(engine, ...)                                                           \
 	engine_logf(engine, __FILE__, __LINE__, __func__, __VA_ARGS__)
 
+enum
+{
+	ENGINE_OUTPUT_BUFFER_SIZE = 1 << 16,
+};
+
 enum Status
 {
 	// No background activity. The engine is just waiting for user input.
@@ -41,32 +49,73 @@ struct Config
 	// Must be in the range [0,1]. The greater its value, the more selective
 	// the engine will be in searching the game tree. Warning! Even little
 	// adjustments can have extensive influence over the gameplay. 0.5 is the
-	// most performant option. */
+	// most performant option, and 0 turns off forward pruning and reductions
+	// altogether. */
 	float selectivity;
 	bool ponder;
+	// How many root moves to report principal variations for; 0 and 1 both
+	// mean just the best one.
+	size_t multipv;
+	// Book moves are only played during the first `book_max_plies` plies of
+	// the game; 0 means no limit.
+	size_t book_max_plies;
+	// Always play the most weighted book move, instead of a random one.
+	bool book_best_move_only;
 	size_t max_nodes_count;
 	size_t max_depth;
 	FILE *output;
-	void (*protocol)(struct Engine *, const char *);
+	// Commands are tokenized in place, so they must be writable.
+	void (*protocol)(struct Engine *, char *);
 };
 
 struct Engine
 {
 	// Only one position at the time.
 	struct Board board;
+	// All positions of the current game up to `board`.
+	struct History history;
+	// `board` is `game_base` followed by `game_moves`. GUIs resend the whole
+	// game before every move, so we only want to play the new moves.
+	struct Board game_base;
+	struct Move *game_moves;
+	size_t game_moves_count;
+	size_t game_moves_capacity;
 	struct Cache *cache;
+	struct Metrics *metrics;
+	// Where ENGINE_LOGF writes to, once open. See "Debug Log File".
+	struct Logger *logger;
+	// The opening book, or NULL.
+	struct Book *book;
 	struct Agent *agent;
 	struct Eval eval;
 	struct Tablebase *tablebase;
-	int32_t seed;
+	// Book moves and Chess 960 setups are drawn from here, see `prng_next`.
+	// Engines don't share any mutable state, so several of them can run
+	// side by side on different threads.
+	uint64_t prng_state;
 	// A straightforward activity indicator. Both `main` and engine commands
 	// might want to know if the engine is doing background computation or
-	// what.
-	enum Status status;
+	// what. It holds an `enum Status` and is only accessed atomically, because
+	// the search thread resets it once done.
+	volatile pint status;
 	/* -- Search limits. */
 	struct TimeControl *time_controls[2];
 	struct GameClock game_clocks[2];
 	struct Config config;
+	/* -- Background search. */
+	PUThread *search_thread;
+	struct SearchSignals search_signals;
+	// What the search thread works on. They're copied from `board`, `history`
+	// and `config` before it starts and belong to it until it's joined, so
+	// commands are free to change the game meanwhile.
+	struct Board search_board;
+	struct History search_history;
+	struct Config search_config;
+	struct SearchResults search_results;
+	// Set if `search_results` come from the opening book.
+	bool search_is_book_move;
+	// Counters of the last joined search, see ZULOID_ENABLE_SEARCH_DEBUGGING.
+	struct SearchStats search_stats;
 };
 
 void
@@ -81,11 +130,41 @@ engine_init(struct Engine *engine);
 void
 engine_call(struct Engine *engine, char *cmd);
 
+/* Starts a new game from `base`. */
+void
+engine_reset_game(struct Engine *engine, const struct Board *base);
+/* Plays `mv` in the current game. */
+void
+engine_play_move(struct Engine *engine, struct Move mv);
+/* Takes back the last moves of the current game, until only `count` are left. */
+void
+engine_take_back_moves(struct Engine *engine, size_t count);
+/* False if `board` was changed other than by the functions above, e.g. by
+ * flipping the side to move. */
+bool
+engine_game_is_consistent(const struct Engine *engine);
+
+/* Starts searching `engine->board` on a background thread, which then prints
+ * "bestmove". Limits are set via `engine->config` and `engine->search_signals`
+ * beforehand. */
 void
 engine_start_search(struct Engine *engine);
+/* Turns a pondering search into a normal one, keeping all its progress. */
+void
+engine_ponderhit(struct Engine *engine);
+/* Interrupts the search, if any, and waits for it to report. */
 void
 engine_stop_search(struct Engine *engine);
 
+/* Output is fully buffered and only flushed at the end of each message, i.e.
+ * after each command or by `engine_output_end`. Background threads, and
+ * replies that take several writes, must wrap their messages in these, so
+ * that they don't interleave with others. */
+void
+engine_output_begin(struct Engine *engine);
+void
+engine_output_end(struct Engine *engine);
+
 void
 engine_logf(struct Engine *engine,
             const char *filename,
@@ -7,5 +7,10 @@
 #define ZULOID_ENABLE_DEBUG_MESSAGES 1
 #define ZULOID_ENABLE_SHOW_PID 1
 #define ZULOID_ENABLE_SEARCH_DEBUGGING 0
+// Search and move generation copy the board at every plie instead of undoing
+// moves.
+#define ZULOID_ENABLE_COPY_MAKE 1
+// Board batches use compiler vector extensions rather than plain loops.
+#define ZULOID_ENABLE_SIMD 1
 
 #endif
@@ -0,0 +1,54 @@
+/* SPDX-License-Identifier: GPL-3.0-only */
+
+#ifndef ZULOID_LOGGER_H
+#define ZULOID_LOGGER_H
+
+/* Debug logging off the protocol stream. Every thread appends records to its
+ * own lock-free ring buffer, and a background thread drains them all to the log
+ * file, so logging never blocks on I/O. Records that find their ring buffer
+ * full are dropped, and the number of dropped records is logged instead. */
+
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+enum
+{
+	/* Records per thread. */
+	LOGGER_RING_SIZE = 256,
+	LOGGER_MESSAGE_SIZE = 200,
+	LOGGER_FLUSH_INTERVAL_IN_MS = 10,
+};
+
+struct Logger;
+
+struct Logger *
+logger_new(void);
+
+/* Writes out all pending records first. */
+void
+logger_delete(struct Logger *logger);
+
+/* Appends records to `path` from now on; NULL stops logging. */
+int
+logger_open(struct Logger *logger, const char *path);
+
+bool
+logger_is_open(const struct Logger *logger);
+
+/* Queues a record, unless the logger is closed. `filename` and `function_name`
+ * must be string literals, since they're only read later. Messages longer than
+ * LOGGER_MESSAGE_SIZE are truncated. */
+void
+logger_vlogf(struct Logger *logger,
+             const char *filename,
+             size_t line_num,
+             const char *function_name,
+             const char *format,
+             va_list args);
+
+/* Waits until all records queued so far are written to the log file. */
+void
+logger_flush(struct Logger *logger);
+
+#endif
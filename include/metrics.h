@@ -0,0 +1,52 @@
+/* SPDX-License-Identifier: GPL-3.0-only */
+
+#ifndef ZULOID_METRICS_H
+#define ZULOID_METRICS_H
+
+/* Runtime metrics in OpenMetrics text format, for fleets of long-running engine
+ * processes. Searches report to `struct Metrics` only once they're over, so
+ * there's no cost on the search path. A background thread exports the metrics
+ * over HTTP on a local TCP port, to a file at regular intervals, or both. */
+
+#include <plibsys.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+enum
+{
+	METRICS_FILE_INTERVAL_IN_MS = 10000,
+	METRICS_MAX_SIZE = 4096,
+};
+
+struct Metrics;
+
+struct Metrics *
+metrics_new(void);
+
+void
+metrics_delete(struct Metrics *metrics);
+
+/* Records a finished search. It's a time loss if the search took longer than
+ * its time limit. */
+void
+metrics_add_search(struct Metrics *metrics,
+                   size_t nodes_count,
+                   puint64 elapsed_usecs,
+                   bool is_time_loss);
+
+/* Writes all metrics to `buf`, including the final "# EOF" line. Returns the
+ * length of the output, like `snprintf`. */
+size_t
+metrics_sprint(struct Metrics *metrics, char *buf, size_t size);
+
+/* Serves metrics at http://127.0.0.1:`port`/ (any path will do). 0 stops
+ * serving them. */
+int
+metrics_serve(struct Metrics *metrics, int port);
+
+/* Rewrites `path` every METRICS_FILE_INTERVAL_IN_MS, atomically. NULL stops
+ * writing it. */
+int
+metrics_export_to_file(struct Metrics *metrics, const char *path);
+
+#endif
@@ -0,0 +1,25 @@
+/* SPDX-License-Identifier: GPL-3.0-only */
+
+#ifndef ZULOID_MODES_H
+#define ZULOID_MODES_H
+
+/* Non-interactive modes of operation, selected by the first command line
+ * argument, e.g. `zuloid selfplay --games 1000`. They all return an exit
+ * status. */
+
+int
+mode_analyze(int argc, char **argv);
+
+int
+mode_convert(int argc, char **argv);
+
+int
+mode_makebook(int argc, char **argv);
+
+int
+mode_selfplay(int argc, char **argv);
+
+int
+mode_tune(int argc, char **argv);
+
+#endif
@@ -0,0 +1,40 @@
+/* SPDX-License-Identifier: GPL-3.0-only */
+
+#ifndef ZULOID_PROTOCOLS_SUPPORT_LINE_READER_H
+#define ZULOID_PROTOCOLS_SUPPORT_LINE_READER_H
+
+/* Reads protocol input in bulk straight from a file descriptor. Lines are
+ * handed out in place, so there are no allocations once the buffer is large
+ * enough for the longest line. */
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+enum
+{
+	LINE_READER_MIN_CAPACITY = 4096,
+};
+
+struct LineReader
+{
+	int fd;
+	char *buf;
+	size_t capacity;
+	/* Unread input is `buf[start..end)`. */
+	size_t start;
+	size_t end;
+	bool is_eof;
+};
+
+void
+line_reader_init(struct LineReader *reader, int fd);
+
+void
+line_reader_free(struct LineReader *reader);
+
+/* Returns the next line without its newline, or NULL once the input is over.
+ * The line may be modified, and it's valid until the next call. */
+char *
+line_reader_next(struct LineReader *reader);
+
+#endif
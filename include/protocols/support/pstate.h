@@ -14,20 +14,17 @@ struct PCommand
 	void (*handler)(struct Engine *, struct PState *);
 };
 
+/* Tokenizes a command in place, without any allocations. */
 struct PState
 {
-	const char *original;
-	char *str;
 	char *token;
 	char *saveptr;
 	const struct PCommand *cmd;
 };
 
-struct PState *
-pstate_new(const char *str, const struct PCommand commands[], size_t count);
-
+/* `str` is modified by tokenization and must outlive `pstate`. */
 void
-pstate_free(struct PState *pstate);
+pstate_init(struct PState *pstate, char *str, const struct PCommand commands[], size_t count);
 
 int
 pstate_skip(struct PState *pstate, const char *expected);
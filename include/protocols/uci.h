@@ -5,7 +5,8 @@
 
 #include "engine.h"
 
+/* `cmd` is tokenized in place, e.g. right in the input buffer. */
 void
-engine_call_uci(struct Engine *restrict engine, const char *cmd);
+engine_call_uci(struct Engine *restrict engine, char *cmd);
 
 #endif
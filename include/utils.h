@@ -20,6 +20,8 @@ enum ErrorCode
 	ERR_CODE_ALLOC,
 	ERR_CODE_UNSUPPORTED,
 	ERR_CODE_INVALID_FEN,
+	ERR_CODE_IO,
+	ERR_CODE_INVALID_WEIGHTS,
 };
 
 char *
@@ -36,6 +38,11 @@ static const char *const WHITESPACE = " \t\v\r\n";
 char *
 strtrim(char *str, const char *trimmable);
 
+/* A tiny splitmix64 generator. Its whole state is `*state`, so each thread can
+ * own one without any locking. */
+uint64_t
+prng_next(uint64_t *state);
+
 char *
 strtok_r_whitespace(char *restrict str, char **restrict save);
 
@@ -5,7 +5,9 @@
 #include "chess/fen.h"
 #include "chess/pieces.h"
 #include "chess/position.h"
+#include "utils.h"
 #include <ctype.h>
+#include <string.h>
 
 struct Chess960SetupState
 {
@@ -38,22 +40,28 @@ init_file(struct Chess960SetupState *state, File i, enum PieceType ptype)
 }
 
 void
-position_init_960(struct Board *position)
+position_init_960(struct Board *position, uint64_t *prng_state)
 {
-	position_init_from_fen(position, "8/pppppppp/8/8/8/8/PPPPPPPP/8 w KQkq - 0 1");
+	position_init_from_fen(position, "8/pppppppp/8/8/8/8/PPPPPPPP/8 w - - 0 1");
 	struct Chess960SetupState state = {
 		.position = position,
 		.available_files = { 0, 1, 2, 3, 4, 5, 6, 7 },
 		.available_files_count = 8,
 	};
-	// `rand() % n` is biased, remember.
-	init_file(&state, (rand() % 4) * 2 + 1, PIECE_TYPE_BISHOP);
-	init_file(&state, (rand() % 4) * 2, PIECE_TYPE_BISHOP);
-	init_file(&state, rand() % 6, PIECE_TYPE_QUEEN);
-	init_file(&state, rand() % 5, PIECE_TYPE_KNIGHT);
-	init_file(&state, rand() % 4, PIECE_TYPE_KNIGHT);
+	// `% n` is biased, but only by about n / 2^64.
+	init_file(&state, (prng_next(prng_state) % 4) * 2 + 1, PIECE_TYPE_BISHOP);
+	init_file(&state, (prng_next(prng_state) % 4) * 2, PIECE_TYPE_BISHOP);
+	init_file(&state, prng_next(prng_state) % 6, PIECE_TYPE_QUEEN);
+	init_file(&state, prng_next(prng_state) % 5, PIECE_TYPE_KNIGHT);
+	init_file(&state, prng_next(prng_state) % 4, PIECE_TYPE_KNIGHT);
 	qsort(state.available_files, 3, sizeof(File), files_compare);
 	init_file(&state, 0, PIECE_TYPE_ROOK);
 	init_file(&state, 1, PIECE_TYPE_KING);
 	init_file(&state, 2, PIECE_TYPE_ROOK);
+	// Only standard castling is supported, so there's no castling unless the
+	// pieces happen to be where they are in standard chess.
+	if (memcmp(position->bb, POSITION_INIT.bb, sizeof(position->bb)) == 0) {
+		position->castling_rights = POSITION_INIT.castling_rights;
+		position->hash = position_zobrist(position);
+	}
 }
@@ -0,0 +1,106 @@
+/* SPDX-License-Identifier: GPL-3.0-only */
+
+/* Attack maps of a single position, with one lane per direction (or knight
+ * jump) rather than per position like in board batches. Lanes then need to
+ * shift by different amounts, so steps are rotations and `DIRECTIONS` masks
+ * clear whatever wrapped around. */
+
+#include "chess/attack_maps.h"
+#include "chess/color.h"
+#include "chess/lanes.h"
+#include "chess/pieces.h"
+#include "chess/position.h"
+#include <string.h>
+
+struct LanesSteps
+{
+	Lanes amounts;
+	Lanes masks;
+};
+
+static struct LanesSteps
+lanes_steps(const struct LanesStep steps[LANES_COUNT], int multiplier)
+{
+	Bitboard amounts[LANES_COUNT];
+	Bitboard masks[LANES_COUNT];
+	for (size_t i = 0; i < LANES_COUNT; i++) {
+		amounts[i] = (steps[i].shift * multiplier) & 63;
+		masks[i] = steps[i].mask;
+	}
+	return (struct LanesSteps){ lanes_load(amounts), lanes_load(masks) };
+}
+
+static inline Lanes
+lanes_apply(Lanes x, const struct LanesSteps *steps)
+{
+	return lanes_and(lanes_rotate(x, steps->amounts), steps->masks);
+}
+
+/* Kogge-Stone occluded fill along all directions at once, followed by one more
+ * step to include the first obstacle. */
+static inline Lanes
+lanes_slide_all(Lanes sliders, Bitboard empty)
+{
+	static const int MULTIPLIERS[] = { 1, 2, 4 };
+	struct LanesSteps first = lanes_steps(DIRECTIONS, 1);
+	Lanes propagators = lanes_and(lanes_splat(empty), first.masks);
+	for (size_t i = 0; i < 3; i++) {
+		Lanes amounts = lanes_steps(DIRECTIONS, MULTIPLIERS[i]).amounts;
+		sliders = lanes_or(sliders, lanes_and(propagators, lanes_rotate(sliders, amounts)));
+		propagators = lanes_and(propagators, lanes_rotate(propagators, amounts));
+	}
+	return lanes_apply(sliders, &first);
+}
+
+static void
+attack_maps_add(struct AttackMaps *maps, Bitboard attacks)
+{
+	maps->double_attacks |= maps->all & attacks;
+	maps->all |= attacks;
+}
+
+static void
+attack_maps_init(struct AttackMaps *maps, const struct Board *pos, enum Color color)
+{
+	Bitboard us = pos->bb[color];
+	Bitboard empty = ~(pos->bb[COLOR_WHITE] | pos->bb[COLOR_BLACK]);
+	Bitboard sliders[DIRECTIONS_COUNT];
+	for (enum Direction dir = 0; dir < DIRECTIONS_COUNT; dir++) {
+		enum PieceType ptype = dir >= DIRECTION_NE ? PIECE_TYPE_BISHOP : PIECE_TYPE_ROOK;
+		sliders[dir] = us & pos->bb[ptype];
+	}
+	lanes_store(maps->sliders, lanes_slide_all(lanes_load(sliders), empty));
+	struct LanesSteps jumps = lanes_steps(KNIGHT_JUMPS, 1);
+	lanes_store(maps->knights, lanes_apply(lanes_splat(us & pos->bb[PIECE_TYPE_KNIGHT]), &jumps));
+	struct LanesSteps steps = lanes_steps(DIRECTIONS, 1);
+	Bitboard king[LANES_COUNT];
+	lanes_store(king, lanes_apply(lanes_splat(us & pos->bb[PIECE_TYPE_KING]), &steps));
+	Bitboard pawns = us & pos->bb[PIECE_TYPE_PAWN];
+	Bitboard pawns_east, pawns_west;
+	if (color == COLOR_WHITE) {
+		pawns_east = (pawns << 9) & DIRECTIONS[DIRECTION_NE].mask;
+		pawns_west = (pawns >> 7) & DIRECTIONS[DIRECTION_NW].mask;
+	} else {
+		pawns_east = (pawns << 7) & DIRECTIONS[DIRECTION_SE].mask;
+		pawns_west = (pawns >> 9) & DIRECTIONS[DIRECTION_SW].mask;
+	}
+	maps->pawns = pawns_east | pawns_west;
+	maps->king = 0;
+	maps->all = 0;
+	maps->double_attacks = 0;
+	attack_maps_add(maps, pawns_east);
+	attack_maps_add(maps, pawns_west);
+	for (size_t i = 0; i < LANES_COUNT; i++) {
+		attack_maps_add(maps, maps->knights[i]);
+		attack_maps_add(maps, maps->sliders[i]);
+		maps->king |= king[i];
+	}
+	attack_maps_add(maps, maps->king);
+}
+
+void
+position_attack_maps(const struct Board *pos, struct AttackMaps maps[COLORS_COUNT])
+{
+	attack_maps_init(&maps[COLOR_WHITE], pos, COLOR_WHITE);
+	attack_maps_init(&maps[COLOR_BLACK], pos, COLOR_BLACK);
+}
@@ -0,0 +1,348 @@
+/* SPDX-License-Identifier: GPL-3.0-only */
+
+/* Threats and legal move counts of many positions at once. Everything is
+ * computed set-wise with Kogge-Stone occluded fills rather than table lookups,
+ * so that the same instructions serve all lanes of a batch.
+ *
+ * Move counts don't need the moves themselves: the attacks of all sliders in a
+ * single direction never overlap (a slider stops at the first piece in its
+ * way, other sliders included), and neither do those of leapers in a single
+ * direction, so each direction can be counted with one popcount. Pins are
+ * found the same way, from the king outwards. Only en passant and castling are
+ * left to scalar code, one lane at a time. */
+
+#include "chess/board_batch.h"
+#include "chess/bb.h"
+#include "chess/color.h"
+#include "chess/lanes.h"
+#include "chess/mnemonics.h"
+#include "chess/pieces.h"
+#include "chess/threats.h"
+#include "libpopcnt/libpopcnt.h"
+#include <string.h>
+
+/* Kogge-Stone occluded fill: `sliders` spread over the squares of `empty`
+ * towards `dir`. */
+static inline Lanes
+lanes_fill(Lanes sliders, Lanes empty, enum Direction dir)
+{
+	int shift = DIRECTIONS[dir].shift;
+	Lanes propagators = lanes_and(empty, lanes_splat(DIRECTIONS[dir].mask));
+	sliders = lanes_or(sliders, lanes_and(propagators, lanes_shift(sliders, shift)));
+	propagators = lanes_and(propagators, lanes_shift(propagators, shift));
+	sliders = lanes_or(sliders, lanes_and(propagators, lanes_shift(sliders, 2 * shift)));
+	propagators = lanes_and(propagators, lanes_shift(propagators, 2 * shift));
+	return lanes_or(sliders, lanes_and(propagators, lanes_shift(sliders, 4 * shift)));
+}
+
+/* Squares attacked by `sliders` towards `dir`, up to and including the first
+ * obstacle. */
+static inline Lanes
+lanes_slide(Lanes sliders, Lanes empty, enum Direction dir)
+{
+	return lanes_step(lanes_fill(sliders, empty, dir), dir);
+}
+
+static inline Lanes
+lanes_king_attacks(Lanes kings)
+{
+	Lanes attacks = lanes_splat(0);
+	for (enum Direction dir = 0; dir < DIRECTIONS_COUNT; dir++) {
+		attacks = lanes_or(attacks, lanes_step(kings, dir));
+	}
+	return attacks;
+}
+
+static inline Lanes
+lanes_knight_attacks(Lanes knights)
+{
+	Lanes attacks = lanes_splat(0);
+	for (size_t i = 0; i < 8; i++) {
+		attacks = lanes_or(attacks, lanes_jump(knights, i));
+	}
+	return attacks;
+}
+
+/* Sliders moving towards `dir`: bishops (and queens) diagonally, rooks (and
+ * queens) orthogonally. */
+static inline Lanes
+lanes_sliders_towards(Lanes bishops, Lanes rooks, enum Direction dir)
+{
+	return dir >= DIRECTION_NE ? bishops : rooks;
+}
+
+/* Pawn captures, for white pawns in the lanes of `white` and black pawns
+ * elsewhere. */
+static inline Lanes
+lanes_pawn_attacks(Lanes pawns, Lanes white)
+{
+	Lanes white_attacks =
+	  lanes_or(lanes_step(pawns, DIRECTION_NE), lanes_step(pawns, DIRECTION_NW));
+	Lanes black_attacks =
+	  lanes_or(lanes_step(pawns, DIRECTION_SE), lanes_step(pawns, DIRECTION_SW));
+	return lanes_select(white, white_attacks, black_attacks);
+}
+
+static inline size_t
+popcount_lane(Bitboard bb)
+{
+	return popcnt64(bb);
+}
+
+/* Adds the popcount of each lane of `x`, times `weight`, to `counts`. */
+static inline void
+lanes_count(size_t counts[BOARD_BATCH_SIZE], Lanes x, size_t weight)
+{
+	Bitboard bbs[BOARD_BATCH_SIZE];
+	lanes_store(bbs, x);
+	for (size_t i = 0; i < BOARD_BATCH_SIZE; i++) {
+		counts[i] += popcount_lane(bbs[i]) * weight;
+	}
+}
+
+void
+board_batch_clear(struct BoardBatch *batch)
+{
+	memset(batch, 0, sizeof(*batch));
+}
+
+bool
+board_batch_push(struct BoardBatch *batch, const struct Board *board)
+{
+	if (board_batch_is_full(batch)) {
+		return false;
+	}
+	size_t i = batch->count++;
+	for (size_t j = 0; j < POSITION_BB_COUNT; j++) {
+		batch->bb[j][i] = board->bb[j];
+	}
+	batch->en_passant[i] =
+	  board->en_passant_target == SQUARE_NONE ? 0 : square_to_bb(board->en_passant_target);
+	batch->side_to_move[i] = board->side_to_move;
+	batch->castling_rights[i] = board->castling_rights;
+	return true;
+}
+
+/* Everything about a single lane that scalar code needs. */
+struct BatchLane
+{
+	enum Color side_to_move;
+	Bitboard us;
+	Bitboard them;
+	Bitboard pawns;
+	Bitboard knights;
+	Bitboard bishops;
+	Bitboard rooks;
+	Bitboard kings;
+	Bitboard threats;
+	Bitboard checkers;
+};
+
+static bool
+batch_lane_is_attacked(const struct BatchLane *lane,
+                       Square sq,
+                       Bitboard them,
+                       Bitboard pawns,
+                       Bitboard occupancy)
+{
+	Bitboard bb = square_to_bb(sq);
+	Bitboard pawn_attackers =
+	  lane->side_to_move == COLOR_WHITE
+	    ? ((bb & ~LANES_RANK_8) << 9) | ((bb & ~LANES_RANK_8) >> 7)
+	    : ((bb & ~LANES_RANK_1) << 7) | ((bb & ~LANES_RANK_1) >> 9);
+	return (pawn_attackers & them & pawns) ||
+	       (threats_by_knight(sq) & them & lane->knights) ||
+	       (threats_by_king(sq) & them & lane->kings) ||
+	       (threats_by_bishop(sq, occupancy) & them & lane->bishops) ||
+	       (threats_by_rook(sq, occupancy) & them & lane->rooks);
+}
+
+/* En passant can uncover a check along the rank of both pawns, which pins
+ * don't catch, so each capture is simply tried. */
+static size_t
+batch_lane_en_passant_moves_count(const struct BatchLane *lane, Bitboard en_passant)
+{
+	if (!en_passant || lane->checkers & (lane->checkers - 1)) {
+		return 0;
+	}
+	Bitboard captured =
+	  lane->side_to_move == COLOR_WHITE ? en_passant >> 1 : en_passant << 1;
+	Bitboard row = (en_passant << 8) | (en_passant >> 8);
+	Bitboard sources = (lane->side_to_move == COLOR_WHITE ? row >> 1 : row << 1) &
+	                   lane->us & lane->pawns;
+	Square king = LSB(lane->us & lane->kings);
+	size_t count = 0;
+	while (sources) {
+		Bitboard source = sources & -sources;
+		sources ^= source;
+		Bitboard them = lane->them ^ captured;
+		Bitboard occupancy = (lane->us ^ source ^ en_passant) | them;
+		count += !batch_lane_is_attacked(lane, king, them, lane->pawns ^ captured, occupancy);
+	}
+	return count;
+}
+
+static size_t
+batch_lane_castling_moves_count(const struct BatchLane *lane, uint8_t castling_rights)
+{
+	if (lane->checkers) {
+		return 0;
+	}
+	enum Color color = lane->side_to_move;
+	Rank rank = color_home_rank(color);
+	Bitboard occupancy = lane->us | lane->them;
+	Bitboard rooks_only = lane->us & lane->rooks & ~lane->bishops;
+	if (!(lane->us & lane->kings & square_to_bb(square_new(F_E, rank)))) {
+		return 0;
+	}
+	size_t count = 0;
+	if ((castling_rights & CASTLING_RIGHT(CASTLING_RIGHT_KINGSIDE, color)) &&
+	    (rooks_only & square_to_bb(square_new(F_H, rank)))) {
+		Bitboard between = square_to_bb(square_new(F_F, rank)) | square_to_bb(square_new(F_G, rank));
+		count += !(occupancy & between) && !(lane->threats & between);
+	}
+	if ((castling_rights & CASTLING_RIGHT(CASTLING_RIGHT_QUEENSIDE, color)) &&
+	    (rooks_only & square_to_bb(square_new(F_A, rank)))) {
+		Bitboard crossed = square_to_bb(square_new(F_D, rank)) | square_to_bb(square_new(F_C, rank));
+		Bitboard between = crossed | square_to_bb(square_new(F_B, rank));
+		count += !(occupancy & between) && !(lane->threats & crossed);
+	}
+	return count;
+}
+
+void
+board_batch_analyze(const struct BoardBatch *batch, struct BoardBatchResults *results)
+{
+	Bitboard white_bbs[BOARD_BATCH_SIZE];
+	for (size_t i = 0; i < BOARD_BATCH_SIZE; i++) {
+		white_bbs[i] = batch->side_to_move[i] == COLOR_WHITE ? ~0ULL : 0;
+	}
+	Lanes white = lanes_load(white_bbs);
+	Lanes us = lanes_select(
+	  white, lanes_load(batch->bb[COLOR_WHITE]), lanes_load(batch->bb[COLOR_BLACK]));
+	Lanes them = lanes_select(
+	  white, lanes_load(batch->bb[COLOR_BLACK]), lanes_load(batch->bb[COLOR_WHITE]));
+	Lanes pawns = lanes_load(batch->bb[PIECE_TYPE_PAWN]);
+	Lanes knights = lanes_load(batch->bb[PIECE_TYPE_KNIGHT]);
+	Lanes bishops = lanes_load(batch->bb[PIECE_TYPE_BISHOP]);
+	Lanes rooks = lanes_load(batch->bb[PIECE_TYPE_ROOK]);
+	Lanes kings = lanes_load(batch->bb[PIECE_TYPE_KING]);
+	Lanes occupancy = lanes_or(us, them);
+	Lanes empty = lanes_not(occupancy);
+	Lanes king = lanes_and(us, kings);
+
+	/* -- Threats by the opponent, who moves the other way. */
+	Lanes empty_but_king = lanes_or(empty, king);
+	Lanes threats = lanes_or(lanes_pawn_attacks(lanes_and(them, pawns), lanes_not(white)),
+	                         lanes_knight_attacks(lanes_and(them, knights)));
+	threats = lanes_or(threats, lanes_king_attacks(lanes_and(them, kings)));
+	for (enum Direction dir = 0; dir < DIRECTIONS_COUNT; dir++) {
+		Lanes sliders = lanes_and(them, lanes_sliders_towards(bishops, rooks, dir));
+		threats = lanes_or(threats, lanes_slide(sliders, empty_but_king, dir));
+	}
+
+	/* -- Checks and pins, looking outwards from the king. */
+	Lanes checkers = lanes_or(lanes_and(lanes_pawn_attacks(king, white), lanes_and(them, pawns)),
+	                          lanes_and(lanes_knight_attacks(king), lanes_and(them, knights)));
+	Lanes check_rays = lanes_splat(0);
+	Lanes pinned_by_axis[AXES_COUNT] = { lanes_splat(0) };
+	for (enum Direction dir = 0; dir < DIRECTIONS_COUNT; dir++) {
+		Lanes sliders = lanes_and(them, lanes_sliders_towards(bishops, rooks, dir));
+		Lanes ray = lanes_slide(king, empty, dir);
+		Lanes checker = lanes_and(ray, sliders);
+		checkers = lanes_or(checkers, checker);
+		check_rays = lanes_or(check_rays, lanes_and(ray, lanes_nonzero(checker)));
+		// Looks past the first piece of ours, if any.
+		Lanes blocker = lanes_and(ray, us);
+		Lanes xray = lanes_slide(king, lanes_or(empty, blocker), dir);
+		Lanes pinned = lanes_and(blocker, lanes_nonzero(lanes_and(xray, sliders)));
+		pinned_by_axis[DIRECTION_AXIS(dir)] = lanes_or(pinned_by_axis[DIRECTION_AXIS(dir)], pinned);
+	}
+	Lanes pinned = lanes_or(lanes_or(pinned_by_axis[0], pinned_by_axis[1]),
+	                        lanes_or(pinned_by_axis[2], pinned_by_axis[3]));
+	// Unless in check, anything goes. Against a single checker, only captures
+	// and blocks. Against two, nothing but king moves (see below).
+	Lanes check_mask = lanes_select(lanes_nonzero(checkers), lanes_or(check_rays, checkers), lanes_splat(~0ULL));
+	check_mask = lanes_andnot(check_mask, lanes_several(checkers));
+	Lanes targets = lanes_andnot(check_mask, us);
+
+	size_t counts[BOARD_BATCH_SIZE] = { 0 };
+	/* -- Knights. Pinned knights can't move at all. */
+	Lanes free_knights = lanes_andnot(lanes_and(us, knights), pinned);
+	for (size_t i = 0; i < 8; i++) {
+		lanes_count(counts, lanes_and(lanes_jump(free_knights, i), targets), 1);
+	}
+	/* -- Sliders. Pinned ones can still move along the pin. */
+	for (enum Direction dir = 0; dir < DIRECTIONS_COUNT; dir++) {
+		Lanes movers = lanes_and(us, lanes_sliders_towards(bishops, rooks, dir));
+		movers = lanes_andnot(movers, lanes_andnot(pinned, pinned_by_axis[DIRECTION_AXIS(dir)]));
+		lanes_count(counts, lanes_and(lanes_slide(movers, empty, dir), targets), 1);
+	}
+	/* -- Pawns. Promotions count four times. */
+	Lanes our_pawns = lanes_and(us, pawns);
+	Lanes free_pawns = lanes_andnot(our_pawns, pinned);
+	Lanes promotion_rank = lanes_select(white, lanes_splat(LANES_RANK_8), lanes_splat(LANES_RANK_1));
+	Lanes pushers =
+	  lanes_or(free_pawns, lanes_and(our_pawns, pinned_by_axis[DIRECTION_AXIS(DIRECTION_N)]));
+	Lanes single_pushes = lanes_and(lanes_select(white,
+	                                             lanes_step(pushers, DIRECTION_N),
+	                                             lanes_step(pushers, DIRECTION_S)),
+	                                empty);
+	Lanes double_pushes =
+	  lanes_and(single_pushes, lanes_select(white, lanes_splat(LANES_RANK_3), lanes_splat(LANES_RANK_6)));
+	double_pushes = lanes_and(lanes_select(white,
+	                                       lanes_step(double_pushes, DIRECTION_N),
+	                                       lanes_step(double_pushes, DIRECTION_S)),
+	                          empty);
+	single_pushes = lanes_and(single_pushes, check_mask);
+	lanes_count(counts, lanes_andnot(single_pushes, promotion_rank), 1);
+	lanes_count(counts, lanes_and(single_pushes, promotion_rank), 4);
+	lanes_count(counts, lanes_and(double_pushes, check_mask), 1);
+	// White captures towards NE and NW, black towards SW and SE. Either way,
+	// the first capture is along the NE-SW axis and the second along the other
+	// diagonal.
+	static const enum Direction CAPTURES[2][COLORS_COUNT] = {
+		{ DIRECTION_NE, DIRECTION_SW },
+		{ DIRECTION_NW, DIRECTION_SE },
+	};
+	for (size_t i = 0; i < 2; i++) {
+		enum Direction white_dir = CAPTURES[i][COLOR_WHITE];
+		enum Direction black_dir = CAPTURES[i][COLOR_BLACK];
+		Lanes capturers =
+		  lanes_or(free_pawns, lanes_and(our_pawns, pinned_by_axis[DIRECTION_AXIS(white_dir)]));
+		Lanes captures = lanes_select(
+		  white, lanes_step(capturers, white_dir), lanes_step(capturers, black_dir));
+		captures = lanes_and(captures, lanes_and(them, check_mask));
+		lanes_count(counts, lanes_andnot(captures, promotion_rank), 1);
+		lanes_count(counts, lanes_and(captures, promotion_rank), 4);
+	}
+	/* -- King. */
+	lanes_count(counts, lanes_andnot(lanes_andnot(lanes_king_attacks(king), us), threats), 1);
+
+	lanes_store(results->threats, threats);
+	lanes_store(results->checkers, checkers);
+	Bitboard us_bbs[BOARD_BATCH_SIZE];
+	Bitboard them_bbs[BOARD_BATCH_SIZE];
+	lanes_store(us_bbs, us);
+	lanes_store(them_bbs, them);
+	for (size_t i = 0; i < batch->count; i++) {
+		struct BatchLane lane = {
+			.side_to_move = batch->side_to_move[i],
+			.us = us_bbs[i],
+			.them = them_bbs[i],
+			.pawns = batch->bb[PIECE_TYPE_PAWN][i],
+			.knights = batch->bb[PIECE_TYPE_KNIGHT][i],
+			.bishops = batch->bb[PIECE_TYPE_BISHOP][i],
+			.rooks = batch->bb[PIECE_TYPE_ROOK][i],
+			.kings = batch->bb[PIECE_TYPE_KING][i],
+			.threats = results->threats[i],
+			.checkers = results->checkers[i],
+		};
+		results->legal_moves_count[i] = counts[i] +
+		                                batch_lane_en_passant_moves_count(&lane, batch->en_passant[i]) +
+		                                batch_lane_castling_moves_count(&lane, batch->castling_rights[i]);
+	}
+	for (size_t i = batch->count; i < BOARD_BATCH_SIZE; i++) {
+		results->legal_moves_count[i] = 0;
+	}
+}
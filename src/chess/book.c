@@ -0,0 +1,221 @@
+/* SPDX-License-Identifier: GPL-3.0-only */
+
+#include "chess/book.h"
+#include "chess/coordinates.h"
+#include "chess/movegen.h"
+#include "chess/pieces.h"
+#include "chess/zobrist.h"
+#include "utils.h"
+#include <assert.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct Book
+{
+	/* Big-endian entries, sorted by key. */
+	const uint8_t *data;
+	size_t entries_count;
+};
+
+struct BookEntry
+{
+	uint64_t key;
+	uint16_t move;
+	uint16_t weight;
+};
+
+struct Book *
+book_open(const char *path)
+{
+	assert(path);
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return NULL;
+	}
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size == 0 || info.st_size % BOOK_ENTRY_SIZE != 0) {
+		close(fd);
+		return NULL;
+	}
+	void *data = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		return NULL;
+	}
+	struct Book *book = exit_if_null(malloc(sizeof(struct Book)));
+	book->data = data;
+	book->entries_count = info.st_size / BOOK_ENTRY_SIZE;
+	return book;
+}
+
+void
+book_close(struct Book *book)
+{
+	if (!book) {
+		return;
+	}
+	munmap((void *)book->data, book->entries_count * BOOK_ENTRY_SIZE);
+	free(book);
+}
+
+static uint64_t
+read_big_endian(const uint8_t *bytes, size_t count)
+{
+	uint64_t value = 0;
+	for (size_t i = 0; i < count; i++) {
+		value = (value << 8) | bytes[i];
+	}
+	return value;
+}
+
+static uint64_t
+book_key_at(const struct Book *book, size_t i)
+{
+	return read_big_endian(book->data + i * BOOK_ENTRY_SIZE, 8);
+}
+
+static struct BookEntry
+book_entry_at(const struct Book *book, size_t i)
+{
+	const uint8_t *bytes = book->data + i * BOOK_ENTRY_SIZE;
+	return (struct BookEntry){
+		.key = read_big_endian(bytes, 8),
+		.move = read_big_endian(bytes + 8, 2),
+		.weight = read_big_endian(bytes + 10, 2),
+	};
+}
+
+uint64_t
+position_polyglot_key(const struct Board *pos)
+{
+	uint64_t key = pos->hash;
+	if (pos->en_passant_target == SQUARE_NONE) {
+		return key;
+	}
+	// The pawn that was just pushed sits in front of the en passant target.
+	Square pushed = pos->side_to_move == COLOR_WHITE ? pos->en_passant_target - 1
+	                                                 : pos->en_passant_target + 1;
+	uint8_t capturer = PIECE_CODE(PIECE_TYPE_PAWN, pos->side_to_move);
+	File file = square_file(pushed);
+	bool can_capture = (file > 0 && pos->squares[pushed - RANKS_COUNT] == capturer) ||
+	                   (file < FILES_COUNT - 1 && pos->squares[pushed + RANKS_COUNT] == capturer);
+	return can_capture ? key : key ^ zobrist_en_passant(pos->en_passant_target);
+}
+
+/* Polyglot moves are "to file, to row, from file, from row, promotion", three
+ * bits each from the lowest. Castling is encoded as the king capturing its own
+ * rook. */
+static struct Move
+book_move_decode(uint16_t move, const struct Board *pos)
+{
+	static const enum PieceType PROMOTIONS[8] = {
+		PIECE_TYPE_NONE, PIECE_TYPE_KNIGHT, PIECE_TYPE_BISHOP, PIECE_TYPE_ROOK, PIECE_TYPE_QUEEN,
+	};
+	struct Move mv = MOVE_IDENTITY;
+	mv.target = square_new(move & 7, (move >> 3) & 7);
+	mv.source = square_new((move >> 6) & 7, (move >> 9) & 7);
+	mv.promotion = PROMOTIONS[(move >> 12) & 7];
+	bool is_king = PIECE_CODE_TYPE(pos->squares[mv.source]) == PIECE_TYPE_KING;
+	bool is_own_rook = pos->squares[mv.target] ==
+	                   PIECE_CODE(PIECE_TYPE_ROOK, PIECE_CODE_COLOR(pos->squares[mv.source]));
+	if (is_king && is_own_rook && square_file(mv.source) == 4) {
+		File file = square_file(mv.target) == FILES_COUNT - 1 ? 6 : 2;
+		mv.target = square_new(file, square_rank(mv.source));
+	}
+	return mv;
+}
+
+uint16_t
+book_move_encode(const struct Move *mv)
+{
+	static const uint16_t PROMOTIONS[16] = {
+		[PIECE_TYPE_KNIGHT] = 1,
+		[PIECE_TYPE_BISHOP] = 2,
+		[PIECE_TYPE_ROOK] = 3,
+		[PIECE_TYPE_QUEEN] = 4,
+	};
+	Square target = mv->target;
+	if (mv->castling) {
+		File file = square_file(target) == 6 ? FILES_COUNT - 1 : 0;
+		target = square_new(file, square_rank(target));
+	}
+	return square_file(target) | square_rank(target) << 3 | square_file(mv->source) << 6 |
+	       square_rank(mv->source) << 9 | PROMOTIONS[mv->promotion & 0xf] << 12;
+}
+
+/* Book moves might be illegal, e.g. because of hash collisions or corrupt
+ * books; legal ones get the missing details filled in by move generation. */
+static bool
+book_move_find_legal(struct Move *mv, const struct Board *pos)
+{
+	struct Move moves[MAX_MOVES];
+	size_t count = gen_legal_moves(moves, (struct Board *)pos);
+	for (size_t i = 0; i < count; i++) {
+		if (moves_eq(moves + i, mv) && moves[i].promotion == mv->promotion) {
+			*mv = moves[i];
+			return true;
+		}
+	}
+	return false;
+}
+
+bool
+book_probe(const struct Book *book,
+           const struct Board *pos,
+           bool best_only,
+           uint64_t random,
+           struct Move *mv)
+{
+	assert(book);
+	uint64_t key = position_polyglot_key(pos);
+	// Lower bound of `key`.
+	size_t first = 0;
+	size_t last = book->entries_count;
+	while (first < last) {
+		size_t middle = first + (last - first) / 2;
+		if (book_key_at(book, middle) < key) {
+			first = middle + 1;
+		} else {
+			last = middle;
+		}
+	}
+	struct Move candidates[MAX_MOVES];
+	uint32_t weights[MAX_MOVES];
+	size_t count = 0;
+	uint64_t total_weight = 0;
+	for (size_t i = first; i < book->entries_count && count < MAX_MOVES; i++) {
+		struct BookEntry entry = book_entry_at(book, i);
+		if (entry.key != key) {
+			break;
+		}
+		candidates[count] = book_move_decode(entry.move, pos);
+		if (!book_move_find_legal(candidates + count, pos)) {
+			continue;
+		}
+		// Zero weights are legal, but they shouldn't make a move unplayable
+		// if it's the only one.
+		weights[count] = entry.weight ? entry.weight : 1;
+		total_weight += weights[count++];
+	}
+	if (count == 0) {
+		return false;
+	}
+	size_t chosen = 0;
+	if (best_only) {
+		for (size_t i = 1; i < count; i++) {
+			if (weights[i] > weights[chosen]) {
+				chosen = i;
+			}
+		}
+	} else {
+		uint64_t r = random % total_weight;
+		while (r >= weights[chosen]) {
+			r -= weights[chosen++];
+		}
+	}
+	*mv = candidates[chosen];
+	return true;
+}
@@ -55,16 +55,16 @@ fen_from_position(char *fen, const struct Board *position, char sep)
 	*fen++ = sep;
 	*fen++ = color_to_char(position->side_to_move);
 	*fen++ = sep;
-	if (position->castling_rights & (CASTLING_RIGHT_KINGSIDE << COLOR_WHITE)) {
+	if (position->castling_rights & (CASTLING_RIGHT(CASTLING_RIGHT_KINGSIDE, COLOR_WHITE))) {
 		*fen++ = 'K';
 	}
-	if (position->castling_rights & (CASTLING_RIGHT_QUEENSIDE << COLOR_WHITE)) {
+	if (position->castling_rights & (CASTLING_RIGHT(CASTLING_RIGHT_QUEENSIDE, COLOR_WHITE))) {
 		*fen++ = 'Q';
 	}
-	if (position->castling_rights & (CASTLING_RIGHT_KINGSIDE << COLOR_BLACK)) {
+	if (position->castling_rights & (CASTLING_RIGHT(CASTLING_RIGHT_KINGSIDE, COLOR_BLACK))) {
 		*fen++ = 'k';
 	}
-	if (position->castling_rights & (CASTLING_RIGHT_QUEENSIDE << COLOR_BLACK)) {
+	if (position->castling_rights & (CASTLING_RIGHT(CASTLING_RIGHT_QUEENSIDE, COLOR_BLACK))) {
 		*fen++ = 'q';
 	}
 	if (*(fen - 1) == sep) {
@@ -78,8 +78,7 @@ fen_from_position(char *fen, const struct Board *position, char sep)
 		*fen++ = rank_to_char(square_rank(position->en_passant_target));
 	}
 	*fen++ = sep;
-	snprintf(
-	  fen, 13, "%zu%c%zu", position->reversible_moves_count, sep, position->moves_count);
+	snprintf(fen, 13, "%d%c%d", position->reversible_moves_count, sep, position->moves_count);
 	return fen_copy;
 }
 
@@ -121,7 +120,7 @@ position_init_side_to_move(struct Board *pos, const char *token)
 int
 position_init_en_passant(struct Board *pos, const char *token)
 {
-	if (token && strlen(token) >= 2) {
+	if (token && *token != '-' && strlen(token) >= 2) {
 		pos->en_passant_target = square_from_str(token);
 	}
 }
@@ -130,7 +129,8 @@ int
 position_init_rev_moves_count(struct Board *pos, const char *token)
 {
 	if (token) {
-		pos->reversible_moves_count = strtol(token, NULL, 10);
+		long count = strtol(token, NULL, 10);
+		pos->reversible_moves_count = count < 0 ? 0 : count > UINT8_MAX ? UINT8_MAX : count;
 	}
 }
 
@@ -152,6 +152,8 @@ position_init_from_fen_fields(struct Board *pos, const char **fieldsptr)
 	position_init_en_passant(pos, fieldsptr[3]);
 	position_init_rev_moves_count(pos, fieldsptr[4]);
 	position_init_total_moves_count(pos, fieldsptr[5]);
+	pos->hash = position_zobrist(pos);
+	pos->pawn_hash = position_pawn_zobrist(pos);
 	return ERR_CODE_NONE;
 }
 
@@ -170,3 +172,33 @@ position_init_from_fen(struct Board *pos, const char *fen)
 	}
 	return position_init_from_fen_fields(pos, fieldsptr);
 }
+
+int
+position_init_from_epd(struct Board *pos, char *line, char **operations)
+{
+	assert(pos);
+	assert(line);
+	char *save = NULL;
+	const char *fields[6] = { NULL };
+	for (size_t i = 0; i < 4; i++) {
+		fields[i] = strtok_r_whitespace(i ? NULL : line, &save);
+		if (!fields[i]) {
+			return ERR_CODE_INVALID_FEN;
+		}
+	}
+	char *rest = save ? save : "";
+	for (size_t i = 4; i < 6; i++) {
+		rest += strspn(rest, WHITESPACE);
+		size_t length = strcspn(rest, WHITESPACE);
+		if (length == 0 || strspn(rest, "0123456789") != length) {
+			break;
+		}
+		fields[i] = rest;
+		rest += length;
+		if (*rest) {
+			*rest++ = '\0';
+		}
+	}
+	*operations = rest;
+	return position_init_from_fen_fields(pos, fields);
+}
@@ -4,259 +4,323 @@
 
 const struct Magic MAGICS_BISHOP[SQUARES_COUNT] = {
 	[00] = { .premask = 0x40201008040200ULL,
-	         .multiplier = 0x8040040112020030ULL,
+	         .multiplier = 0x182484408c100600ULL,
 	         .rshift = 58,
-	         .postmask = 0xffffffffffffffffULL },
+	         .postmask = 0xffffffffffffffffULL,
+	         .black = true },
 	[01] = { .premask = 0x402010080400ULL,
-	         .multiplier = 0x104100082149084ULL,
+	         .multiplier = 0x1004875800500800ULL,
 	         .rshift = 59,
-	         .postmask = 0xffffffffffffffffULL },
+	         .postmask = 0xffffffffffffffffULL,
+	         .black = true },
 	[02] = { .premask = 0x4020100a00ULL,
-	         .multiplier = 0x84045400410100ULL,
+	         .multiplier = 0xab000c200100000ULL,
 	         .rshift = 59,
-	         .postmask = 0xffffffffffffffffULL },
+	         .postmask = 0xffffffffffffffffULL,
+	         .black = true },
 	[03] = { .premask = 0x40221400ULL,
-	         .multiplier = 0x2218200400000ULL,
+	         .multiplier = 0xc8044020800a0011ULL,
 	         .rshift = 59,
-	         .postmask = 0xffffffffffffffffULL },
+	         .postmask = 0xffffffffffffffffULL,
+	         .black = true },
 	[04] = { .premask = 0x2442800ULL,
-	         .multiplier = 0x20e1020224804ULL,
+	         .multiplier = 0x921860180000400ULL,
 	         .rshift = 59,
-	         .postmask = 0xffffffffffffffffULL },
+	         .postmask = 0xffffffffffffffffULL,
+	         .black = true },
 	[05] = { .premask = 0x204085000ULL,
-	         .multiplier = 0x2c901048108000ULL,
+	         .multiplier = 0x2800a280b0102012ULL,
 	         .rshift = 59,
-	         .postmask = 0xffffffffffffffffULL },
+	         .postmask = 0xffffffffffffffffULL,
+	         .black = true },
 	[06] = { .premask = 0x20408102000ULL,
-	         .multiplier = 0x4002010918402200ULL,
+	         .multiplier = 0x2888410461000600ULL,
 	         .rshift = 59,
-	         .postmask = 0xffffffffffffffffULL },
+	         .postmask = 0xffffffffffffffffULL,
+	         .black = true },
 	[07] = { .premask = 0x2040810204000ULL,
-	         .multiplier = 0x20a1008043084000ULL,
+	         .multiplier = 0x202821c100e00020ULL,
 	         .rshift = 58,
-	         .postmask = 0xffffffffffffffffULL },
+	         .postmask = 0xffffffffffffffffULL,
+	         .black = true },
 	[010] = { .premask = 0x20100804020000ULL,
-	          .multiplier = 0x40402802108210ULL,
+	          .multiplier = 0x100190a210902200ULL,
 	          .rshift = 59,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[011] = { .premask = 0x40201008040000ULL,
-	          .multiplier = 0x88012800a105ULL,
+	          .multiplier = 0x30b2889001006402ULL,
 	          .rshift = 59,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[012] = { .premask = 0x4020100a0000ULL,
-	          .multiplier = 0x8001880601420500ULL,
+	          .multiplier = 0x8143002c0230080ULL,
 	          .rshift = 59,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[013] = { .premask = 0x4022140000ULL,
-	          .multiplier = 0x8818920a02000400ULL,
+	          .multiplier = 0x8001222050108000ULL,
 	          .rshift = 59,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[014] = { .premask = 0x244280000ULL,
-	          .multiplier = 0x100e0210141081ULL,
+	          .multiplier = 0x2892044302120000ULL,
 	          .rshift = 59,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[015] = { .premask = 0x20408500000ULL,
-	          .multiplier = 0x3800009010080008ULL,
+	          .multiplier = 0x200020c262011008ULL,
 	          .rshift = 59,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[016] = { .premask = 0x2040810200000ULL,
-	          .multiplier = 0x8404004808080802ULL,
+	          .multiplier = 0x40a001510b030040ULL,
 	          .rshift = 59,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[017] = { .premask = 0x4081020400000ULL,
-	          .multiplier = 0xc000110082100241ULL,
+	          .multiplier = 0x2000002c091500c0ULL,
 	          .rshift = 59,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[020] = { .premask = 0x10080402000200ULL,
-	          .multiplier = 0x80410220c040800ULL,
+	          .multiplier = 0x2040621012018060ULL,
 	          .rshift = 59,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[021] = { .premask = 0x20100804000400ULL,
-	          .multiplier = 0x8020200a04140080ULL,
+	          .multiplier = 0x1004128908229810ULL,
 	          .rshift = 59,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[022] = { .premask = 0x4020100a000a00ULL,
-	          .multiplier = 0x24100204001200ULL,
+	          .multiplier = 0x388041000282406ULL,
 	          .rshift = 57,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[023] = { .premask = 0x402214001400ULL,
-	          .multiplier = 0x200800040210204cULL,
+	          .multiplier = 0x160080080208c020ULL,
 	          .rshift = 57,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[024] = { .premask = 0x24428002800ULL,
-	          .multiplier = 0x3000190400100ULL,
+	          .multiplier = 0x304000484600043ULL,
 	          .rshift = 57,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[025] = { .premask = 0x2040850005000ULL,
-	          .multiplier = 0x200d001202510400ULL,
+	          .multiplier = 0x1001201008250ULL,
 	          .rshift = 57,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = false },
 	[026] = { .premask = 0x4081020002000ULL,
-	          .multiplier = 0x801041240c020818ULL,
+	          .multiplier = 0x10420104580280a0ULL,
 	          .rshift = 59,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[027] = { .premask = 0x8102040004000ULL,
-	          .multiplier = 0xa000022020280ULL,
+	          .multiplier = 0x501521424c00a080ULL,
 	          .rshift = 59,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[030] = { .premask = 0x8040200020400ULL,
-	          .multiplier = 0x2482209841480a00ULL,
+	          .multiplier = 0x80a2000452080a0ULL,
 	          .rshift = 59,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[031] = { .premask = 0x10080400040800ULL,
-	          .multiplier = 0x2004040012107408ULL,
+	          .multiplier = 0x2200828022080200ULL,
 	          .rshift = 59,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[032] = { .premask = 0x20100a000a1000ULL,
-	          .multiplier = 0x1521044490004200ULL,
+	          .multiplier = 0x2a0190000a002200ULL,
 	          .rshift = 57,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[033] = { .premask = 0x40221400142200ULL,
-	          .multiplier = 0x740040000410060ULL,
+	          .multiplier = 0x4004040300401080ULL,
 	          .rshift = 55,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = false },
 	[034] = { .premask = 0x2442800284400ULL,
-	          .multiplier = 0x4084086024002000ULL,
+	          .multiplier = 0x18840000802000ULL,
 	          .rshift = 55,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[035] = { .premask = 0x4085000500800ULL,
-	          .multiplier = 0x50088021080128ULL,
+	          .multiplier = 0x250008024380040ULL,
 	          .rshift = 57,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[036] = { .premask = 0x8102000201000ULL,
-	          .multiplier = 0x404c20011011002ULL,
+	          .multiplier = 0x1802019024041100ULL,
 	          .rshift = 59,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[037] = { .premask = 0x10204000402000ULL,
-	          .multiplier = 0x480800200c400ULL,
+	          .multiplier = 0x264401021827204cULL,
 	          .rshift = 59,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[040] = { .premask = 0x4020002040800ULL,
-	          .multiplier = 0x12202000042800ULL,
+	          .multiplier = 0x182010109a0280ULL,
 	          .rshift = 59,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = false },
 	[041] = { .premask = 0x8040004081000ULL,
-	          .multiplier = 0x7080201081094ULL,
+	          .multiplier = 0x80041a000500301ULL,
 	          .rshift = 59,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[042] = { .premask = 0x100a000a102000ULL,
-	          .multiplier = 0x201004800010800ULL,
+	          .multiplier = 0x320010302c080180ULL,
 	          .rshift = 57,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[043] = { .premask = 0x22140014224000ULL,
-	          .multiplier = 0xc0110800840040ULL,
+	          .multiplier = 0x4001068080880200ULL,
 	          .rshift = 55,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[044] = { .premask = 0x44280028440200ULL,
-	          .multiplier = 0x804150011040040ULL,
+	          .multiplier = 0x100420400020108ULL,
 	          .rshift = 55,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = false },
 	[045] = { .premask = 0x8500050080400ULL,
-	          .multiplier = 0x1092101000a0054ULL,
+	          .multiplier = 0x7000900101048080ULL,
 	          .rshift = 57,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[046] = { .premask = 0x10200020100800ULL,
-	          .multiplier = 0x220802010320a4ULL,
+	          .multiplier = 0x800840160210800ULL,
 	          .rshift = 59,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[047] = { .premask = 0x20400040201000ULL,
-	          .multiplier = 0x8102214200010088ULL,
+	          .multiplier = 0x878002530490904ULL,
 	          .rshift = 59,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[050] = { .premask = 0x2000204081000ULL,
-	          .multiplier = 0x100890101888100bULL,
+	          .multiplier = 0x8401b0321044038ULL,
 	          .rshift = 59,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[051] = { .premask = 0x4000408102000ULL,
-	          .multiplier = 0x484010108101040ULL,
+	          .multiplier = 0x2908016108205e00ULL,
 	          .rshift = 59,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[052] = { .premask = 0xa000a10204000ULL,
-	          .multiplier = 0x46010841020800ULL,
+	          .multiplier = 0x240040038001400ULL,
 	          .rshift = 57,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[053] = { .premask = 0x14001422400000ULL,
-	          .multiplier = 0x5008106028003420ULL,
+	          .multiplier = 0x230400418000400ULL,
 	          .rshift = 57,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[054] = { .premask = 0x28002844020000ULL,
-	          .multiplier = 0x82884100402c06ULL,
+	          .multiplier = 0x8041208410100100ULL,
 	          .rshift = 57,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = false },
 	[055] = { .premask = 0x50005008040200ULL,
-	          .multiplier = 0x4804028481000202ULL,
+	          .multiplier = 0x2c80601250800100ULL,
 	          .rshift = 57,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[056] = { .premask = 0x20002010080400ULL,
-	          .multiplier = 0x1606220404000100ULL,
+	          .multiplier = 0x2000449920422400ULL,
 	          .rshift = 59,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[057] = { .premask = 0x40004020100800ULL,
-	          .multiplier = 0x408010322000020ULL,
+	          .multiplier = 0x1000880058430120ULL,
 	          .rshift = 59,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[060] = { .premask = 0x20408102000ULL,
-	          .multiplier = 0x40868420200000ULL,
+	          .multiplier = 0xc0000201e2084102ULL,
 	          .rshift = 59,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[061] = { .premask = 0x40810204000ULL,
-	          .multiplier = 0xa02008088080400ULL,
+	          .multiplier = 0x288040219008a002ULL,
 	          .rshift = 59,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[062] = { .premask = 0xa1020400000ULL,
-	          .multiplier = 0x20048c208906000ULL,
+	          .multiplier = 0x1000010010d0280bULL,
 	          .rshift = 59,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[063] = { .premask = 0x142240000000ULL,
-	          .multiplier = 0x400040a20880400ULL,
+	          .multiplier = 0x10480400c01a4c04ULL,
 	          .rshift = 59,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[064] = { .premask = 0x284402000000ULL,
-	          .multiplier = 0x423041102020000ULL,
+	          .multiplier = 0x900c40203040012ULL,
 	          .rshift = 59,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[065] = { .premask = 0x500804020000ULL,
-	          .multiplier = 0xb0a01410288000ULL,
+	          .multiplier = 0x104001902c00c010ULL,
 	          .rshift = 59,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[066] = { .premask = 0x201008040200ULL,
-	          .multiplier = 0x1220820401040030ULL,
+	          .multiplier = 0xa000882518608008ULL,
 	          .rshift = 59,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[067] = { .premask = 0x402010080400ULL,
-	          .multiplier = 0x30020204520004ULL,
+	          .multiplier = 0x4040224440488038ULL,
 	          .rshift = 59,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[070] = { .premask = 0x2040810204000ULL,
-	          .multiplier = 0x8000820110020690ULL,
+	          .multiplier = 0x400e040089088240ULL,
 	          .rshift = 58,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[071] = { .premask = 0x4081020400000ULL,
-	          .multiplier = 0x81020104410404ULL,
+	          .multiplier = 0x4002400982088240ULL,
 	          .rshift = 59,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[072] = { .premask = 0xa102040000000ULL,
-	          .multiplier = 0x8090000126011000ULL,
+	          .multiplier = 0x840000014641000ULL,
 	          .rshift = 59,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[073] = { .premask = 0x14224000000000ULL,
-	          .multiplier = 0x400109104880aULL,
+	          .multiplier = 0x6810810480208804ULL,
 	          .rshift = 59,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = false },
 	[074] = { .premask = 0x28440200000000ULL,
-	          .multiplier = 0x4010080108102400ULL,
+	          .multiplier = 0x20208300400106c0ULL,
 	          .rshift = 59,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[075] = { .premask = 0x50080402000000ULL,
-	          .multiplier = 0x2400602020421080ULL,
+	          .multiplier = 0x20300008008441c1ULL,
 	          .rshift = 59,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[076] = { .premask = 0x20100804020000ULL,
-	          .multiplier = 0x2400081090020854ULL,
+	          .multiplier = 0x4112002401114211ULL,
 	          .rshift = 59,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[077] = { .premask = 0x40201008040200ULL,
-	          .multiplier = 0x414d81088008100ULL,
+	          .multiplier = 0x201040c808806018ULL,
 	          .rshift = 58,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 };
@@ -4,259 +4,323 @@
 
 const struct Magic MAGICS_ROOK[SQUARES_COUNT] = {
 	[00] = { .premask = 0x101010101017eULL,
-	         .multiplier = 0x4880053040002280ULL,
+	         .multiplier = 0x4080002040008018ULL,
 	         .rshift = 52,
-	         .postmask = 0xffffffffffffffffULL },
+	         .postmask = 0xffffffffffffffffULL,
+	         .black = true },
 	[01] = { .premask = 0x202020202027cULL,
-	         .multiplier = 0x40022000100840ULL,
+	         .multiplier = 0x40100140012000ULL,
 	         .rshift = 53,
-	         .postmask = 0xffffffffffffffffULL },
+	         .postmask = 0xffffffffffffffffULL,
+	         .black = true },
 	[02] = { .premask = 0x404040404047aULL,
-	         .multiplier = 0xcb00104020010900ULL,
+	         .multiplier = 0x80300020018018ULL,
 	         .rshift = 53,
-	         .postmask = 0xffffffffffffffffULL },
+	         .postmask = 0xffffffffffffffffULL,
+	         .black = true },
 	[03] = { .premask = 0x8080808080876ULL,
-	         .multiplier = 0x801000800c0800ULL,
+	         .multiplier = 0x100100100214408ULL,
 	         .rshift = 53,
-	         .postmask = 0xffffffffffffffffULL },
+	         .postmask = 0xffffffffffffffffULL,
+	         .black = true },
 	[04] = { .premask = 0x1010101010106eULL,
-	         .multiplier = 0x200090200041020ULL,
+	         .multiplier = 0x1200100408202a00ULL,
 	         .rshift = 53,
-	         .postmask = 0xffffffffffffffffULL },
+	         .postmask = 0xffffffffffffffffULL,
+	         .black = true },
 	[05] = { .premask = 0x2020202020205eULL,
-	         .multiplier = 0x100080604000100ULL,
+	         .multiplier = 0x600014c08900200ULL,
 	         .rshift = 53,
-	         .postmask = 0xffffffffffffffffULL },
+	         .postmask = 0xffffffffffffffffULL,
+	         .black = true },
 	[06] = { .premask = 0x4040404040403eULL,
-	         .multiplier = 0x4000110080c8402ULL,
+	         .multiplier = 0x60008020000c421ULL,
 	         .rshift = 53,
-	         .postmask = 0xffffffffffffffffULL },
+	         .postmask = 0xffffffffffffffffULL,
+	         .black = true },
 	[07] = { .premask = 0x8080808080807eULL,
-	         .multiplier = 0x2080002080004500ULL,
+	         .multiplier = 0x480008000205100ULL,
 	         .rshift = 52,
-	         .postmask = 0xffffffffffffffffULL },
+	         .postmask = 0xffffffffffffffffULL,
+	         .black = true },
 	[010] = { .premask = 0x1010101017e00ULL,
-	          .multiplier = 0x8002800040002380ULL,
+	          .multiplier = 0x8068200222100004ULL,
 	          .rshift = 53,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[011] = { .premask = 0x2020202027c00ULL,
-	          .multiplier = 0x243004006802102ULL,
+	          .multiplier = 0x1401000200440ULL,
 	          .rshift = 54,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[012] = { .premask = 0x4040404047a00ULL,
-	          .multiplier = 0x6002200308141ULL,
+	          .multiplier = 0x802002801000ULL,
 	          .rshift = 54,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[013] = { .premask = 0x8080808087600ULL,
-	          .multiplier = 0xc1803000800802ULL,
+	          .multiplier = 0xc688800800803000ULL,
 	          .rshift = 54,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[014] = { .premask = 0x10101010106e00ULL,
-	          .multiplier = 0x641000800308502ULL,
+	          .multiplier = 0x901800400802800ULL,
 	          .rshift = 54,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[015] = { .premask = 0x20202020205e00ULL,
-	          .multiplier = 0x85800400060180ULL,
+	          .multiplier = 0x2000894020050ULL,
 	          .rshift = 54,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[016] = { .premask = 0x40404040403e00ULL,
-	          .multiplier = 0x108200142b120028ULL,
+	          .multiplier = 0xa004003524100802ULL,
 	          .rshift = 54,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[017] = { .premask = 0x80808080807e00ULL,
-	          .multiplier = 0x801100004080ULL,
+	          .multiplier = 0x8090800841000880ULL,
 	          .rshift = 53,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[020] = { .premask = 0x10101017e0100ULL,
-	          .multiplier = 0x140018000254086ULL,
+	          .multiplier = 0x20828001204000ULL,
 	          .rshift = 53,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[021] = { .premask = 0x20202027c0200ULL,
-	          .multiplier = 0x60004003c03000ULL,
+	          .multiplier = 0x40108020004280ULL,
 	          .rshift = 54,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[022] = { .premask = 0x40404047a0400ULL,
-	          .multiplier = 0x2010002000a80400ULL,
+	          .multiplier = 0x2201010010200140ULL,
 	          .rshift = 54,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[023] = { .premask = 0x8080808760800ULL,
-	          .multiplier = 0x4490021021000ULL,
+	          .multiplier = 0x90021001002ULL,
 	          .rshift = 54,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = false },
 	[024] = { .premask = 0x101010106e1000ULL,
-	          .multiplier = 0x18202001420b810ULL,
+	          .multiplier = 0x2008008004004a80ULL,
 	          .rshift = 54,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[025] = { .premask = 0x202020205e2000ULL,
-	          .multiplier = 0x4e0c0080140e0080ULL,
+	          .multiplier = 0x244004002010040ULL,
 	          .rshift = 54,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = false },
 	[026] = { .premask = 0x404040403e4000ULL,
-	          .multiplier = 0x3040440010010812ULL,
+	          .multiplier = 0x2200040010080221ULL,
 	          .rshift = 54,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[027] = { .premask = 0x808080807e8000ULL,
-	          .multiplier = 0x890006000410c0a3ULL,
+	          .multiplier = 0x42001881410cULL,
 	          .rshift = 53,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[030] = { .premask = 0x101017e010100ULL,
-	          .multiplier = 0x2008400280008020ULL,
+	          .multiplier = 0x100081a080004001ULL,
 	          .rshift = 53,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[031] = { .premask = 0x202027c020200ULL,
-	          .multiplier = 0x920500040002008ULL,
+	          .multiplier = 0x40100060080024ULL,
 	          .rshift = 54,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[032] = { .premask = 0x404047a040400ULL,
-	          .multiplier = 0x210401600208201ULL,
+	          .multiplier = 0x900080200480ULL,
 	          .rshift = 54,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[033] = { .premask = 0x8080876080800ULL,
-	          .multiplier = 0x4210a042001a0010ULL,
+	          .multiplier = 0x480080100480ULL,
 	          .rshift = 54,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[034] = { .premask = 0x1010106e101000ULL,
-	          .multiplier = 0x204008080180024ULL,
+	          .multiplier = 0xc88040080080080ULL,
 	          .rshift = 54,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[035] = { .premask = 0x2020205e202000ULL,
-	          .multiplier = 0x4400800a0080ULL,
+	          .multiplier = 0x5400040080800200ULL,
 	          .rshift = 54,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = false },
 	[036] = { .premask = 0x4040403e404000ULL,
-	          .multiplier = 0x8090882400021011ULL,
+	          .multiplier = 0x300080400100201ULL,
 	          .rshift = 54,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[037] = { .premask = 0x8080807e808000ULL,
-	          .multiplier = 0x8a00051054ULL,
+	          .multiplier = 0x8001800080006300ULL,
 	          .rshift = 53,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[040] = { .premask = 0x1017e01010100ULL,
-	          .multiplier = 0x4040088228800540ULL,
+	          .multiplier = 0x230400411800080ULL,
 	          .rshift = 53,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[041] = { .premask = 0x2027c02020200ULL,
-	          .multiplier = 0xa00040401000ULL,
+	          .multiplier = 0x406004401000ULL,
 	          .rshift = 54,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[042] = { .premask = 0x4047a04040400ULL,
-	          .multiplier = 0x422084a000801000ULL,
+	          .multiplier = 0xc002284082001201ULL,
 	          .rshift = 54,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = false },
 	[043] = { .premask = 0x8087608080800ULL,
-	          .multiplier = 0x6000828801801000ULL,
+	          .multiplier = 0x2104420012000860ULL,
 	          .rshift = 54,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[044] = { .premask = 0x10106e10101000ULL,
-	          .multiplier = 0xc000080080800400ULL,
+	          .multiplier = 0x2000800401800800ULL,
 	          .rshift = 54,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[045] = { .premask = 0x20205e20202000ULL,
-	          .multiplier = 0x401200100a000409ULL,
+	          .multiplier = 0x4400620080800400ULL,
 	          .rshift = 54,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[046] = { .premask = 0x40403e40404000ULL,
-	          .multiplier = 0x400800100800200ULL,
+	          .multiplier = 0x20804008130ULL,
 	          .rshift = 54,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = false },
 	[047] = { .premask = 0x80807e80808000ULL,
-	          .multiplier = 0x800038c1a001841ULL,
+	          .multiplier = 0x4044140082002841ULL,
 	          .rshift = 53,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = false },
 	[050] = { .premask = 0x17e0101010100ULL,
-	          .multiplier = 0x184204000808000ULL,
+	          .multiplier = 0x2000c00080238000ULL,
 	          .rshift = 53,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[051] = { .premask = 0x27c0202020200ULL,
-	          .multiplier = 0x2460100240204000ULL,
+	          .multiplier = 0x2820011002404000ULL,
 	          .rshift = 54,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[052] = { .premask = 0x47a0404040400ULL,
-	          .multiplier = 0x48801200420060ULL,
+	          .multiplier = 0x1002004088620010ULL,
 	          .rshift = 54,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[053] = { .premask = 0x8760808080800ULL,
-	          .multiplier = 0x11010010021000aULL,
+	          .multiplier = 0x10300100200b0008ULL,
 	          .rshift = 54,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[054] = { .premask = 0x106e1010101000ULL,
-	          .multiplier = 0x8010050008010010ULL,
+	          .multiplier = 0x24040008008080ULL,
 	          .rshift = 54,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = false },
 	[055] = { .premask = 0x205e2020202000ULL,
-	          .multiplier = 0x1000060004008080ULL,
+	          .multiplier = 0x7c0020004008080ULL,
 	          .rshift = 54,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[056] = { .premask = 0x403e4040404000ULL,
-	          .multiplier = 0xa00013c020008ULL,
+	          .multiplier = 0x10289001040022ULL,
 	          .rshift = 54,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = false },
 	[057] = { .premask = 0x807e8080808000ULL,
-	          .multiplier = 0x9100460004ULL,
+	          .multiplier = 0x13100844a0004ULL,
 	          .rshift = 53,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[060] = { .premask = 0x7e010101010100ULL,
-	          .multiplier = 0x20021c004800880ULL,
+	          .multiplier = 0x1123001082013600ULL,
 	          .rshift = 53,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[061] = { .premask = 0x7c020202020200ULL,
-	          .multiplier = 0x105010a000400840ULL,
+	          .multiplier = 0x1002400287082100ULL,
 	          .rshift = 54,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[062] = { .premask = 0x7a040404040400ULL,
-	          .multiplier = 0x1104402001b10300ULL,
+	          .multiplier = 0x88812001d00080ULL,
 	          .rshift = 54,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[063] = { .premask = 0x76080808080800ULL,
-	          .multiplier = 0x29100280480280ULL,
+	          .multiplier = 0x310c0021a011200ULL,
 	          .rshift = 54,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[064] = { .premask = 0x6e101010101000ULL,
-	          .multiplier = 0x40080080080ULL,
+	          .multiplier = 0x928448010d001100ULL,
 	          .rshift = 54,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[065] = { .premask = 0x5e202020202000ULL,
-	          .multiplier = 0x20020010088c5200ULL,
+	          .multiplier = 0x2041800200040080ULL,
 	          .rshift = 54,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[066] = { .premask = 0x3e404040404000ULL,
-	          .multiplier = 0x2006000c4d081a00ULL,
+	          .multiplier = 0x3800006a01141080ULL,
 	          .rshift = 54,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[067] = { .premask = 0x7e808080808000ULL,
-	          .multiplier = 0x2140040040810200ULL,
+	          .multiplier = 0x10f0410c0850200ULL,
 	          .rshift = 53,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[070] = { .premask = 0x7e01010101010100ULL,
-	          .multiplier = 0x811208011460102ULL,
+	          .multiplier = 0x41002050800041ULL,
 	          .rshift = 52,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[071] = { .premask = 0x7c02020202020200ULL,
-	          .multiplier = 0x80a020c000850015ULL,
+	          .multiplier = 0x5100087200c82102ULL,
 	          .rshift = 53,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[072] = { .premask = 0x7a04040404040400ULL,
-	          .multiplier = 0x42810088c1a00011ULL,
+	          .multiplier = 0x4020000643001061ULL,
 	          .rshift = 53,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[073] = { .premask = 0x7608080808080800ULL,
-	          .multiplier = 0x40060050c0088422ULL,
+	          .multiplier = 0x108402024b2ULL,
 	          .rshift = 53,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[074] = { .premask = 0x6e10101010101000ULL,
-	          .multiplier = 0x28a00080420500aULL,
+	          .multiplier = 0x4002001004200802ULL,
 	          .rshift = 53,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[075] = { .premask = 0x5e20202020202000ULL,
-	          .multiplier = 0x800a008401081002ULL,
+	          .multiplier = 0xa0820000a4081042ULL,
 	          .rshift = 53,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[076] = { .premask = 0x3e40404040404000ULL,
-	          .multiplier = 0x80c8c11032008804ULL,
+	          .multiplier = 0x4104800120090a4ULL,
 	          .rshift = 53,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 	[077] = { .premask = 0x7e80808080808000ULL,
-	          .multiplier = 0x80008c20440102ULL,
+	          .multiplier = 0x60000824009502ULL,
 	          .rshift = 52,
-	          .postmask = 0xffffffffffffffffULL },
+	          .postmask = 0xffffffffffffffffULL,
+	          .black = true },
 };
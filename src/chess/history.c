@@ -0,0 +1,89 @@
+/* SPDX-License-Identifier: GPL-3.0-only */
+
+#include "chess/history.h"
+#include "utils.h"
+#include <assert.h>
+#include <string.h>
+
+void
+history_init(struct History *history)
+{
+	history->keys = NULL;
+	history->count = 0;
+	history->capacity = 0;
+}
+
+static void
+history_reserve(struct History *history, size_t capacity)
+{
+	if (capacity <= history->capacity) {
+		return;
+	}
+	history->capacity = history->capacity ? history->capacity * 2 : 64;
+	if (history->capacity < capacity) {
+		history->capacity = capacity;
+	}
+	history->keys = exit_if_null(realloc(history->keys, history->capacity * sizeof(uint64_t)));
+}
+
+void
+history_copy(struct History *history, const struct History *other)
+{
+	history_reserve(history, other->count);
+	if (other->count) {
+		memcpy(history->keys, other->keys, other->count * sizeof(uint64_t));
+	}
+	history->count = other->count;
+}
+
+void
+history_delete(struct History *history)
+{
+	free(history->keys);
+	history_init(history);
+}
+
+void
+history_reset(struct History *history, const struct Board *pos)
+{
+	history->count = 0;
+	history_push(history, pos->hash);
+}
+
+void
+history_push(struct History *history, uint64_t key)
+{
+	history_reserve(history, history->count + 1);
+	history->keys[history->count++] = key;
+}
+
+void
+history_pop(struct History *history)
+{
+	assert(history->count > 0);
+	history->count--;
+}
+
+uint64_t
+history_last(const struct History *history)
+{
+	assert(history->count > 0);
+	return history->keys[history->count - 1];
+}
+
+bool
+history_is_repetition(const struct History *history, int reversible_moves_count)
+{
+	if (history->count == 0) {
+		return false;
+	}
+	uint64_t key = history_last(history);
+	// A position can't repeat in less than four plies, and older positions
+	// are unreachable past a capture or a pawn move.
+	for (size_t i = 4; i <= (size_t)reversible_moves_count && i < history->count; i += 2) {
+		if (history->keys[history->count - 1 - i] == key) {
+			return true;
+		}
+	}
+	return false;
+}
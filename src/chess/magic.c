@@ -3,13 +3,10 @@
 #include "chess/magic.h"
 #include "chess/bb.h"
 #include "chess/diagonals.h"
-#include "chess/generated/magics_bishop.h"
-#include "chess/generated/magics_rook.h"
-#include "chess/mnemonics.h"
 #include "chess/threats.h"
 #include "libpopcnt/libpopcnt.h"
-#include "mt-64/mt-64.h"
 #include "utils.h"
+#include <plibsys.h>
 #include <inttypes.h>
 #include <stdbool.h>
 #include <stdio.h>
@@ -27,21 +24,23 @@ magics_export(const struct Magic *magics, const char *identifier, FILE *stream)
 		        " .premask = 0x%" PRIx64 "ULL,"
 		        " .multiplier = 0x%" PRIx64 "ULL,"
 		        " .rshift = %d,"
-		        " .postmask = 0x%" PRIx64 "ULL },\n",
+		        " .postmask = 0x%" PRIx64 "ULL,"
+		        " .black = %s },\n",
 		        sq,
 		        magic.premask,
 		        magic.multiplier,
 		        magic.rshift,
-		        magic.postmask);
+		        magic.postmask,
+		        magic.black ? "true" : "false");
 	}
 	fprintf(stream, "};\n");
 	return 0;
 }
 
 Bitboard
-bb_sparse_random(void)
+bb_sparse_random(uint64_t *prng_state)
 {
-	return genrand64_int64() & genrand64_int64() & genrand64_int64();
+	return prng_next(prng_state) & prng_next(prng_state) & prng_next(prng_state);
 }
 
 Bitboard
@@ -61,64 +60,165 @@ bb_premask_bishop(Square sq)
 	return (diagonal1 ^ diagonal2) & ~borders;
 }
 
-size_t
-find_end_of_attacks_table(Bitboard attacks_table[])
+
+enum
+{
+	MAGIC_MAX_BITS = 12,
+};
+
+/* Everything a thread needs to search the magics of a single square. `table`
+ * is never cleared between candidates: its entries only count if their stamp
+ * is the current one. */
+struct MagicSquareSearch
+{
+	size_t subsets_count;
+	Bitboard subsets[1 << MAGIC_MAX_BITS];
+	Bitboard attacks[1 << MAGIC_MAX_BITS];
+	uint32_t stamp;
+	uint32_t stamps[1 << MAGIC_MAX_BITS];
+	Bitboard table[1 << MAGIC_MAX_BITS];
+};
+
+/* Returns the table size `magic` needs, or 0 if it maps different attacks to
+ * the same index. */
+static size_t
+magic_square_search_try(struct MagicSquareSearch *search, const struct Magic *magic)
 {
-	for (size_t i = 4095; i > 0; i--) {
-		if (attacks_table[i]) {
-			return i;
+	if (++search->stamp == 0) {
+		memset(search->stamps, 0, sizeof(search->stamps));
+		search->stamp = 1;
+	}
+	size_t size = 0;
+	for (size_t i = 0; i < search->subsets_count; i++) {
+		size_t index = magic_index(magic, search->subsets[i]);
+		if (search->stamps[index] != search->stamp) {
+			search->stamps[index] = search->stamp;
+			search->table[index] = search->attacks[i];
+		} else if (search->table[index] != search->attacks[i]) {
+			return 0;
 		}
+		size = index + 1 > size ? index + 1 : size;
 	}
-	return 0;
+	return size;
 }
 
-bool
-verify_magic_candidate(const struct Magic *magic,
-                       Square sq,
-                       Bitboard buffer[],
-                       Bitboard (*attacker)(Square, Bitboard))
+struct MagicsSearch
 {
+	struct Magic *magics;
+	Bitboard (*slider)(Square, Bitboard);
+	Bitboard (*premasker)(Square);
+	size_t attempts_count;
+	uint64_t seed;
+	volatile pint next_sq;
+};
+
+static void
+magics_search_square(const struct MagicsSearch *search,
+                     struct MagicSquareSearch *square_search,
+                     Square sq)
+{
+	Bitboard premask = search->premasker(sq);
+	square_search->subsets_count = 0;
 	Bitboard subset = 0;
 	do {
-		size_t i = (subset * magic->multiplier) >> magic->rshift;
-		Bitboard *val = buffer + i;
-		Bitboard attacks = attacker(sq, subset);
-		if (*val) {
-			return false;
-		} else {
-			*val = attacks;
+		square_search->subsets[square_search->subsets_count] = subset;
+		square_search->attacks[square_search->subsets_count] = search->slider(sq, subset);
+		square_search->subsets_count++;
+	} while ((subset = bb_next_subset(premask, subset)));
+	// Each square has its own generator, so that the results don't depend on
+	// which thread gets which square.
+	uint64_t prng_state = search->seed + sq;
+	struct Magic *best = search->magics + sq;
+	size_t best_size = SIZE_MAX;
+	for (int bits = popcnt64(premask); bits > 0; bits--) {
+		bool found = false;
+		// There must be at least one magic with as many bits as obstacles.
+		for (size_t i = 0; i < search->attempts_count || best_size == SIZE_MAX; i++) {
+			struct Magic candidate = {
+				.premask = premask,
+				.multiplier = bb_sparse_random(&prng_state),
+				.rshift = 64 - bits,
+				.postmask = UINT64_MAX,
+				.black = i % 2,
+			};
+			// White magics are hopeless unless the highest bits are busy.
+			if (!candidate.black && popcnt64((premask * candidate.multiplier) >> 56) < 6) {
+				continue;
+			}
+			size_t size = magic_square_search_try(square_search, &candidate);
+			if (size && size < best_size) {
+				*best = candidate;
+				best_size = size;
+			}
+			found |= size != 0;
+		}
+		if (!found) {
+			break;
 		}
-	} while ((subset = bb_next_subset(magic->premask, subset)));
-	return true;
+	}
 }
 
-void
-find_magic(struct Magic *magic,
-           Square square,
-           Bitboard (*attacker)(Square, Bitboard),
-           Bitboard (*premasker)(Square))
+static ppointer
+magics_search_run(ppointer data)
 {
-	size_t attacks_table_size = sizeof(Bitboard) * 4096;
-	Bitboard *attacks_table = malloc(sizeof(Bitboard) * 4096);
-	exit_if_null(attacks_table);
-	magic->premask = premasker(square);
-	magic->postmask = UINT64_MAX;
-	magic->rshift = 64 - popcnt64(magic->premask);
-	do {
-		memset(attacks_table, 0, attacks_table_size);
-		magic->multiplier = bb_sparse_random();
-	} while (!verify_magic_candidate(magic, square, attacks_table, attacker));
-	free(attacks_table);
+	struct MagicsSearch *search = data;
+	struct MagicSquareSearch *square_search =
+	  exit_if_null(calloc(1, sizeof(struct MagicSquareSearch)));
+	pint sq;
+	while ((sq = p_atomic_int_add(&search->next_sq, 1)) < SQUARES_COUNT) {
+		magics_search_square(search, square_search, sq);
+	}
+	free(square_search);
+	return NULL;
+}
+
+static void
+magics_find(struct Magic magics[SQUARES_COUNT],
+            Bitboard (*slider)(Square, Bitboard),
+            Bitboard (*premasker)(Square),
+            size_t threads_count,
+            size_t attempts_count,
+            uint64_t seed)
+{
+	struct MagicsSearch search = {
+		.magics = magics,
+		.slider = slider,
+		.premasker = premasker,
+		.attempts_count = attempts_count,
+		.seed = seed,
+		.next_sq = 0,
+	};
+	PUThread **threads = exit_if_null(malloc(threads_count * sizeof(PUThread *)));
+	for (size_t i = 0; i < threads_count; i++) {
+		threads[i] = p_uthread_create(magics_search_run, &search, true, "magics");
+	}
+	for (size_t i = 0; i < threads_count; i++) {
+		p_uthread_join(threads[i]);
+		p_uthread_unref(threads[i]);
+	}
+	free(threads);
 }
 
 void
-magic_find_rook(struct Magic *magic, Square square)
+magics_find_rook(struct Magic magics[SQUARES_COUNT],
+                 size_t threads_count,
+                 size_t attempts_count,
+                 uint64_t seed)
 {
-	find_magic(magic, square, threats_by_rook_no_init, bb_premask_rook);
+	magics_find(
+	  magics, threats_by_rook_no_init, bb_premask_rook, threads_count, attempts_count, seed);
 }
 
 void
-magic_find_bishop(struct Magic *magic, Square square)
+magics_find_bishop(struct Magic magics[SQUARES_COUNT],
+                   size_t threads_count,
+                   size_t attempts_count,
+                   uint64_t seed)
 {
-	find_magic(magic, square, threats_by_bishop_no_init, bb_premask_bishop);
+	magics_find(magics,
+	            threats_by_bishop_no_init,
+	            bb_premask_bishop,
+	            threads_count,
+	            attempts_count,
+	            seed);
 }
@@ -0,0 +1,88 @@
+/* SPDX-License-Identifier: GPL-3.0-only */
+
+/* Magic hashing and the layout of attack tables. Besides the engine, it's used
+ * by tools/gen_threats.c at build time, so it must not depend on anything but
+ * plain coordinates. */
+
+#include "chess/magic.h"
+#include <stdbool.h>
+#include <stdlib.h>
+
+size_t
+magic_index(const struct Magic *magic, Bitboard occupancy)
+{
+	Bitboard key = magic->black ? occupancy | ~magic->premask : occupancy & magic->premask;
+	return (key * magic->multiplier) >> magic->rshift;
+}
+
+/* Sliders always attack at least one square, so empty entries are unused. */
+static bool
+attacks_fit(const Bitboard *attacks,
+            const Bitboard *square_attacks,
+            const size_t *used_indices,
+            size_t used_count,
+            size_t offset)
+{
+	for (size_t i = 0; i < used_count; i++) {
+		Bitboard entry = attacks[offset + used_indices[i]];
+		if (entry && entry != square_attacks[used_indices[i]]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+Bitboard *
+magics_build_attacks(const struct Magic magics[SQUARES_COUNT],
+                     Bitboard (*slider)(Square, Bitboard),
+                     size_t offsets[SQUARES_COUNT],
+                     size_t *size)
+{
+	// Without any overlaps, all tables end to end.
+	size_t capacity = 0;
+	size_t max_square_size = 0;
+	for (Square sq = 0; sq < SQUARES_COUNT; sq++) {
+		size_t square_size = (size_t)1 << (64 - magics[sq].rshift);
+		capacity += square_size;
+		max_square_size = square_size > max_square_size ? square_size : max_square_size;
+	}
+	Bitboard *attacks = calloc(capacity, sizeof(Bitboard));
+	Bitboard *square_attacks = calloc(max_square_size, sizeof(Bitboard));
+	size_t *used_indices = malloc(max_square_size * sizeof(size_t));
+	if (!attacks || !square_attacks || !used_indices) {
+		free(attacks);
+		free(square_attacks);
+		free(used_indices);
+		return NULL;
+	}
+	*size = 0;
+	for (Square sq = 0; sq < SQUARES_COUNT; sq++) {
+		const struct Magic *magic = magics + sq;
+		size_t square_size = 0;
+		size_t used_count = 0;
+		// See https://www.chessprogramming.org/Traversing_Subsets_of_a_Set.
+		Bitboard subset = 0;
+		do {
+			size_t i = magic_index(magic, subset);
+			if (!square_attacks[i]) {
+				square_attacks[i] = slider(sq, subset);
+				used_indices[used_count++] = i;
+				square_size = i + 1 > square_size ? i + 1 : square_size;
+			}
+		} while ((subset = (subset - magic->premask) & magic->premask));
+		// First fit. Past the end of the tables so far, anything goes.
+		size_t offset = 0;
+		while (!attacks_fit(attacks, square_attacks, used_indices, used_count, offset)) {
+			offset++;
+		}
+		for (size_t i = 0; i < used_count; i++) {
+			attacks[offset + used_indices[i]] = square_attacks[used_indices[i]];
+			square_attacks[used_indices[i]] = 0;
+		}
+		offsets[sq] = offset;
+		*size = offset + square_size > *size ? offset + square_size : *size;
+	}
+	free(square_attacks);
+	free(used_indices);
+	return attacks;
+}
@@ -5,6 +5,7 @@
 #include "chess/pieces.h"
 #include "chess/mnemonics.h"
 #include "chess/position.h"
+#include "chess/zobrist.h"
 #include "utils.h"
 #include <assert.h>
 #include <ctype.h>
@@ -25,20 +26,13 @@ move_to_string(struct Move mv, char *buf)
 {
 	assert(buf);
 	size_t i = 0;
-	if (mv.castling && mv.source > mv.target) {
-		strcpy(buf, "0-0-0");
-		i = strlen(buf);
-	} else if (mv.castling && mv.source < mv.target) {
-		strcpy(buf, "0-0");
-		i = strlen(buf);
-	} else {
-		buf[i++] = file_to_char(square_file(mv.source));
-		buf[i++] = rank_to_char(square_rank(mv.source));
-		buf[i++] = file_to_char(square_file(mv.target));
-		buf[i++] = rank_to_char(square_rank(mv.target));
-		if (mv.promotion) {
-			buf[i++] = piece_to_char((struct Piece){ .type = mv.promotion });
-		}
+	// Castling is written as the king's own move (e.g. "e1g1"), as UCI wants.
+	buf[i++] = file_to_char(square_file(mv.source));
+	buf[i++] = rank_to_char(square_rank(mv.source));
+	buf[i++] = file_to_char(square_file(mv.target));
+	buf[i++] = rank_to_char(square_rank(mv.target));
+	if (mv.promotion) {
+		buf[i++] = piece_to_char((struct Piece){ .type = mv.promotion });
 	}
 	return i;
 }
@@ -80,30 +74,122 @@ string_to_move(const char *str, struct Move *mv)
 	return 4;
 }
 
+static void
+position_move_piece(struct Board *pos, Square source, Square target)
+{
+	uint8_t piece = pos->squares[source];
+	position_xor_piece(pos, piece, square_to_bb(source) | square_to_bb(target));
+	position_hash_piece(pos, piece, source);
+	position_hash_piece(pos, piece, target);
+	pos->squares[source] = 0;
+	pos->squares[target] = piece;
+}
+
+static void
+position_replace_piece(struct Board *pos, Square square, uint8_t piece)
+{
+	Bitboard bb = square_to_bb(square);
+	if (pos->squares[square]) {
+		position_xor_piece(pos, pos->squares[square], bb);
+		position_hash_piece(pos, pos->squares[square], square);
+	}
+	if (piece) {
+		position_xor_piece(pos, piece, bb);
+		position_hash_piece(pos, piece, square);
+	}
+	pos->squares[square] = piece;
+}
+
+static void
+position_set_castling_rights(struct Board *pos, int castling_rights)
+{
+	pos->hash ^= zobrist_castling_rights(pos->castling_rights ^ castling_rights);
+	pos->castling_rights = castling_rights;
+}
+
+static void
+position_set_en_passant_target(struct Board *pos, Square en_passant_target)
+{
+	pos->hash ^= zobrist_en_passant(pos->en_passant_target) ^ zobrist_en_passant(en_passant_target);
+	pos->en_passant_target = en_passant_target;
+}
+
+/* The rook's journey when castling with the king on `king_source`. */
+static void
+castling_rook_squares(Square king_source, Square king_target, Square *source, Square *target)
+{
+	Rank rank = square_rank(king_source);
+	if (king_target > king_source) {
+		*source = square_new(F_H, rank);
+		*target = square_new(F_F, rank);
+	} else {
+		*source = square_new(F_A, rank);
+		*target = square_new(F_D, rank);
+	}
+}
+
+static bool
+move_is_castling(const struct Move *mv, enum PieceType ptype)
+{
+	// Kings move two files only when castling, whatever the notation said.
+	return ptype == PIECE_TYPE_KING && abs(mv->target - mv->source) == 2 * RANKS_COUNT;
+}
+
+/* Castling rights are lost as soon as the king or the rook leave their home
+ * squares, or the rook gets captured. */
+static const uint8_t CASTLING_RIGHTS_LOST_BY_SQUARE[SQUARES_COUNT] = {
+	[SQ_A1] = CASTLING_RIGHT(CASTLING_RIGHT_QUEENSIDE, COLOR_WHITE),
+	[SQ_E1] = CASTLING_RIGHT(CASTLING_RIGHT_KINGSIDE | CASTLING_RIGHT_QUEENSIDE, COLOR_WHITE),
+	[SQ_H1] = CASTLING_RIGHT(CASTLING_RIGHT_KINGSIDE, COLOR_WHITE),
+	[SQ_A8] = CASTLING_RIGHT(CASTLING_RIGHT_QUEENSIDE, COLOR_BLACK),
+	[SQ_E8] = CASTLING_RIGHT(CASTLING_RIGHT_KINGSIDE | CASTLING_RIGHT_QUEENSIDE, COLOR_BLACK),
+	[SQ_H8] = CASTLING_RIGHT(CASTLING_RIGHT_KINGSIDE, COLOR_BLACK),
+};
+
 void
 position_do_move(struct Board *pos, struct Move *mv)
 {
-	pos->en_passant_target = false;
-	if (mv->castling) {
-		if (mv->castling_side == CASTLING_RIGHT_KINGSIDE) {
-			//
-		} else if (mv->castling_side == CASTLING_RIGHT_QUEENSIDE) {
-			//
-		}
-		pos->castling_rights ^= mv->castling_side << pos->side_to_move;
+	uint8_t piece = pos->squares[mv->source];
+	enum PieceType ptype = PIECE_CODE_TYPE(piece);
+	Square capture_square = mv->target;
+	mv->previous_castling_rights = pos->castling_rights;
+	mv->previous_en_passant_target = pos->en_passant_target;
+	mv->previous_reversible_moves_count = pos->reversible_moves_count;
+	mv->en_passant = ptype == PIECE_TYPE_PAWN && mv->target == pos->en_passant_target &&
+	                 square_file(mv->target) != square_file(mv->source);
+	if (mv->en_passant) {
+		capture_square = square_new(square_file(mv->target), square_rank(mv->source));
+	}
+	mv->capture = PIECE_CODE_TYPE(pos->squares[capture_square]);
+	if (mv->capture) {
+		position_replace_piece(pos, capture_square, 0);
 	}
-	bool is_pawn = pos->bb[PIECE_TYPE_PAWN] & square_to_bb(mv->source);
-	mv->capture = position_piece_at_square(pos, mv->target).type;
-	position_set_piece_at_square(
-	  pos, mv->target, position_piece_at_square(pos, mv->source));
-	position_set_piece_at_square(pos, mv->source, PIECE_NONE);
-	if (is_pawn && abs(mv->target - mv->source) == 2) {
-		pos->en_passant_target = (mv->target + mv->source) / 2;
+	position_move_piece(pos, mv->source, mv->target);
+	if (ptype != PIECE_TYPE_PAWN) {
+		mv->promotion = PIECE_TYPE_NONE;
+	} else if (mv->promotion) {
+		position_replace_piece(pos, mv->target, PIECE_CODE(mv->promotion, PIECE_CODE_COLOR(piece)));
 	}
-	if (pos->bb[COLOR_BLACK] & SQ_A1) {
-		position_pprint(pos, stdout);
+	if (move_is_castling(mv, ptype)) {
+		Square rook_source, rook_target;
+		castling_rook_squares(mv->source, mv->target, &rook_source, &rook_target);
+		position_move_piece(pos, rook_source, rook_target);
+	}
+	int castling_rights_lost = CASTLING_RIGHTS_LOST_BY_SQUARE[mv->source] |
+	                           CASTLING_RIGHTS_LOST_BY_SQUARE[mv->target];
+	if (pos->castling_rights & castling_rights_lost) {
+		position_set_castling_rights(pos, pos->castling_rights & ~castling_rights_lost);
+	}
+	Square en_passant_target = SQUARE_NONE;
+	if (ptype == PIECE_TYPE_PAWN && abs(mv->target - mv->source) == 2) {
+		en_passant_target = (mv->target + mv->source) / 2;
+	}
+	position_set_en_passant_target(pos, en_passant_target);
+	if (ptype == PIECE_TYPE_PAWN || mv->capture) {
+		pos->reversible_moves_count = 0;
+	} else if (pos->reversible_moves_count < UINT8_MAX) {
+		pos->reversible_moves_count++;
 	}
-	/* TODO: Castling */
 }
 
 void
@@ -113,6 +199,24 @@ position_do_move_and_flip(struct Board *pos, struct Move *mv)
 	position_flip_side_to_move(pos);
 }
 
+void
+position_play_move(struct Board *pos, struct Move *mv)
+{
+	position_do_move_and_flip(pos, mv);
+	if (pos->side_to_move == COLOR_WHITE) {
+		pos->moves_count++;
+	}
+}
+
+void
+position_take_back_move(struct Board *pos, const struct Move *mv)
+{
+	if (pos->side_to_move == COLOR_WHITE) {
+		pos->moves_count--;
+	}
+	position_undo_move_and_flip(pos, mv);
+}
+
 void
 position_undo_move_and_flip(struct Board *pos, const struct Move *mv)
 {
@@ -123,12 +227,48 @@ position_undo_move_and_flip(struct Board *pos, const struct Move *mv)
 void
 position_undo_move(struct Board *pos, const struct Move *mv)
 {
-	pos->en_passant_target = false;
-	position_set_piece_at_square(
-	  pos, mv->source, position_piece_at_square(pos, mv->target));
-	position_set_piece_at_square(
-	  pos, mv->target, (struct Piece){ .type = mv->capture, .color = pos->side_to_move });
-	/* TODO: Castling, en passant. */
+	uint8_t piece = pos->squares[mv->target];
+	enum Color color = PIECE_CODE_COLOR(piece);
+	if (mv->promotion) {
+		position_replace_piece(pos, mv->target, PIECE_CODE(PIECE_TYPE_PAWN, color));
+	}
+	position_move_piece(pos, mv->target, mv->source);
+	if (mv->capture) {
+		Square capture_square = mv->target;
+		if (mv->en_passant) {
+			capture_square = square_new(square_file(mv->target), square_rank(mv->source));
+		}
+		position_replace_piece(pos, capture_square, PIECE_CODE(mv->capture, color_other(color)));
+	}
+	if (move_is_castling(mv, PIECE_CODE_TYPE(piece))) {
+		Square rook_source, rook_target;
+		castling_rook_squares(mv->source, mv->target, &rook_source, &rook_target);
+		position_move_piece(pos, rook_target, rook_source);
+	}
+	position_set_castling_rights(pos, mv->previous_castling_rights);
+	position_set_en_passant_target(pos, mv->previous_en_passant_target);
+	pos->reversible_moves_count = mv->previous_reversible_moves_count;
+}
+
+void
+position_do_null_move(struct Board *pos, struct Move *mv)
+{
+	*mv = MOVE_IDENTITY;
+	mv->previous_castling_rights = pos->castling_rights;
+	mv->previous_en_passant_target = pos->en_passant_target;
+	mv->previous_reversible_moves_count = pos->reversible_moves_count;
+	position_set_en_passant_target(pos, SQUARE_NONE);
+	// Positions on either side of a null move can't repeat each other.
+	pos->reversible_moves_count = 0;
+	position_flip_side_to_move(pos);
+}
+
+void
+position_undo_null_move(struct Board *pos, const struct Move *mv)
+{
+	position_flip_side_to_move(pos);
+	position_set_en_passant_target(pos, mv->previous_en_passant_target);
+	pos->reversible_moves_count = mv->previous_reversible_moves_count;
 }
 
 Square
@@ -8,6 +8,7 @@
 #include "chess/mnemonics.h"
 #include "chess/position.h"
 #include "chess/threats.h"
+#include "feature_flags.h"
 #include "meta.h"
 #include "utils.h"
 #include <assert.h>
@@ -22,6 +23,29 @@ emit_move(struct Move *restrict mv, Square source, Square target)
 	mv->promotion = PIECE_TYPE_NONE;
 	mv->capture = false;
 	mv->castling = false;
+	mv->en_passant = false;
+}
+
+/* Emits a pawn move, or all four of its promotions. Returns the number of
+ * moves. */
+static size_t
+emit_pawn_move(struct Move *restrict moves, Square source, Square target, enum Color color)
+{
+	static const enum PieceType PROMOTIONS[] = {
+		PIECE_TYPE_QUEEN,
+		PIECE_TYPE_KNIGHT,
+		PIECE_TYPE_ROOK,
+		PIECE_TYPE_BISHOP,
+	};
+	if (square_rank(target) != color_promoting_rank(color)) {
+		emit_move(moves, source, target);
+		return 1;
+	}
+	for (size_t i = 0; i < ARRAY_SIZE(PROMOTIONS); i++) {
+		emit_move(moves + i, source, target);
+		moves[i].promotion = PROMOTIONS[i];
+	}
+	return ARRAY_SIZE(PROMOTIONS);
 }
 
 /* Generates all pseudolegal moves by pawns located on 'sources' to 'targets'
@@ -62,11 +86,8 @@ gen_pawn_moves(struct Move *restrict moves,
 	Square square;
 	while (single_pushes) {
 		POP_LSB(square, single_pushes);
-		emit_move(moves, square + color_params[0][side_to_move], square);
-		if (square_rank(square) == color_promoting_rank(side_to_move)) {
-			moves->promotion = PIECE_TYPE_QUEEN;
-		}
-		moves++;
+		moves +=
+		  emit_pawn_move(moves, square + color_params[0][side_to_move], square, side_to_move);
 	}
 	while (double_pushes) {
 		POP_LSB(square, double_pushes);
@@ -74,19 +95,13 @@ gen_pawn_moves(struct Move *restrict moves,
 	}
 	while (captures_east) {
 		POP_LSB(square, captures_east);
-		emit_move(moves, square + color_params[2][side_to_move], square);
-		if (square_rank(square) == color_promoting_rank(side_to_move)) {
-			moves->promotion = PIECE_TYPE_QUEEN;
-		}
-		moves++;
+		moves +=
+		  emit_pawn_move(moves, square + color_params[2][side_to_move], square, side_to_move);
 	}
 	while (captures_west) {
 		POP_LSB(square, captures_west);
-		emit_move(moves, square + color_params[3][side_to_move], square);
-		if (square_rank(square) == color_promoting_rank(side_to_move)) {
-			moves->promotion = PIECE_TYPE_QUEEN;
-		}
-		moves++;
+		moves +=
+		  emit_pawn_move(moves, square + color_params[3][side_to_move], square, side_to_move);
 	}
 	return moves - ptr;
 }
@@ -158,40 +173,66 @@ gen_king_moves(struct Move *moves, Bitboard sources, Bitboard mask)
 	return moves - ptr;
 }
 
-size_t
-gen_king_castles(struct Move moves[], struct Board *pos, enum Color color, Bitboard king)
+bool
+position_is_attacked(const struct Board *pos, Square square, enum Color attacker)
 {
-	struct Move *ptr = moves;
-	struct Move castle_buf[MAX_MOVES];
-	bool is_check = gen_attacks_against_from(castle_buf,
-	                                         pos,
-	                                         pos->bb[color] & pos->bb[PIECE_TYPE_KING],
-	                                         color_other(color),
-	                                         pos->en_passant_target,
-	                                         false) != 0;
-	if (is_check) {
+	Bitboard attackers = pos->bb[attacker];
+	Bitboard occupancy = pos->bb[COLOR_WHITE] | pos->bb[COLOR_BLACK];
+	Bitboard pawns = attackers & pos->bb[PIECE_TYPE_PAWN];
+	Bitboard pawns_east = pawns & ~file_to_bb(F_H);
+	Bitboard pawns_west = pawns & ~file_to_bb(F_A);
+	Bitboard pawn_threats = attacker == COLOR_WHITE ? (pawns_east << 9) | (pawns_west >> 7)
+	                                                : (pawns_east << 7) | (pawns_west >> 9);
+	return (pawn_threats & square_to_bb(square)) ||
+	       (threats_by_knight(square) & attackers & pos->bb[PIECE_TYPE_KNIGHT]) ||
+	       (threats_by_king(square) & attackers & pos->bb[PIECE_TYPE_KING]) ||
+	       (threats_by_bishop(square, occupancy) & attackers & pos->bb[PIECE_TYPE_BISHOP]) ||
+	       (threats_by_rook(square, occupancy) & attackers & pos->bb[PIECE_TYPE_ROOK]);
+}
+
+/* Only standard castling is supported: the king must be on the E file and the
+ * rook in its corner. */
+static size_t
+gen_king_castle(struct Move moves[], struct Board *pos, enum Color color, int side)
+{
+	Rank rank = color_home_rank(color);
+	Square king = square_new(F_E, rank);
+	Square rook = square_new(side == CASTLING_RIGHT_KINGSIDE ? F_H : F_A, rank);
+	Square target = square_new(side == CASTLING_RIGHT_KINGSIDE ? F_G : F_C, rank);
+	if (!(pos->castling_rights & CASTLING_RIGHT(side, color)) ||
+	    pos->squares[king] != PIECE_CODE(PIECE_TYPE_KING, color) ||
+	    pos->squares[rook] != PIECE_CODE(PIECE_TYPE_ROOK, color)) {
 		return 0;
 	}
-	if (pos->castling_rights & (CASTLING_RIGHT_KINGSIDE << color)) {
-		Bitboard mask = position_castle_mask(pos, CASTLING_RIGHT_KINGSIDE);
-		if (!(position_occupancy(pos) & (mask ^ king))) {
-			Square source = bb_to_square(king);
-			emit_move(moves, source, source + 16);
-			moves->castling = true;
-			moves->castling_side = CASTLING_RIGHT_KINGSIDE;
-			moves++;
+	// All squares between the king and the rook must be empty...
+	Square first = (king < rook ? king : rook) + RANKS_COUNT;
+	Square last = (king < rook ? rook : king) - RANKS_COUNT;
+	for (Square square = first; square <= last; square += RANKS_COUNT) {
+		if (pos->squares[square]) {
+			return 0;
 		}
 	}
-	if (pos->castling_rights & (CASTLING_RIGHT_QUEENSIDE << color)) {
-		Bitboard mask = position_castle_mask(pos, CASTLING_RIGHT_QUEENSIDE);
-		if (!(position_occupancy(pos) & (mask ^ king))) {
-			Square source = bb_to_square(king);
-			emit_move(moves, source, source - 16);
-			moves->castling = true;
-			moves->castling_side = CASTLING_RIGHT_QUEENSIDE;
-			moves++;
+	// ...and the king mustn't cross any threatened square. The target is
+	// checked later on, like for any other move.
+	Square step = target > king ? RANKS_COUNT : -RANKS_COUNT;
+	for (Square square = king; square != target; square += step) {
+		if (position_is_attacked(pos, square, color_other(color))) {
+			return 0;
 		}
 	}
+	emit_move(moves, king, target);
+	moves->castling = true;
+	moves->castling_side = side;
+	return 1;
+}
+
+size_t
+gen_king_castles(struct Move moves[], struct Board *pos, enum Color color, Bitboard king)
+{
+	UNUSED(king);
+	struct Move *ptr = moves;
+	moves += gen_king_castle(moves, pos, color, CASTLING_RIGHT_KINGSIDE);
+	moves += gen_king_castle(moves, pos, color, CASTLING_RIGHT_QUEENSIDE);
 	return moves - ptr;
 }
 
@@ -209,7 +250,11 @@ gen_attacks_against_from(struct Move moves[],
 	                        pieces & pos->bb[PIECE_TYPE_PAWN],
 	                        victims,
 	                        position_occupancy(pos),
-	                        0, // square_to_bb(en_passant_target),
+	                        // The en passant target only matters when
+	                        // generating moves, not when looking for threats.
+	                        en_passant_target == SQUARE_NONE
+	                          ? 0
+	                          : square_to_bb(en_passant_target) & victims,
 	                        attacker);
 	moves += gen_knight_moves(moves, pieces & pos->bb[PIECE_TYPE_KNIGHT], victims);
 	moves += gen_bishop_moves(
@@ -253,18 +298,36 @@ gen_legal_moves(struct Move moves[], struct Board *pos)
 	int i = 0;
 	int count = gen_pseudolegal_moves(moves, pos);
 	while (i < count) {
+#if ZULOID_ENABLE_COPY_MAKE
+		struct Board child = *pos;
+		position_do_move_and_flip(&child, moves + i);
+		bool is_illegal = position_is_illegal(&child);
+#else
 		position_do_move_and_flip(pos, moves + i);
-		if (position_is_illegal(pos)) {
-			position_undo_move_and_flip(pos, moves + i);
+		bool is_illegal = position_is_illegal(pos);
+		position_undo_move_and_flip(pos, moves + i);
+#endif
+		if (is_illegal) {
 			moves[i] = moves[--count];
 		} else {
-			position_undo_move_and_flip(pos, moves + i);
 			i++;
 		}
 	}
 	return i;
 }
 
+bool
+position_is_check(struct Board *pos)
+{
+	struct Move moves[MAX_MOVES];
+	return gen_attacks_against_from(moves,
+	                                pos,
+	                                pos->bb[pos->side_to_move] & pos->bb[PIECE_TYPE_KING],
+	                                color_other(pos->side_to_move),
+	                                SQUARE_NONE,
+	                                false);
+}
+
 bool
 position_is_stalemate(struct Board *pos)
 {
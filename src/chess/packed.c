@@ -0,0 +1,203 @@
+/* SPDX-License-Identifier: GPL-3.0-only */
+
+#include "chess/packed.h"
+#include "chess/bb.h"
+#include "chess/color.h"
+#include "chess/coordinates.h"
+#include "chess/pieces.h"
+#include "chess/position.h"
+#include "utils.h"
+#include <assert.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+struct PackedWriter
+{
+	FILE *file;
+	// The first I/O error, if any. `packed_writer_close` reports it too.
+	int err;
+	size_t count;
+	struct PackedPosition buffer[PACKED_WRITER_BUFFER_SIZE];
+};
+
+struct PackedReader
+{
+	const struct PackedPosition *data;
+	size_t size;
+};
+
+/* Nibbles hold the color in the highest bit and a dense piece type index in the
+ * other three. */
+static const uint8_t NIBBLE_BY_PIECE_TYPE[] = {
+	[PIECE_TYPE_PAWN] = 1, [PIECE_TYPE_KNIGHT] = 2, [PIECE_TYPE_BISHOP] = 3,
+	[PIECE_TYPE_ROOK] = 4, [PIECE_TYPE_QUEEN] = 5,  [PIECE_TYPE_KING] = 6,
+};
+
+static const enum PieceType PIECE_TYPE_BY_NIBBLE[8] = {
+	PIECE_TYPE_NONE, PIECE_TYPE_PAWN,  PIECE_TYPE_KNIGHT, PIECE_TYPE_BISHOP,
+	PIECE_TYPE_ROOK, PIECE_TYPE_QUEEN, PIECE_TYPE_KING,   PIECE_TYPE_NONE,
+};
+
+void
+packed_from_position(struct PackedPosition *packed, const struct Board *pos)
+{
+	assert(packed);
+	assert(pos);
+	memset(packed, 0, sizeof(struct PackedPosition));
+	packed->occupancy = pos->bb[COLOR_WHITE] | pos->bb[COLOR_BLACK];
+	packed->flags = pos->side_to_move | (pos->castling_rights << 1);
+	packed->en_passant_target = pos->en_passant_target;
+	packed->reversible_moves_count = pos->reversible_moves_count;
+	packed->moves_count = pos->moves_count;
+	packed->result = PACKED_RESULT_UNKNOWN;
+	packed->score = PACKED_SCORE_NONE;
+	Bitboard occupancy = packed->occupancy;
+	Square square = 0;
+	// Illegal positions with more than 32 pieces simply get truncated.
+	for (size_t i = 0; occupancy && i < 32; i++) {
+		POP_LSB(square, occupancy);
+		struct Piece piece = position_piece_at_square(pos, square);
+		uint8_t nibble = NIBBLE_BY_PIECE_TYPE[piece.type] | (piece.color << 3);
+		packed->pieces[i / 2] |= nibble << ((i % 2) * 4);
+	}
+}
+
+void
+position_init_from_packed(struct Board *pos, const struct PackedPosition *packed)
+{
+	assert(pos);
+	assert(packed);
+	position_empty(pos);
+	Bitboard occupancy = packed->occupancy;
+	Square square = 0;
+	for (size_t i = 0; occupancy && i < 32; i++) {
+		POP_LSB(square, occupancy);
+		uint8_t nibble = (packed->pieces[i / 2] >> ((i % 2) * 4)) & 0xf;
+		struct Piece piece = {
+			.type = PIECE_TYPE_BY_NIBBLE[nibble & 0x7],
+			.color = nibble >> 3,
+		};
+		position_set_piece_at_square(pos, square, piece);
+	}
+	pos->side_to_move = packed->flags & 1;
+	pos->castling_rights = (packed->flags >> 1) & CASTLING_RIGHTS_ALL;
+	pos->en_passant_target = packed->en_passant_target;
+	pos->reversible_moves_count = packed->reversible_moves_count;
+	pos->moves_count = packed->moves_count;
+	pos->hash = position_zobrist(pos);
+	pos->pawn_hash = position_pawn_zobrist(pos);
+}
+
+static int
+packed_writer_flush(struct PackedWriter *writer)
+{
+	size_t count = writer->count;
+	writer->count = 0;
+	if (fwrite(writer->buffer, sizeof(struct PackedPosition), count, writer->file) != count &&
+	    !writer->err) {
+		writer->err = ERR_CODE_IO;
+	}
+	return writer->err;
+}
+
+struct PackedWriter *
+packed_writer_open(const char *path)
+{
+	assert(path);
+	FILE *file = fopen(path, "wb");
+	if (!file) {
+		return NULL;
+	}
+	struct PackedWriter *writer = exit_if_null(malloc(sizeof(struct PackedWriter)));
+	writer->file = file;
+	writer->err = ERR_CODE_NONE;
+	writer->count = 0;
+	return writer;
+}
+
+int
+packed_writer_push(struct PackedWriter *writer, const struct PackedPosition *packed)
+{
+	assert(writer);
+	assert(packed);
+	writer->buffer[writer->count++] = *packed;
+	if (writer->count == PACKED_WRITER_BUFFER_SIZE) {
+		return packed_writer_flush(writer);
+	}
+	return ERR_CODE_NONE;
+}
+
+int
+packed_writer_close(struct PackedWriter *writer)
+{
+	assert(writer);
+	int err = packed_writer_flush(writer);
+	if (fclose(writer->file) != 0) {
+		err = ERR_CODE_IO;
+	}
+	free(writer);
+	return err;
+}
+
+struct PackedReader *
+packed_reader_open(const char *path)
+{
+	assert(path);
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return NULL;
+	}
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size % sizeof(struct PackedPosition) != 0) {
+		close(fd);
+		return NULL;
+	}
+	void *data = NULL;
+	// Zero-length mappings are invalid, but empty files are not.
+	if (info.st_size > 0) {
+		data = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	}
+	close(fd);
+	if (data == MAP_FAILED) {
+		return NULL;
+	}
+	// Training pipelines typically access positions in random order.
+	if (data) {
+		madvise(data, info.st_size, MADV_RANDOM);
+	}
+	struct PackedReader *reader = exit_if_null(malloc(sizeof(struct PackedReader)));
+	reader->data = data;
+	reader->size = info.st_size;
+	return reader;
+}
+
+size_t
+packed_reader_count(const struct PackedReader *reader)
+{
+	assert(reader);
+	return reader->size / sizeof(struct PackedPosition);
+}
+
+const struct PackedPosition *
+packed_reader_get(const struct PackedReader *reader, size_t i)
+{
+	assert(reader);
+	assert(i < packed_reader_count(reader));
+	return reader->data + i;
+}
+
+void
+packed_reader_close(struct PackedReader *reader)
+{
+	if (!reader) {
+		return;
+	}
+	if (reader->data) {
+		munmap((void *)reader->data, reader->size);
+	}
+	free(reader);
+}
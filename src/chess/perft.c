@@ -1,11 +1,12 @@
 /* SPDX-License-Identifier: GPL-3.0-only */
 
 #include "chess/bb.h"
+#include "chess/board_batch.h"
 #include "chess/color.h"
 #include "chess/fen.h"
 #include "chess/movegen.h"
 #include "chess/position.h"
-#include "core/sstack.h"
+#include "feature_flags.h"
 #include "meta.h"
 #include "utils.h"
 #include <assert.h>
@@ -14,84 +15,59 @@
 
 typedef unsigned long long perft_counter;
 
-struct DfsStack
+/* Positions one plie away from the leaves are only counted, a whole batch at a
+ * time. */
+struct PerftBatch
 {
-	struct PlieIter *plies;
-	int desired_depth;
-	int current_depth;
-	struct Board board;
+	struct BoardBatch batch;
+	struct BoardBatchResults results;
+	perft_counter nodes_count;
 };
 
-struct DfsStack
-dfsstack_new(size_t depth)
+static void
+perft_batch_flush(struct PerftBatch *pb)
 {
-	struct DfsStack stack;
-	stack.plies = exit_if_null(malloc((depth + 1) * sizeof(struct PlieIter)));
-	stack.desired_depth = depth;
-	stack.current_depth = 1;
-	for (size_t i = 0; i < depth + 1; i++) {
-		plieiter_init(&stack.plies[i]);
+	if (pb->batch.count == 0) {
+		return;
 	}
-	return stack;
-}
-
-void
-dfsstack_delete(struct DfsStack *stack)
-{
-	for (int i = 0; i < stack->desired_depth; i++) {
-		plieiter_delete(&stack->plies[i]);
+	board_batch_analyze(&pb->batch, &pb->results);
+	for (size_t i = 0; i < pb->batch.count; i++) {
+		pb->nodes_count += pb->results.legal_moves_count[i];
 	}
-	free(stack->plies);
-}
-
-struct PlieIter *
-dfsstack_last(const struct DfsStack *stack)
-{
-	return stack->plies + stack->current_depth;
-}
-
-void
-dfsstack_pop(struct DfsStack *stack)
-{
-	struct PlieIter *last_plie = dfsstack_last(stack);
-	assert(stack->current_depth > 0);
-	assert(!plieiter_has_next(last_plie));
-	position_undo_move_and_flip(&stack->board, &last_plie->generator);
-	stack->current_depth--;
+	board_batch_clear(&pb->batch);
 }
 
-void
-dfsstack_push(struct DfsStack *stack)
+static void
+perft_batch_push(struct PerftBatch *pb, const struct Board *board)
 {
-	struct PlieIter *last_plie = dfsstack_last(stack);
-	assert(plieiter_has_next(last_plie));
-	struct Move generator = last_plie->moves[last_plie->child_i++];
-	stack->current_depth++;
-	last_plie++;
-	last_plie->child_i = 0;
-	last_plie->generator = generator;
-	position_do_move_and_flip(&stack->board, &last_plie->generator);
-	last_plie->children_count = gen_legal_moves(last_plie->moves, &stack->board);
+	if (board_batch_is_full(&pb->batch)) {
+		perft_batch_flush(pb);
+	}
+	board_batch_push(&pb->batch, board);
 }
 
-unsigned long long
-dfsstack_count(struct DfsStack *stack)
+static void
+perft_batch_recurse(struct PerftBatch *pb, struct Board *pos, unsigned depth)
 {
-	unsigned long long result = 0;
-	while (true) {
-		struct PlieIter *last_plie = dfsstack_last(stack);
-		if (!plieiter_has_next(last_plie)) {
-			if (stack->current_depth == 1) {
-				return result;
-			} else {
-				dfsstack_pop(stack);
-			}
-		} else if (stack->current_depth == stack->desired_depth) {
-			last_plie->child_i++;
-			result++;
-		} else {
-			dfsstack_push(stack);
-		}
+	assert(depth >= 1);
+	if (depth == 1) {
+		perft_batch_push(pb, pos);
+		return;
+	}
+	struct Move moves[MAX_MOVES];
+	size_t moves_count = gen_legal_moves(moves, pos);
+	for (size_t i = 0; i < moves_count; i++) {
+#if ZULOID_ENABLE_COPY_MAKE
+		struct Board board = *pos;
+		position_do_move_and_flip(&board, moves + i);
+		perft_batch_recurse(pb, &board, depth - 1);
+#else
+		// Batches keep copies of their boards, so `pos` can be reused right
+		// away.
+		position_do_move_and_flip(pos, moves + i);
+		perft_batch_recurse(pb, pos, depth - 1);
+		position_undo_move_and_flip(pos, moves + i);
+#endif
 	}
 }
 
@@ -100,13 +76,13 @@ position_perft_inner(struct Board *pos, unsigned depth)
 {
 	if (depth == 0) {
 		return 1;
-	} else {
-		struct DfsStack stack = dfsstack_new(depth);
-		stack.board = *pos;
-		stack.plies[1].child_i = 0;
-		stack.plies[1].children_count = gen_legal_moves(stack.plies[1].moves, &stack.board);
-		return dfsstack_count(&stack);
 	}
+	struct PerftBatch pb;
+	board_batch_clear(&pb.batch);
+	pb.nodes_count = 0;
+	perft_batch_recurse(&pb, pos, depth);
+	perft_batch_flush(&pb);
+	return pb.nodes_count;
 }
 
 size_t
@@ -119,19 +95,25 @@ position_perft(FILE *stream, const struct Board *pos, size_t depth)
 		fprintf(stream, "<depth limit exceeded>\n");
 		return 0;
 	}
-	struct Move *moves = exit_if_null(malloc(sizeof(struct Move) * MAX_MOVES));
-	size_t root_moves_count = gen_legal_moves(moves, pos);
+	struct Board root = *pos;
+	struct Move moves[MAX_MOVES];
+	size_t root_moves_count = gen_legal_moves(moves, &root);
 	perft_counter result = 0;
 	for (size_t i = 0; i < root_moves_count; i++) {
-		struct Board board = *pos;
+#if ZULOID_ENABLE_COPY_MAKE
+		struct Board board = root;
 		position_do_move_and_flip(&board, moves + i);
 		perft_counter children_count = position_perft_inner(&board, depth - 1);
+#else
+		position_do_move_and_flip(&root, moves + i);
+		perft_counter children_count = position_perft_inner(&root, depth - 1);
+		position_undo_move_and_flip(&root, moves + i);
+#endif
 		result += children_count;
 		char mv_as_str[MOVE_STRING_MAX_LENGTH] = { '\0' };
 		move_to_string(moves[i], mv_as_str);
 		fprintf(stream, "%s: %llu\n", mv_as_str, children_count);
 	}
 	fprintf(stream, "\nNodes searched: %llu\n\n", result);
-	free(moves);
 	return result;
 }
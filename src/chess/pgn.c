@@ -0,0 +1,161 @@
+/* SPDX-License-Identifier: GPL-3.0-only */
+
+#include "chess/pgn.h"
+#include "chess/fen.h"
+#include "chess/san.h"
+#include "utils.h"
+#include <assert.h>
+#include <string.h>
+
+static void
+pgn_parser_reset(struct PgnParser *parser)
+{
+	parser->board = POSITION_INIT;
+	parser->result = PGN_RESULT_UNKNOWN;
+	parser->is_valid = true;
+	parser->has_moves = false;
+	parser->comment_depth = 0;
+	parser->variation_depth = 0;
+}
+
+void
+pgn_parser_init(struct PgnParser *parser,
+                void (*on_move)(void *, const struct Board *, const struct Move *),
+                int (*on_game)(void *, const struct PgnParser *),
+                void *data)
+{
+	assert(parser);
+	parser->on_move = on_move;
+	parser->on_game = on_game;
+	parser->data = data;
+	pgn_parser_reset(parser);
+}
+
+enum PgnResult
+string_to_pgn_result(const char *str)
+{
+	if (strstr(str, "1/2-1/2")) {
+		return PGN_RESULT_DRAW;
+	} else if (strstr(str, "1-0")) {
+		return PGN_RESULT_WHITE_WINS;
+	} else if (strstr(str, "0-1")) {
+		return PGN_RESULT_BLACK_WINS;
+	}
+	return PGN_RESULT_UNKNOWN;
+}
+
+static int
+pgn_parser_end_game(struct PgnParser *parser)
+{
+	int err = parser->on_game ? parser->on_game(parser->data, parser) : ERR_CODE_NONE;
+	pgn_parser_reset(parser);
+	return err;
+}
+
+static void
+pgn_parser_play(struct PgnParser *parser, const char *san)
+{
+	struct Move mv;
+	if (!parser->is_valid) {
+		return;
+	} else if (!string_to_move_san(san, &parser->board, &mv)) {
+		parser->is_valid = false;
+		return;
+	}
+	if (parser->on_move) {
+		parser->on_move(parser->data, &parser->board, &mv);
+	}
+	position_play_move(&parser->board, &mv);
+	parser->has_moves = true;
+}
+
+static void
+pgn_parser_tag(struct PgnParser *parser, char *line)
+{
+	char *value = strchr(line, '"');
+	char *end = value ? strrchr(value + 1, '"') : NULL;
+	if (!end) {
+		return;
+	}
+	*end = '\0';
+	if (strncmp(line, "[FEN ", 5) == 0) {
+		parser->is_valid =
+		  position_init_from_fen(&parser->board, value + 1) == ERR_CODE_NONE;
+	} else if (strncmp(line, "[Result ", 8) == 0) {
+		parser->result = string_to_pgn_result(value + 1);
+	}
+	*end = '"';
+}
+
+int
+pgn_parser_feed(struct PgnParser *parser, char *line)
+{
+	int err = ERR_CODE_NONE;
+	if (parser->comment_depth == 0 && line[0] == '[') {
+		// A new header means that the previous game didn't end with a
+		// termination marker.
+		if (parser->has_moves) {
+			err = pgn_parser_end_game(parser);
+		}
+		pgn_parser_tag(parser, line);
+		return err;
+	}
+	for (char *ptr = line; *ptr && !err;) {
+		size_t length = strcspn(ptr, " \t\v\r\n{}();");
+		if (parser->comment_depth > 0) {
+			char *close = strchr(ptr, '}');
+			if (!close) {
+				break;
+			}
+			parser->comment_depth = 0;
+			ptr = close + 1;
+		} else if (length == 0) {
+			switch (*ptr) {
+				case '{':
+					parser->comment_depth = 1;
+					break;
+				case '(':
+					parser->variation_depth++;
+					break;
+				case ')':
+					parser->variation_depth--;
+					break;
+				case ';':
+					// Rest-of-line comment.
+					return err;
+				default:
+					break;
+			}
+			ptr++;
+		} else {
+			char saved = ptr[length];
+			ptr[length] = '\0';
+			// Move numbers might be attached to the move itself, e.g. "1.e4".
+			char *token = ptr;
+			size_t digits_count = strspn(ptr, "0123456789");
+			if (ptr[digits_count] == '.') {
+				token += digits_count + strspn(ptr + digits_count, ".");
+			}
+			if (parser->variation_depth > 0 || *token == '$') {
+				// Variations and numeric annotation glyphs.
+			} else if (!strcmp(token, "1-0") || !strcmp(token, "0-1") ||
+			           !strcmp(token, "1/2-1/2") || !strcmp(token, "*")) {
+				if (parser->result == PGN_RESULT_UNKNOWN) {
+					parser->result = string_to_pgn_result(token);
+				}
+				err = pgn_parser_end_game(parser);
+			} else if (*token) {
+				pgn_parser_play(parser, token);
+			}
+			ptr[length] = saved;
+			ptr += length;
+		}
+	}
+	return err;
+}
+
+int
+pgn_parser_finish(struct PgnParser *parser)
+{
+	return parser->has_moves ? pgn_parser_end_game(parser) : ERR_CODE_NONE;
+}
@@ -45,3 +45,15 @@ char_to_piece(char c)
 }
 
 const struct Piece PIECE_NONE = { .type = PIECE_TYPE_NONE, .color = COLOR_WHITE };
+
+uint8_t
+piece_to_code(struct Piece piece)
+{
+	return piece.type == PIECE_TYPE_NONE ? 0 : PIECE_CODE(piece.type, piece.color);
+}
+
+struct Piece
+code_to_piece(uint8_t code)
+{
+	return (struct Piece){ .type = PIECE_CODE_TYPE(code), .color = PIECE_CODE_COLOR(code) };
+}
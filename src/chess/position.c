@@ -7,6 +7,7 @@
 #include "chess/fen.h"
 #include "chess/move.h"
 #include "chess/pieces.h"
+#include "chess/zobrist.h"
 #include "utils.h"
 #include <assert.h>
 #include <ctype.h>
@@ -22,13 +23,13 @@ char_to_castling_right(char c)
 {
 	switch (c) {
 		case 'K':
-			return CASTLING_RIGHT_KINGSIDE << COLOR_WHITE;
+			return CASTLING_RIGHT(CASTLING_RIGHT_KINGSIDE, COLOR_WHITE);
 		case 'Q':
-			return CASTLING_RIGHT_QUEENSIDE << COLOR_WHITE;
+			return CASTLING_RIGHT(CASTLING_RIGHT_QUEENSIDE, COLOR_WHITE);
 		case 'k':
-			return CASTLING_RIGHT_KINGSIDE << COLOR_BLACK;
+			return CASTLING_RIGHT(CASTLING_RIGHT_KINGSIDE, COLOR_BLACK);
 		case 'q':
-			return CASTLING_RIGHT_QUEENSIDE << COLOR_BLACK;
+			return CASTLING_RIGHT(CASTLING_RIGHT_QUEENSIDE, COLOR_BLACK);
 		default:
 			return CASTLING_RIGHT_NONE;
 	}
@@ -48,51 +49,58 @@ string_to_castling_rights(const char *str)
 enum Color
 position_flip_side_to_move(struct Board *pos)
 {
+	pos->hash ^= zobrist_turn(COLOR_WHITE);
 	pos->side_to_move = color_other(pos->side_to_move);
 	return pos->side_to_move;
 }
 
-void
+uint64_t
 position_zobrist(const struct Board *position)
-{}
+{
+	uint64_t hash = zobrist_castling_rights(position->castling_rights) ^
+	                zobrist_en_passant(position->en_passant_target) ^
+	                zobrist_turn(position->side_to_move);
+	for (Square square = 0; square <= SQUARE_MAX; square++) {
+		if (position->squares[square]) {
+			hash ^= zobrist_piece(position->squares[square], square);
+		}
+	}
+	return hash;
+}
+
+uint64_t
+position_pawn_zobrist(const struct Board *position)
+{
+	uint64_t hash = 0;
+	for (Square square = 0; square <= SQUARE_MAX; square++) {
+		if (PIECE_CODE_TYPE(position->squares[square]) == PIECE_TYPE_PAWN) {
+			hash ^= zobrist_piece(position->squares[square], square);
+		}
+	}
+	return hash;
+}
 
 void
 position_set_piece_at_square(struct Board *position, Square square, struct Piece piece)
 {
 	Bitboard bb = square_to_bb(square);
-	for (size_t i = 0; i < POSITION_BB_COUNT; i++) {
-		position->bb[i] &= ~bb;
+	uint8_t code = piece_to_code(piece);
+	if (position->squares[square]) {
+		position_xor_piece(position, position->squares[square], bb);
+		position_hash_piece(position, position->squares[square], square);
 	}
-	switch (piece.type) {
-		case PIECE_TYPE_QUEEN:
-			position->bb[PIECE_TYPE_BISHOP] |= bb;
-			position->bb[PIECE_TYPE_ROOK] |= bb;
-			break;
-		case PIECE_TYPE_NONE:
-			return;
-		default:
-			position->bb[piece.type] |= bb;
-			break;
+	if (code) {
+		position_xor_piece(position, code, bb);
+		position_hash_piece(position, code, square);
 	}
-	position->bb[piece.color] |= bb;
+	position->squares[square] = code;
 }
 
 struct Piece
 position_piece_at_square(const struct Board *position, Square square)
 {
 	assert(position);
-	Bitboard bb = square_to_bb(square);
-	struct Piece piece = PIECE_NONE;
-	enum PieceType i = PIECE_TYPE_FIRST_PRIMITIVE;
-	do {
-		if (position->bb[i] & bb) {
-			piece.type += i;
-		}
-	} while (i++ < PIECE_TYPE_LAST_PRIMITIVE);
-	if (position->bb[COLOR_BLACK] & bb) {
-		piece.color = COLOR_BLACK;
-	}
-	return piece;
+	return code_to_piece(position->squares[square]);
 }
 
 Bitboard
@@ -132,6 +140,8 @@ position_empty(struct Board *position)
 		.reversible_moves_count = 0,
 		.moves_count = 1,
 	};
+	position->hash = position_zobrist(position);
+	position->pawn_hash = position_pawn_zobrist(position);
 }
 
 void
@@ -154,6 +164,12 @@ position_pprint(const struct Board *position, FILE *stream)
 	free(fen);
 }
 
+// The mailbox of a file in the initial position, from the first rank to the
+// last.
+#define INIT_FILE(ptype)                                                                   \
+	PIECE_CODE(ptype, COLOR_WHITE), PIECE_CODE(PIECE_TYPE_PAWN, COLOR_WHITE), 0, 0, 0, 0,  \
+	  PIECE_CODE(PIECE_TYPE_PAWN, COLOR_BLACK), PIECE_CODE(ptype, COLOR_BLACK)
+
 const struct Board POSITION_INIT = {
   .bb =
     {
@@ -165,6 +181,20 @@ const struct Board POSITION_INIT = {
       [PIECE_TYPE_ROOK] = 0x8100000081000081,
       [PIECE_TYPE_KING] = 0x0000008100000000,
     },
+  .squares =
+    {
+      INIT_FILE(PIECE_TYPE_ROOK),
+      INIT_FILE(PIECE_TYPE_KNIGHT),
+      INIT_FILE(PIECE_TYPE_BISHOP),
+      INIT_FILE(PIECE_TYPE_QUEEN),
+      INIT_FILE(PIECE_TYPE_KING),
+      INIT_FILE(PIECE_TYPE_BISHOP),
+      INIT_FILE(PIECE_TYPE_KNIGHT),
+      INIT_FILE(PIECE_TYPE_ROOK),
+    },
+  // As given by the Polyglot specification.
+  .hash = 0x463b96181691fc9cULL,
+  .pawn_hash = 0x37fc40da841e1692ULL,
   .side_to_move = COLOR_WHITE,
   .en_passant_target = SQUARE_NONE,
   .castling_rights = CASTLING_RIGHTS_ALL,
@@ -0,0 +1,79 @@
+/* SPDX-License-Identifier: GPL-3.0-only */
+
+/* The slow way to find threats, one square at a time. It's only used to
+ * generate the attack tables at build time (see tools/gen_threats.c), to find
+ * magics, and to check the tables in tests. */
+
+#include "chess/coordinates.h"
+#include "chess/threats.h"
+#include <stdlib.h>
+
+static Bitboard
+leaper_attacks(Square sq, const short offsets[8][2])
+{
+	Bitboard bb = 0;
+	for (size_t i = 0; i < 8; i++) {
+		File f = square_file(sq) + offsets[i][0];
+		Rank r = square_rank(sq) + offsets[i][1];
+		if (r >= 0 && f >= 0 && r <= RANK_MAX && f <= FILE_MAX) {
+			bb |= square_to_bb(square_new(f, r));
+		}
+	}
+	return bb;
+}
+
+static Bitboard
+slider_attacks(Square sq, Bitboard occupancy, const short delta[4][2])
+{
+	Bitboard bb = 0;
+	for (int i = 0; i < 4; i++) {
+		const int df = delta[i][0];
+		const int dr = delta[i][1];
+		File file = square_file(sq) + df;
+		Rank rank = square_rank(sq) + dr;
+		while (file >= 0 && file < 8 && rank >= 0 && rank < 8) {
+			bb |= square_to_bb(square_new(file, rank));
+			if (square_to_bb(square_new(file, rank)) & occupancy) {
+				break;
+			}
+			rank += dr;
+			file += df;
+		}
+	}
+	return bb;
+}
+
+Bitboard
+threats_by_king_no_init(Square sq)
+{
+	const short OFFSETS_KING[8][2] = {
+		{ -1, -1 }, { 0, -1 }, { 1, -1 }, { -1, 0 },
+		{ 1, 0 },   { -1, 1 }, { 0, 1 },  { 1, 1 },
+	};
+	return leaper_attacks(sq, OFFSETS_KING);
+}
+
+Bitboard
+threats_by_knight_no_init(Square sq)
+{
+	// Keep in mind that both knights and kings can move in 8 different directions.
+	const short OFFSETS_KNIGHT[8][2] = {
+		{ -2, -1 }, { -2, 1 }, { 2, -1 }, { 2, 1 },
+		{ -1, -2 }, { -1, 2 }, { 1, -2 }, { 1, 2 },
+	};
+	return leaper_attacks(sq, OFFSETS_KNIGHT);
+}
+
+Bitboard
+threats_by_rook_no_init(Square sq, Bitboard occupancy)
+{
+	const short OFFSETS_ROOK[4][2] = { { 1, 0 }, { 0, 1 }, { 0, -1 }, { -1, 0 } };
+	return slider_attacks(sq, occupancy, OFFSETS_ROOK);
+}
+
+Bitboard
+threats_by_bishop_no_init(Square sq, Bitboard occupancy)
+{
+	const short OFFSETS_BISHOP[4][2] = { { 1, -1 }, { -1, 1 }, { 1, 1 }, { -1, -1 } };
+	return slider_attacks(sq, occupancy, OFFSETS_BISHOP);
+}
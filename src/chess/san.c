@@ -0,0 +1,116 @@
+/* SPDX-License-Identifier: GPL-3.0-only */
+
+#include "chess/san.h"
+#include "chess/coordinates.h"
+#include "chess/move.h"
+#include "chess/movegen.h"
+#include "chess/pieces.h"
+#include "chess/position.h"
+#include <assert.h>
+#include <stdbool.h>
+#include <string.h>
+
+static size_t
+san_castling_side(const char *str, int *castling_side)
+{
+	// Both letters and zeros are common in the wild.
+	if (strncmp(str, "O-O-O", 5) == 0 || strncmp(str, "0-0-0", 5) == 0) {
+		*castling_side = CASTLING_RIGHT_QUEENSIDE;
+		return 5;
+	} else if (strncmp(str, "O-O", 3) == 0 || strncmp(str, "0-0", 3) == 0) {
+		*castling_side = CASTLING_RIGHT_KINGSIDE;
+		return 3;
+	}
+	return 0;
+}
+
+size_t
+string_to_move_san(const char *str, struct Board *pos, struct Move *mv)
+{
+	assert(str);
+	assert(pos);
+	assert(mv);
+	const char *ptr = str;
+	int castling_side = CASTLING_RIGHT_NONE;
+	enum PieceType ptype = PIECE_TYPE_PAWN;
+	File source_file = FILE_NONE;
+	Rank source_rank = RANK_NONE;
+	Square target = SQUARE_NONE;
+	enum PieceType promotion = PIECE_TYPE_NONE;
+	ptr += san_castling_side(ptr, &castling_side);
+	if (!castling_side) {
+		if (strchr("NBRQK", *ptr) && *ptr) {
+			ptype = char_to_piece(*ptr++).type;
+		}
+		// Up to two disambiguation characters, then the target square. We
+		// don't know which is which until we've seen all of them.
+		File files[3] = { FILE_NONE, FILE_NONE, FILE_NONE };
+		Rank ranks[3] = { RANK_NONE, RANK_NONE, RANK_NONE };
+		size_t coordinates_count = 0;
+		while (*ptr && coordinates_count < 3) {
+			if (*ptr >= 'a' && *ptr <= 'h') {
+				files[coordinates_count] = *ptr - 'a';
+				if (ptr[1] >= '1' && ptr[1] <= '8') {
+					ranks[coordinates_count] = *++ptr - '1';
+				}
+				coordinates_count++;
+			} else if (*ptr >= '1' && *ptr <= '8') {
+				ranks[coordinates_count++] = *ptr - '1';
+			} else if (*ptr != 'x' && *ptr != '-' && *ptr != ':') {
+				break;
+			}
+			ptr++;
+		}
+		if (coordinates_count == 0) {
+			return 0;
+		}
+		size_t last = coordinates_count - 1;
+		if (files[last] == FILE_NONE || ranks[last] == RANK_NONE) {
+			return 0;
+		}
+		target = square_new(files[last], ranks[last]);
+		for (size_t i = 0; i < last; i++) {
+			source_file = files[i] != FILE_NONE ? files[i] : source_file;
+			source_rank = ranks[i] != RANK_NONE ? ranks[i] : source_rank;
+		}
+		if (*ptr == '=' || (ptype == PIECE_TYPE_PAWN && strchr("NBRQ", *ptr) && *ptr)) {
+			ptr += *ptr == '=';
+			promotion = char_to_piece(*ptr).type;
+			if (promotion == PIECE_TYPE_NONE || promotion == PIECE_TYPE_KING ||
+			    promotion == PIECE_TYPE_PAWN) {
+				return 0;
+			}
+			ptr++;
+		}
+	}
+	// Check and checkmate indicators and annotations.
+	ptr += strspn(ptr, "+#!?");
+	struct Move moves[MAX_MOVES];
+	size_t moves_count = gen_legal_moves(moves, pos);
+	size_t matches_count = 0;
+	for (size_t i = 0; i < moves_count; i++) {
+		struct Move *candidate = moves + i;
+		if (castling_side) {
+			if (!candidate->castling || candidate->castling_side != castling_side) {
+				continue;
+			}
+		} else if (candidate->castling || candidate->target != target ||
+		           position_piece_at_square(pos, candidate->source).type != ptype ||
+		           (source_file != FILE_NONE &&
+		            square_file(candidate->source) != source_file) ||
+		           (source_rank != RANK_NONE &&
+		            square_rank(candidate->source) != source_rank) ||
+		           // Promotions without a piece are sloppy, but unambiguous.
+		           candidate->promotion != (promotion || !candidate->promotion
+		                                      ? promotion
+		                                      : PIECE_TYPE_QUEEN)) {
+			continue;
+		}
+		*mv = *candidate;
+		matches_count++;
+	}
+	if (matches_count != 1) {
+		return 0;
+	}
+	return ptr - str;
+}
@@ -1,12 +1,11 @@
 /* SPDX-License-Identifier: GPL-3.0-only */
 
 #include "agent.h"
-#include "base64/base64.h"
-#include "cJSON/cJSON.h"
 #include "chess/fen.h"
 #include "chess/movegen.h"
 #include "chess/position.h"
 #include "core/eval.h"
+#include "core/weights.h"
 #include "engine.h"
 #include "eval.h"
 #include "libpopcnt/libpopcnt.h"
@@ -20,31 +19,6 @@
 #include <stdlib.h>
 #include <string.h>
 
-size_t
-buffer_deserialize_from_json(int64_t buf[], cJSON *obj)
-{
-	/* TODO */
-	cJSON *obj_buf_width = cJSON_GetObjectItem(obj, "width");
-	cJSON *obj_buf_data = cJSON_GetObjectItem(obj, "data");
-	assert(obj_buf_width);
-	assert(obj_buf_data);
-	char *buf_data = obj_buf_data->valuestring;
-	return b64_decode(buf_data, strlen(buf_data), buf) / sizeof(int64_t);
-}
-
-cJSON *
-buffer_serialize_into_json(int64_t buf[], size_t width)
-{
-	char *buf_data = malloc(b64e_size(width * sizeof(int64_t)));
-	if (!buf_data) {
-		return NULL;
-	}
-	cJSON *obj = cJSON_CreateObject();
-	cJSON_AddNumberToObject(obj, "width", width);
-	cJSON_AddStringToObject(obj, "data", buf_data);
-	return obj;
-}
-
 enum
 {
 	AGENT_BUF_WIDTH = 128,
@@ -105,11 +79,38 @@ struct Agent
 	/* Input and output layers by rotation. */
 	int64_t buf_alpha[AGENT_BUF_WIDTH];
 	int64_t buf_bravo[AGENT_BUF_WIDTH];
-	/* Layers. */
-	int64_t filters_0[AGENT_L0_COMPRESSED_WIDTH];
-	int64_t weights_0_1[AGENT_L1_WIDTH][AGENT_L0_COMPRESSED_WIDTH];
-	int32_t thresholds_1[AGENT_L1_WIDTH];
-	int64_t inversions_1[AGENT_L1_COMPRESSED_WIDTH];
+	/* Layers. They point straight into the memory-mapped weights file and are
+	 * NULL until one gets loaded. */
+	struct Weights *weights;
+	const int64_t *filters_0;
+	/* `AGENT_L1_WIDTH` rows of `AGENT_L0_COMPRESSED_WIDTH` each. */
+	const int64_t *weights_0_1;
+	const int32_t *thresholds_1;
+	const int64_t *inversions_1;
+};
+
+/* Tensor names and sizes as they appear in weights files. */
+enum
+{
+	AGENT_TENSOR_FILTERS_0,
+	AGENT_TENSOR_WEIGHTS_0_1,
+	AGENT_TENSOR_THRESHOLDS_1,
+	AGENT_TENSOR_INVERSIONS_1,
+	AGENT_TENSORS_COUNT,
+};
+
+static const char *const AGENT_TENSOR_NAMES[AGENT_TENSORS_COUNT] = {
+	[AGENT_TENSOR_FILTERS_0] = "filters_0",
+	[AGENT_TENSOR_WEIGHTS_0_1] = "weights_0_1",
+	[AGENT_TENSOR_THRESHOLDS_1] = "thresholds_1",
+	[AGENT_TENSOR_INVERSIONS_1] = "inversions_1",
+};
+
+static const size_t AGENT_TENSOR_SIZES[AGENT_TENSORS_COUNT] = {
+	[AGENT_TENSOR_FILTERS_0] = AGENT_L0_COMPRESSED_WIDTH * sizeof(int64_t),
+	[AGENT_TENSOR_WEIGHTS_0_1] = AGENT_L1_WIDTH * AGENT_L0_COMPRESSED_WIDTH * sizeof(int64_t),
+	[AGENT_TENSOR_THRESHOLDS_1] = AGENT_L1_WIDTH * sizeof(int32_t),
+	[AGENT_TENSOR_INVERSIONS_1] = AGENT_L1_COMPRESSED_WIDTH * sizeof(int64_t),
 };
 //
 // void
@@ -138,6 +139,59 @@ agent_new(void)
 	}
 	return agent;
 }
+
+int
+agent_load_weights(struct Agent *agent, const char *path)
+{
+	assert(agent);
+	struct Weights *weights = weights_open(path);
+	if (!weights) {
+		return ERR_CODE_INVALID_WEIGHTS;
+	}
+	const void *tensors[AGENT_TENSORS_COUNT] = { NULL };
+	for (size_t i = 0; i < AGENT_TENSORS_COUNT; i++) {
+		size_t size = 0;
+		tensors[i] = weights_tensor(weights, AGENT_TENSOR_NAMES[i], &size);
+		if (!tensors[i] || size != AGENT_TENSOR_SIZES[i]) {
+			weights_close(weights);
+			return ERR_CODE_INVALID_WEIGHTS;
+		}
+	}
+	weights_close(agent->weights);
+	agent->weights = weights;
+	agent->filters_0 = tensors[AGENT_TENSOR_FILTERS_0];
+	agent->weights_0_1 = tensors[AGENT_TENSOR_WEIGHTS_0_1];
+	agent->thresholds_1 = tensors[AGENT_TENSOR_THRESHOLDS_1];
+	agent->inversions_1 = tensors[AGENT_TENSOR_INVERSIONS_1];
+	return ERR_CODE_NONE;
+}
+
+int
+agent_save_weights(const struct Agent *agent, FILE *stream)
+{
+	assert(agent);
+	if (!agent->weights) {
+		return ERR_CODE_INVALID_WEIGHTS;
+	}
+	const void *const tensors[AGENT_TENSORS_COUNT] = {
+		[AGENT_TENSOR_FILTERS_0] = agent->filters_0,
+		[AGENT_TENSOR_WEIGHTS_0_1] = agent->weights_0_1,
+		[AGENT_TENSOR_THRESHOLDS_1] = agent->thresholds_1,
+		[AGENT_TENSOR_INVERSIONS_1] = agent->inversions_1,
+	};
+	return weights_write(
+	  stream, AGENT_TENSOR_NAMES, tensors, AGENT_TENSOR_SIZES, AGENT_TENSORS_COUNT);
+}
+
+void
+agent_delete(struct Agent *agent)
+{
+	if (!agent) {
+		return;
+	}
+	weights_close(agent->weights);
+	free(agent);
+}
 //
 // void
 // agent_predict(struct Agent *agent, struct Board *pos)
@@ -149,7 +203,7 @@ agent_new(void)
 //	for (size_t i = 0; i < AGENT_L1_WIDTH; i++) {
 //		for (size_t j = 0; j < AGENT_L0_COMPRESSED_WIDTH; j++) {
 //			agent->buf_popcnt[j] = agent->layer_alpha[j] &
-// agent->weights_0_1[i][j];
+// agent->weights_0_1[i * AGENT_L0_COMPRESSED_WIDTH + j];
 //		}
 //		/* The activation point is fixed at half the number of incoming
 // connections. */ 		size_t popcount = 		  popcnt(agent->buffer,
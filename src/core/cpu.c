@@ -3,36 +3,269 @@
 #include "base64/base64.h"
 #include "cJSON/cJSON.h"
 #include "cache/cache.h"
+#include "chess/book.h"
 #include "chess/fen.h"
+#include "chess/history.h"
 #include "chess/mnemonics.h"
 #include "chess/movegen.h"
 #include "feature_flags.h"
 #include "chess/position.h"
 #include "core/eval.h"
+#include "core/pawns.h"
+#include "core/search.h"
 #include "core/sstack.h"
 #include "engine.h"
 #include "eval.h"
 #include "libpopcnt/libpopcnt.h"
-#include "mt-64/mt-64.h"
+#include "metrics.h"
 #include "utils.h"
 #include <assert.h>
 #include <float.h>
+#include <inttypes.h>
+#include <limits.h>
 #include <math.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#if ZULOID_ENABLE_SEARCH_DEBUGGING
+#define SSTACK_STATS_INC(stack, counter) ((stack)->stats.counter++)
+#else
+#define SSTACK_STATS_INC(stack, counter) ((void)0)
+#endif
+
+/* Scores beyond this are mates. */
+#define SCORE_MATE_BOUND (SCORE_MATE - SEARCH_MAX_DEPTH - 1)
+/* One centipawn. Searches with such a narrow window can only tell whether the
+ * score is above or below it, but they're much cheaper. */
+#define SEARCH_NULL_WINDOW 0.01
+
+enum
+{
+	/* Forward pruning only happens this close to the leaves... */
+	REVERSE_FUTILITY_MAX_DEPTH = 6,
+	FUTILITY_MAX_DEPTH = 3,
+	LATE_MOVE_PRUNING_MAX_DEPTH = 4,
+	/* ...and null moves and ProbCut only this far from them. */
+	NULL_MOVE_MIN_DEPTH = 3,
+	/* A single ply after passing is just the static evaluation of a reply,
+	 * which is too crude to cut anything. */
+	NULL_MOVE_MIN_CHILD_DEPTH = 2,
+	PROBCUT_MIN_DEPTH = 5,
+	PROBCUT_DEPTH_REDUCTION = 4,
+	/* Late move reductions skip the first few children, which are the most
+	 * likely to be best. */
+	LMR_MIN_DEPTH = 3,
+	LMR_MIN_CHILD_I = 2,
+	LMR_MAX_MOVES = 64,
+	KILLER_MOVES_COUNT = 2,
+};
+
+/* Margins, move counts and reductions of forward pruning, as set by
+ * `Config.selectivity`. */
+struct Selectivity
+{
+	float reverse_futility_margins[REVERSE_FUTILITY_MAX_DEPTH + 1];
+	float futility_margins[FUTILITY_MAX_DEPTH + 1];
+	/* Quiet moves after this many children are pruned. */
+	int late_move_counts[LATE_MOVE_PRUNING_MAX_DEPTH + 1];
+	/* ...if the static evaluation is this far below alpha. */
+	float late_move_margin;
+	float probcut_margin;
+	/* By depth. No null moves at all if 0. */
+	int null_move_reductions[SEARCH_MAX_DEPTH + 1];
+	/* Null move cutoffs at least this deep are verified by a reduced search
+	 * of the actual moves, in case of zugzwang. */
+	int null_move_verification_min_depth;
+	/* Late move reductions by depth and child index, growing with the
+	 * logarithm of both. */
+	uint8_t reductions[SEARCH_MAX_DEPTH + 1][LMR_MAX_MOVES];
+};
+
+void
+selectivity_init(struct Selectivity *sel, float selectivity)
+{
+	// The default of 0.5 leaves margins and reductions as they are, and 0
+	// turns them off altogether.
+	float scale = 2.0 * fminf(fmaxf(selectivity, 0.0), 1.0);
+	// Margins are in moves rather than pawns. King moves are never pruned,
+	// and reverse futility pruning looks at the king on its own, so they
+	// don't count.
+	float swing = eval_max_move_swing();
+	for (int depth = 0; depth <= REVERSE_FUTILITY_MAX_DEPTH; depth++) {
+		sel->reverse_futility_margins[depth] =
+		  scale ? 0.8 * depth * swing / scale : INFINITY;
+	}
+	for (int depth = 0; depth <= FUTILITY_MAX_DEPTH; depth++) {
+		sel->futility_margins[depth] = scale ? (0.5 + depth) * swing / scale : INFINITY;
+	}
+	for (int depth = 0; depth <= LATE_MOVE_PRUNING_MAX_DEPTH; depth++) {
+		sel->late_move_counts[depth] = scale ? (int)((3 + depth * depth) / scale) : INT_MAX;
+	}
+	sel->late_move_margin = scale ? swing / scale : INFINITY;
+	sel->probcut_margin = scale ? 2.0 * swing / scale : INFINITY;
+	for (int depth = 0; depth <= SEARCH_MAX_DEPTH; depth++) {
+		sel->null_move_reductions[depth] = (int)(scale * (2.0 + depth / 4.0));
+		for (int i = 0; i < LMR_MAX_MOVES; i++) {
+			float reduction = depth && i ? scale * logf(depth) * logf(i) / 2.0 : 0.0;
+			sel->reductions[depth][i] = (uint8_t)reduction;
+		}
+	}
+	// The less selective, the more verification.
+	sel->null_move_verification_min_depth = (int)(4.0 * (1.0 + scale));
+}
+
+/* Rough piece values for move ordering. Kings can't be captured, so their
+ * value only matters as attackers. */
+static const int MOVE_ORDERING_VALUES[PIECE_TYPE_QUEEN + 1] = {
+	[PIECE_TYPE_PAWN] = 1, [PIECE_TYPE_KNIGHT] = 3, [PIECE_TYPE_BISHOP] = 3,
+	[PIECE_TYPE_ROOK] = 5, [PIECE_TYPE_KING] = 10,  [PIECE_TYPE_QUEEN] = 9,
+};
+
+/* Most valuable victim, least valuable attacker. */
+static int
+move_mvv_lva(const struct Board *board, const struct Move *mv)
+{
+	int victim = MOVE_ORDERING_VALUES[PIECE_CODE_TYPE(board->squares[mv->target])];
+	int attacker = MOVE_ORDERING_VALUES[PIECE_CODE_TYPE(board->squares[mv->source])];
+	return victim * 16 - attacker;
+}
+
+static void
+moves_sort_by_mvv_lva(struct Move moves[], size_t count, const struct Board *board)
+{
+	int scores[MAX_MOVES];
+	for (size_t i = 0; i < count; i++) {
+		scores[i] = move_mvv_lva(board, moves + i);
+	}
+	// Insertion sort: there are only a handful of captures in most positions.
+	for (size_t i = 1; i < count; i++) {
+		struct Move mv = moves[i];
+		int score = scores[i];
+		size_t j = i;
+		for (; j > 0 && scores[j - 1] < score; j--) {
+			moves[j] = moves[j - 1];
+			scores[j] = scores[j - 1];
+		}
+		moves[j] = mv;
+		scores[j] = score;
+	}
+}
+
+/* Captures and promotions, which are never reduced nor pruned (and neither
+ * are checks). */
+static bool
+move_is_tactical(const struct Board *board, const struct Move *mv)
+{
+	return board->squares[mv->target] || mv->promotion ||
+	       (mv->target == board->en_passant_target &&
+	        PIECE_CODE_TYPE(board->squares[mv->source]) == PIECE_TYPE_PAWN);
+}
+
+/* Promotions and captures of more valuable pieces, which gain material even if
+ * the capturing piece is lost in return. */
+static bool
+move_wins_material(const struct Board *board, const struct Move *mv)
+{
+	int victim = MOVE_ORDERING_VALUES[PIECE_CODE_TYPE(board->squares[mv->target])];
+	int attacker = MOVE_ORDERING_VALUES[PIECE_CODE_TYPE(board->squares[mv->source])];
+	return mv->promotion || victim > attacker;
+}
+
+static bool
+move_gives_check(const struct Board *board, const struct Move *mv)
+{
+	struct Board child = *board;
+	struct Move copy = *mv;
+	position_do_move_and_flip(&child, &copy);
+	return position_is_check(&child);
+}
+
+/* Moves `mv` to the front of `moves`, keeping the others in order. Does
+ * nothing if it's not there. */
+static void
+moves_bring_to_front(struct Move moves[], size_t count, struct Move mv)
+{
+	for (size_t i = 0; i < count; i++) {
+		if (moves_eq(moves + i, &mv)) {
+			memmove(moves + 1, moves, i * sizeof(struct Move));
+			moves[0] = mv;
+			return;
+		}
+	}
+}
+
+/* Captures and promotions first, best victims first, followed by quiet moves
+ * in their original order. Returns the number of the former. */
+static int
+moves_order(struct Move moves[], size_t count, const struct Board *board)
+{
+	struct Move quiet_moves[MAX_MOVES];
+	size_t tactical_count = 0;
+	size_t quiet_count = 0;
+	for (size_t i = 0; i < count; i++) {
+		if (move_is_tactical(board, moves + i)) {
+			moves[tactical_count++] = moves[i];
+		} else {
+			quiet_moves[quiet_count++] = moves[i];
+		}
+	}
+	memcpy(moves + tactical_count, quiet_moves, quiet_count * sizeof(struct Move));
+	moves_sort_by_mvv_lva(moves, tactical_count, board);
+	return (int)tactical_count;
+}
+
 // State for search agents. It holds a game-tree several plies deep.
 struct SStack
 {
 	struct SStackPlieIter *plies;
+	// Both owned by the search, which runs on a single thread.
 	struct Cache *cache;
+	struct PawnTable *pawn_table;
+	const struct Selectivity *selectivity;
 	int desired_depth;
 	int plie_i;
+	// The deepest plie reached so far, leaves included.
+	int seldepth;
+#if !ZULOID_ENABLE_COPY_MAKE
 	struct Board board;
-	float alpha;
-	float beta;
+#endif
+	size_t nodes_count;
+	size_t max_nodes_count;
+	struct SearchSignals *signals;
+	// The game so far, followed by the current line.
+	struct History history;
+	// What a draw is worth to the side to move at the root.
+	float draw_score;
+	// Root moves with exact scores, i.e. `Config.multipv`.
+	int multipv;
+	// Triangular principal variation table: row `i` holds the best line found
+	// so far from plie `i`, and it's `desired_depth + 1` moves wide.
+	struct Move *pv;
+	int *pv_lengths;
+	// One line per root move, in move generation order.
+	struct SearchLine *root_lines;
+	// Where to send "info" lines, if anywhere.
+	FILE *output;
+#if ZULOID_ENABLE_SEARCH_DEBUGGING
+	// Counters for this search only, so there's no sharing between threads.
+	struct SearchStats stats;
+#endif
+};
+
+/* Plies go through their children in stages, and each stage may settle the
+ * score of the plie before the next one. */
+enum PlieStage
+{
+	// The side to move passes. If that's still good enough for a cutoff,
+	// actual moves are bound to be.
+	PLIE_STAGE_NULL_MOVE,
+	// The actual moves at the depth of the null move, to confirm its cutoff.
+	PLIE_STAGE_VERIFICATION,
+	// Captures and promotions, with a shallow search against a raised beta.
+	PLIE_STAGE_PROBCUT,
+	PLIE_STAGE_MOVES,
 };
 
 struct SStackPlieIter
@@ -40,24 +273,39 @@ struct SStackPlieIter
 	int best_child_i_so_far;
 	float best_eval_so_far;
 	float multiplier;
+	// Plies left to search. Children are leaves once there are none left.
+	int depth;
+	// From the point of view of the side to move, like the static evaluation.
+	float alpha;
+	float beta;
+	float static_eval;
+	// Forward pruning trusts the static evaluation only if it's not about to
+	// change by a capture or a promotion.
+	bool quiet;
+	// Exact scores only matter along principal variations, so there's no
+	// forward pruning there.
+	bool pv;
+	bool in_check;
+	enum PlieStage stage;
+	// Captures and promotions come first, and there are this many. Then come
+	// the killer moves: the last quiet moves to cause a cutoff at this plie,
+	// most recent first, which are likely to refute siblings too.
+	int tactical_count;
+	struct Move killers[KILLER_MOVES_COUNT];
+	// The current stage needs no more children.
+	bool cutoff;
+	// Depth and window of the current child, once decided. Reduced and
+	// null-window searches are repeated in full if they fail high.
+	bool child_ready;
+	int child_depth;
+	float child_alpha;
+	float child_beta;
+	bool child_pv;
 	struct PlieIter iter;
-};
-
-typedef void (*DfsDebugger)(const struct SStack *stack, const struct SStackPlieIter *plie);
-
-void
-debugger_do_nothing(const struct SStack *stack, const struct SStackPlieIter *plie) {
-	UNUSED(stack);
-	UNUSED(plie);
-	struct Move m2;
-	string_to_move("d5e3", &m2);
-	if (moves_eq(&stack->plies[1].iter.generator, &m2)) {
-		//puts("lol");
-	}
-}
-
-const DfsDebugger DEBUGGERS[] = {
-	debugger_do_nothing
+#if ZULOID_ENABLE_COPY_MAKE
+	// The position reached by `iter.generator`.
+	struct Board board;
+#endif
 };
 
 void
@@ -66,6 +314,8 @@ ssplieiter_reset(struct SStackPlieIter *plie)
 	plie->best_child_i_so_far = -1;
 	plie->best_eval_so_far = -1000000.0;
 	plie->iter.child_i = 0;
+	plie->cutoff = false;
+	plie->child_ready = false;
 }
 
 void
@@ -73,6 +323,31 @@ ssplieiter_init(struct SStackPlieIter *plie)
 {
 	plieiter_init(&plie->iter);
 	ssplieiter_reset(plie);
+	plie->stage = PLIE_STAGE_MOVES;
+}
+
+/* Starts over with the children of `stage`. */
+static void
+ssplieiter_set_stage(struct SStackPlieIter *plie, enum PlieStage stage)
+{
+	ssplieiter_reset(plie);
+	plie->stage = stage;
+}
+
+static bool
+ssplieiter_has_next(const struct SStackPlieIter *plie)
+{
+	if (plie->cutoff) {
+		return false;
+	}
+	switch (plie->stage) {
+		case PLIE_STAGE_NULL_MOVE:
+			return plie->iter.child_i == 0;
+		case PLIE_STAGE_PROBCUT:
+			return plie->iter.child_i < plie->tactical_count;
+		default:
+			return plieiter_has_next(&plie->iter);
+	}
 }
 
 void
@@ -85,33 +360,68 @@ ssplieiter_supply_eval(struct SStackPlieIter *plie, float eval)
 	plie->iter.child_i++;
 }
 
-unsigned
-depth_from_times(float wtime, float btime)
+struct Board *
+sstack_board(struct SStack *stack)
 {
-	UNUSED(wtime);
-	UNUSED(btime);
-	return 4; // TODO, this is a good default for now.
+#if ZULOID_ENABLE_COPY_MAKE
+	return &stack->plies[stack->plie_i].board;
+#else
+	return &stack->board;
+#endif
 }
 
 struct SStack
-sstack_new(const struct Engine *engine)
+sstack_new(const struct Board *board,
+           const struct History *history,
+           int desired_depth,
+           FILE *output)
 {
 	struct SStack stack;
-	unsigned max_depth =
-	  depth_from_times(engine->time_controls[COLOR_WHITE]->time_limit_in_seconds,
-	                   engine->time_controls[COLOR_BLACK]->time_limit_in_seconds);
-	stack.plies = exit_if_null(malloc((max_depth + 1) * sizeof(struct SStackPlieIter)));
-	stack.cache = engine->cache;
-	stack.desired_depth = max_depth;
+	stack.plies = exit_if_null(malloc((desired_depth + 1) * sizeof(struct SStackPlieIter)));
+	stack.cache = NULL;
+	stack.pawn_table = NULL;
+	stack.selectivity = NULL;
+	stack.desired_depth = desired_depth;
 	stack.plie_i = 0;
-	stack.board = engine->board;
-	for (unsigned i = 0; i <= max_depth; i++) {
+	stack.seldepth = 0;
+	for (int i = 0; i <= desired_depth; i++) {
+		for (int j = 0; j < KILLER_MOVES_COUNT; j++) {
+			stack.plies[i].killers[j] = MOVE_IDENTITY;
+		}
+	}
+#if ZULOID_ENABLE_COPY_MAKE
+	stack.plies[0].board = *board;
+#else
+	stack.board = *board;
+#endif
+	stack.nodes_count = 0;
+	stack.max_nodes_count = 0;
+	stack.signals = NULL;
+	history_init(&stack.history);
+	history_copy(&stack.history, history);
+	stack.draw_score = 0.0;
+	stack.multipv = 1;
+#if ZULOID_ENABLE_SEARCH_DEBUGGING
+	stack.stats = (struct SearchStats){ 0 };
+#endif
+	stack.pv = exit_if_null(
+	  malloc((desired_depth + 2) * (desired_depth + 1) * sizeof(struct Move)));
+	stack.pv_lengths = exit_if_null(calloc(desired_depth + 2, sizeof(int)));
+	stack.output = output;
+	for (int i = 0; i <= desired_depth; i++) {
 		ssplieiter_init(&stack.plies[i]);
 		stack.plies[i].multiplier =
-		  ((engine->board.side_to_move == COLOR_WHITE) ^ (i % 2 == 1)) ? 1.0 : -1.0;
+		  ((board->side_to_move == COLOR_WHITE) ^ (i % 2 == 1)) ? 1.0 : -1.0;
 	}
-	stack.plies[0].iter.children_count =
-	  gen_legal_moves(stack.plies[0].iter.moves, &stack.board);
+	struct SStackPlieIter *root = stack.plies;
+	root->depth = desired_depth + 1;
+	root->alpha = -INFINITY;
+	root->beta = INFINITY;
+	root->pv = true;
+	root->in_check = position_is_check(sstack_board(&stack));
+	root->iter.children_count = gen_legal_moves(root->iter.moves, sstack_board(&stack));
+	stack.root_lines =
+	  exit_if_null(malloc((root->iter.children_count + 1) * sizeof(struct SearchLine)));
 	return stack;
 }
 
@@ -122,6 +432,10 @@ sstack_delete(struct SStack *stack)
 		plieiter_delete(&stack->plies[i].iter);
 	}
 	free(stack->plies);
+	free(stack->pv);
+	free(stack->pv_lengths);
+	free(stack->root_lines);
+	history_delete(&stack->history);
 	stack->plies = NULL;
 }
 
@@ -131,31 +445,122 @@ sstack_last(struct SStack *stack)
 	return stack->plies + stack->plie_i;
 }
 
-const struct SStackPlieIter *
-sstack_last_const(const struct SStack *stack)
+struct Move *
+sstack_pv_row(struct SStack *stack, int plie_i)
 {
-	return stack->plies + stack->plie_i;
+	return stack->pv + plie_i * (stack->desired_depth + 1);
 }
 
+/* Root moves need exact scores until `multipv` of them are known, and then
+ * only if they beat the worst of those. */
+static float
+sstack_root_alpha(const struct SStack *stack)
+{
+	const struct SearchLine *lines = stack->root_lines;
+	int lines_count = stack->plies[0].iter.child_i;
+	float alpha = -INFINITY;
+	for (int i = 0; i < lines_count; i++) {
+		int better_count = 0;
+		for (int j = 0; j < lines_count; j++) {
+			better_count += lines[j].centipawns >= lines[i].centipawns;
+		}
+		if (better_count >= stack->multipv && lines[i].centipawns > alpha) {
+			alpha = lines[i].centipawns;
+		}
+	}
+	return alpha;
+}
 
-void
-sstack_print_lines(struct SStack *stack)
+/* The window of the current stage of the last plie, from its point of view. */
+static void
+sstack_window(const struct SStack *stack, float *alpha, float *beta)
 {
-	printf("  info line");
-	for (int i = 1; i < stack->desired_depth; i++) {
-		char buf[6] = { '\0' };
-		move_to_string(stack->plies[i].iter.moves[stack->plies[i].best_child_i_so_far],
-		               buf);
-		printf(" %s", buf);
+	const struct SStackPlieIter *plie = stack->plies + stack->plie_i;
+	*beta = plie->beta;
+	switch (plie->stage) {
+		case PLIE_STAGE_NULL_MOVE:
+		case PLIE_STAGE_VERIFICATION:
+			break;
+		case PLIE_STAGE_PROBCUT:
+			*beta += stack->selectivity->probcut_margin;
+			break;
+		default:
+			*alpha = stack->plie_i == 0 ? sstack_root_alpha(stack)
+			                            : fmaxf(plie->alpha, plie->best_eval_so_far);
+			return;
 	}
-	puts("");
+	*alpha = *beta - SEARCH_NULL_WINDOW;
 }
 
+/* Supplies the score of `mv`, i.e. the next child of the last plie. The
+ * principal variation of the last plie is then `mv` followed by that of the
+ * child. */
 void
-sstack_run_debuggers(const struct SStack *stack, const DfsDebugger debuggers[], unsigned count) {
-	const struct SStackPlieIter *last_plie = sstack_last_const(stack);
-	for (unsigned i = 0; i < count; i++) {
-		debuggers[i](stack, last_plie);
+sstack_supply_eval(struct SStack *stack, struct Move mv, float eval)
+{
+	struct SStackPlieIter *plie = sstack_last(stack);
+	int child_i = plie->iter.child_i;
+	ssplieiter_supply_eval(plie, eval);
+	int plie_i = stack->plie_i;
+	const struct Move *child_row = sstack_pv_row(stack, plie_i + 1);
+	int child_length = stack->pv_lengths[plie_i + 1];
+	// Earlier stages only decide whether to search the moves at all.
+	if (plie->stage == PLIE_STAGE_MOVES && plie->best_child_i_so_far == child_i) {
+		struct Move *row = sstack_pv_row(stack, plie_i);
+		row[0] = mv;
+		memcpy(row + 1, child_row, child_length * sizeof(struct Move));
+		stack->pv_lengths[plie_i] = child_length + 1;
+	}
+	// Root moves keep their own lines for MultiPV.
+	if (plie_i == 0) {
+		struct SearchLine *line = stack->root_lines + child_i;
+		line->centipawns = eval;
+		line->pv[0] = mv;
+		memcpy(line->pv + 1, child_row, child_length * sizeof(struct Move));
+		line->pv_length = child_length + 1;
+	}
+}
+
+/* Same as `sstack_supply_eval`, unless the child was searched with a reduced
+ * depth or a null window and it failed high. It's then set up to be searched
+ * again: first at full depth with the same window, which most reduced children
+ * fail low on after all, and only then with the full window. */
+static void
+sstack_supply_child_eval(struct SStack *stack, struct Move mv, float eval)
+{
+	struct SStackPlieIter *plie = sstack_last(stack);
+	float alpha, beta;
+	sstack_window(stack, &alpha, &beta);
+	if (plie->stage == PLIE_STAGE_MOVES && eval > plie->child_alpha) {
+		if (plie->child_depth < plie->depth - 1) {
+			SSTACK_STATS_INC(stack, reduction_researches_count);
+			plie->child_depth = plie->depth - 1;
+			return;
+		} else if (plie->child_beta < beta && eval < beta) {
+			SSTACK_STATS_INC(stack, researches_count);
+			plie->child_alpha = alpha;
+			plie->child_beta = beta;
+			plie->child_pv = plie->pv;
+			return;
+		}
+	}
+	plie->child_ready = false;
+	sstack_supply_eval(stack, mv, eval);
+	if (plie->best_eval_so_far >= beta) {
+		plie->cutoff = true;
+		if (plie->stage != PLIE_STAGE_MOVES) {
+			return;
+		}
+		SSTACK_STATS_INC(stack, beta_cutoffs_count);
+		if (plie->best_child_i_so_far == 0) {
+			SSTACK_STATS_INC(stack, first_move_cutoffs_count);
+		}
+		if (!move_is_tactical(sstack_board(stack), &mv) && !moves_eq(&plie->killers[0], &mv)) {
+			memmove(plie->killers + 1,
+			        plie->killers,
+			        (KILLER_MOVES_COUNT - 1) * sizeof(struct Move));
+			plie->killers[0] = mv;
+		}
 	}
 }
 
@@ -165,133 +570,844 @@ score_to_centipawns(float score)
 	return (int)(score * 100);
 }
 
+int
+score_to_mate_in_moves(float score)
+{
+	float abs_score = fabsf(score);
+	if (abs_score <= SCORE_MATE - SEARCH_MAX_DEPTH - 1) {
+		return 0;
+	}
+	// UCI counts mates in moves, not plies.
+	int plies = (int)roundf(SCORE_MATE - abs_score);
+	int moves = (plies + 1) / 2;
+	return score > 0 ? moves : -moves;
+}
+
 void
-sstack_log(const struct SStack *stack)
+sstack_log(struct SStack *stack)
 {
 	for (int i = 0; i <= stack->plie_i; i++) {
 		char buf[6] = { '\0' };
 		move_to_string(stack->plies[i].iter.generator, buf);
 		printf("%d %s %d\n", i, buf, stack->plies[i].iter.children_count);
 	}
-	position_pprint(&stack->board, stdout);
+	position_pprint(sstack_board(stack), stdout);
+}
+
+/* Draw scores are from the point of view of the side to move at `plie_i`. */
+float
+sstack_draw_score(const struct SStack *stack, int plie_i)
+{
+	return plie_i % 2 == 0 ? stack->draw_score : -stack->draw_score;
 }
 
 void
 sstack_pop(struct SStack *stack)
 {
-	sstack_run_debuggers(stack, DEBUGGERS, ARRAY_SIZE(DEBUGGERS));
 	struct SStackPlieIter *last_plie = sstack_last(stack);
 	float eval = last_plie->best_eval_so_far;
-	position_undo_move_and_flip(&stack->board, &last_plie->iter.generator);
+#if !ZULOID_ENABLE_COPY_MAKE
+	if ((last_plie - 1)->stage == PLIE_STAGE_NULL_MOVE) {
+		position_undo_null_move(&stack->board, &last_plie->iter.generator);
+	} else {
+		position_undo_move_and_flip(&stack->board, &last_plie->iter.generator);
+	}
+#endif
+	history_pop(&stack->history);
 	stack->plie_i--;
-	last_plie--;
-	ssplieiter_supply_eval(last_plie, -eval);
-	if (stack->plie_i == 0) {
-		char buf[6] = { '\0' };
-		move_to_string((last_plie + 1)->iter.generator, buf);
-		printf("info depth 0 nodes %u currmove %s score cp %d\n",
-		       0,
-		       buf,
-		       score_to_centipawns(eval));
+	sstack_supply_child_eval(stack, last_plie->iter.generator, -eval);
+}
+
+/* The static evaluation of `board`, from White's point of view. The same
+ * leaves come up again and again across iterations and transpositions, so
+ * evaluations are cached. */
+float
+sstack_eval_static(struct SStack *stack, const struct Board *board)
+{
+	struct CacheEntry *entry = stack->cache ? cache_get(stack->cache, board) : NULL;
+	if (entry && !cache_entry_is_empty(entry)) {
+		SSTACK_STATS_INC(stack, eval_cache_hits_count);
+		return entry->evaluation;
+	}
+	float eval = position_eval_with_pawn_table(board, stack->pawn_table);
+	if (entry) {
+		*entry = (struct CacheEntry){ .evaluation = eval, .dispersion = 0.0 };
+	}
+	return eval;
+}
+
+/* The stage that follows null move pruning, or that comes first without it. */
+static enum PlieStage
+sstack_stage_after_null_move(const struct SStack *stack)
+{
+	const struct SStackPlieIter *plie = stack->plies + stack->plie_i;
+	if (plie->depth >= PROBCUT_MIN_DEPTH && plie->tactical_count > 0 &&
+	    plie->beta + stack->selectivity->probcut_margin < SCORE_MATE_BOUND) {
+		return PLIE_STAGE_PROBCUT;
+	}
+	return PLIE_STAGE_MOVES;
+}
+
+/* Sets up the last plie right after it's pushed, unless its static evaluation
+ * is so far above beta that it's cut short (reverse futility pruning). */
+static void
+sstack_enter(struct SStack *stack)
+{
+	struct SStackPlieIter *plie = sstack_last(stack);
+	const struct Selectivity *sel = stack->selectivity;
+	struct Board *board = sstack_board(stack);
+	plie->tactical_count = moves_order(plie->iter.moves, plie->iter.children_count, board);
+	for (int i = KILLER_MOVES_COUNT - 1; i >= 0; i--) {
+		moves_bring_to_front(plie->iter.moves + plie->tactical_count,
+		                     plie->iter.children_count - plie->tactical_count,
+		                     plie->killers[i]);
+	}
+	plie->in_check = position_is_check(board);
+	plie->static_eval =
+	  plie->in_check ? -SCORE_MATE : sstack_eval_static(stack, board) * plie->multiplier;
+	plie->stage = PLIE_STAGE_MOVES;
+	plie->quiet = !plie->in_check;
+	for (int i = 0; i < plie->tactical_count && plie->quiet; i++) {
+		plie->quiet = !move_wins_material(board, plie->iter.moves + i);
+	}
+	if (plie->pv || plie->in_check || fabsf(plie->beta) >= SCORE_MATE_BOUND) {
+		return;
+	}
+	int depth = plie->depth;
+	if (depth <= REVERSE_FUTILITY_MAX_DEPTH && plie->quiet &&
+	    plie->static_eval - sel->reverse_futility_margins[depth] >= plie->beta) {
+		// The margins leave king steps out, but the opponent's next one might
+		// well be its reply.
+		enum Color opponent = color_other(board->side_to_move);
+		float margin =
+		  sel->reverse_futility_margins[depth] + eval_king_step_gain(board, opponent);
+		if (plie->static_eval - margin >= plie->beta) {
+			SSTACK_STATS_INC(stack, pruned_nodes_count);
+			plie->best_eval_so_far = plie->static_eval;
+			sstack_pop(stack);
+			return;
+		}
+	}
+	// Without pieces other than pawns, passing might well be the best move
+	// (zugzwang), and two null moves in a row are pointless.
+	Bitboard pieces = board->bb[board->side_to_move] &
+	                  ~(board->bb[PIECE_TYPE_PAWN] | board->bb[PIECE_TYPE_KING]);
+	if (depth >= NULL_MOVE_MIN_DEPTH && sel->null_move_reductions[depth] > 0 && pieces &&
+	    plie->static_eval >= plie->beta && (plie - 1)->stage != PLIE_STAGE_NULL_MOVE) {
+		SSTACK_STATS_INC(stack, null_moves_count);
+		plie->stage = PLIE_STAGE_NULL_MOVE;
+	} else {
+		plie->stage = sstack_stage_after_null_move(stack);
 	}
 }
 
 void
 sstack_push(struct SStack *stack)
 {
-	struct SStackPlieIter *last_plie = sstack_last(stack);
-	assert(plieiter_has_next(&last_plie->iter));
-	struct Move generator = last_plie->iter.moves[last_plie->iter.child_i];
+	struct SStackPlieIter *parent = sstack_last(stack);
+	assert(ssplieiter_has_next(parent));
+	bool is_null_move = parent->stage == PLIE_STAGE_NULL_MOVE;
+	struct Move generator =
+	  is_null_move ? MOVE_IDENTITY : parent->iter.moves[parent->iter.child_i];
 	stack->plie_i++;
-	last_plie++;
+	stack->nodes_count++;
+	if (stack->plie_i > stack->seldepth) {
+		stack->seldepth = stack->plie_i;
+	}
+	struct SStackPlieIter *last_plie = parent + 1;
 	ssplieiter_reset(last_plie);
 	last_plie->iter.generator = generator;
-	position_do_move_and_flip(&stack->board, &last_plie->iter.generator);
-	last_plie->iter.children_count = gen_legal_moves(last_plie->iter.moves, &stack->board);
-	switch (last_plie->iter.children_count) {
-		case 0: // stalemate
-			last_plie->best_eval_so_far = 0.0;
-			sstack_pop(stack);
+	last_plie->depth = parent->child_depth;
+	last_plie->alpha = -parent->child_beta;
+	last_plie->beta = -parent->child_alpha;
+	last_plie->pv = parent->child_pv;
+	stack->pv_lengths[stack->plie_i] = 0;
+#if ZULOID_ENABLE_COPY_MAKE
+	last_plie->board = parent->board;
+#endif
+	struct Board *board = sstack_board(stack);
+	if (is_null_move) {
+		position_do_null_move(board, &last_plie->iter.generator);
+	} else {
+		position_do_move_and_flip(board, &last_plie->iter.generator);
+	}
+	history_push(&stack->history, board->hash);
+	// Cycles are cut short: there's nothing to gain from searching them again.
+	if (history_is_repetition(&stack->history, board->reversible_moves_count)) {
+		SSTACK_STATS_INC(stack, draws_count);
+		last_plie->iter.children_count = 0;
+		last_plie->best_eval_so_far = sstack_draw_score(stack, stack->plie_i);
+		sstack_pop(stack);
+		return;
+	}
+	last_plie->iter.children_count = gen_legal_moves(last_plie->iter.moves, board);
+	if (last_plie->iter.children_count == 0) {
+		SSTACK_STATS_INC(stack, terminal_nodes_count);
+		// Checkmate or stalemate. Quicker mates score higher.
+		last_plie->best_eval_so_far = position_is_check(board)
+		                                ? -(SCORE_MATE - stack->plie_i)
+		                                : sstack_draw_score(stack, stack->plie_i);
+		sstack_pop(stack);
+	} else if (board->reversible_moves_count >= FIFTY_MOVES_RULE_PLIES) {
+		SSTACK_STATS_INC(stack, draws_count);
+		last_plie->iter.children_count = 0;
+		last_plie->best_eval_so_far = sstack_draw_score(stack, stack->plie_i);
+		sstack_pop(stack);
+	} else {
+		SSTACK_STATS_INC(stack, interior_nodes_count);
+		sstack_enter(stack);
+	}
+}
+
+/* Searches captures from `board`, `plie_i` plies from the root and `qplie_i`
+ * from the leaf, until there are none left that beat the static evaluation.
+ * From the point of view of the side to move, like `position_quiesce`, but
+ * with the caches of the search. */
+static float
+sstack_quiesce(
+  struct SStack *stack, struct Board *board, float alpha, float beta, int plie_i, int qplie_i)
+{
+	if (plie_i > stack->seldepth) {
+		stack->seldepth = plie_i;
+	}
+	float sign = board->side_to_move == COLOR_WHITE ? 1.0 : -1.0;
+	float stand_pat = sstack_eval_static(stack, board) * sign;
+	if (stand_pat >= beta || qplie_i >= QUIESCENCE_MAX_PLIES) {
+		return stand_pat;
+	} else if (stand_pat > alpha) {
+		alpha = stand_pat;
+	}
+	struct Move moves[MAX_MOVES];
+	size_t captures_count = gen_attacks_against_from(moves,
+	                                                 board,
+	                                                 board->bb[color_other(board->side_to_move)],
+	                                                 board->side_to_move,
+	                                                 board->en_passant_target,
+	                                                 false);
+	moves_sort_by_mvv_lva(moves, captures_count, board);
+	for (size_t i = 0; i < captures_count && alpha < beta; i++) {
+#if ZULOID_ENABLE_COPY_MAKE
+		struct Board child_board = *board;
+		struct Board *child = &child_board;
+#else
+		struct Board *child = board;
+#endif
+		position_do_move_and_flip(child, moves + i);
+		if (!position_is_illegal(child)) {
+			stack->nodes_count++;
+			SSTACK_STATS_INC(stack, qnodes_count);
+			float score = -sstack_quiesce(stack, child, -beta, -alpha, plie_i + 1, qplie_i + 1);
+			if (score > alpha) {
+				alpha = score;
+			}
+		}
+#if !ZULOID_ENABLE_COPY_MAKE
+		position_undo_move_and_flip(child, moves + i);
+#endif
+	}
+	return alpha;
+}
+
+/* Evaluates the next child of the last plie, from the point of view of the
+ * side to move at the last plie. Leaves are only as good as they are quiet, so
+ * it takes a quiescence search. */
+float
+sstack_eval_leaf(struct SStack *stack)
+{
+	struct SStackPlieIter *leaf = sstack_last(stack);
+	struct Move *mv = &leaf->iter.moves[leaf->iter.child_i];
+#if ZULOID_ENABLE_COPY_MAKE
+	struct Board child = *sstack_board(stack);
+	struct Board *board = &child;
+#else
+	struct Board *board = sstack_board(stack);
+#endif
+	position_do_move_and_flip(board, mv);
+	history_push(&stack->history, board->hash);
+	float eval;
+	SSTACK_STATS_INC(stack, leaves_count);
+	if (board->reversible_moves_count >= FIFTY_MOVES_RULE_PLIES ||
+	    history_is_repetition(&stack->history, board->reversible_moves_count)) {
+		SSTACK_STATS_INC(stack, draws_count);
+		eval = sstack_draw_score(stack, stack->plie_i);
+	} else {
+		eval = -sstack_quiesce(
+		  stack, board, -leaf->child_beta, -leaf->child_alpha, stack->plie_i + 1, 0);
+	}
+	history_pop(&stack->history);
+#if !ZULOID_ENABLE_COPY_MAKE
+	position_undo_move_and_flip(board, mv);
+#endif
+	return eval;
+}
+
+/* Decides the depth and window of the next child of the last plie. */
+static void
+sstack_prepare_child(struct SStack *stack)
+{
+	struct SStackPlieIter *plie = sstack_last(stack);
+	const struct Selectivity *sel = stack->selectivity;
+	float alpha, beta;
+	sstack_window(stack, &alpha, &beta);
+	plie->child_ready = true;
+	plie->child_alpha = alpha;
+	plie->child_beta = beta;
+	plie->child_pv = false;
+	switch (plie->stage) {
+		case PLIE_STAGE_NULL_MOVE:
+		case PLIE_STAGE_VERIFICATION:
+			plie->child_depth = plie->depth - 1 - sel->null_move_reductions[plie->depth];
+			if (plie->child_depth < NULL_MOVE_MIN_CHILD_DEPTH) {
+				plie->child_depth = NULL_MOVE_MIN_CHILD_DEPTH;
+			}
+			return;
+		case PLIE_STAGE_PROBCUT:
+			plie->child_depth = plie->depth - PROBCUT_DEPTH_REDUCTION;
+			return;
+		default:
 			break;
-		case -1: // checkmate
-			last_plie->best_eval_so_far = last_plie->multiplier * 100000;
-			sstack_pop(stack);
+	}
+	plie->child_depth = plie->depth - 1;
+	int child_i = plie->iter.child_i;
+	if (child_i == 0 || alpha == -INFINITY) {
+		plie->child_pv = plie->pv;
+		return;
+	}
+	// Principal variation search: later children are expected to fail low,
+	// which takes no more than a null window to tell.
+	if (plie->pv) {
+		plie->child_beta = alpha + SEARCH_NULL_WINDOW;
+	}
+	const struct Move *mv = plie->iter.moves + child_i;
+	const struct Board *board = sstack_board(stack);
+	if (stack->plie_i == 0 || plie->in_check || plie->depth < LMR_MIN_DEPTH ||
+	    child_i < LMR_MIN_CHILD_I || move_is_tactical(board, mv) ||
+	    move_gives_check(board, mv)) {
+		return;
+	}
+	int moves_count = child_i < LMR_MAX_MOVES ? child_i : LMR_MAX_MOVES - 1;
+	// Children along principal variations are reduced less.
+	int reduction = sel->reductions[plie->depth][moves_count] - plie->pv;
+	if (reduction > plie->child_depth - 1) {
+		reduction = plie->child_depth - 1;
+	}
+	if (reduction > 0) {
+		SSTACK_STATS_INC(stack, reductions_count);
+		plie->child_depth -= reduction;
+	}
+}
+
+/* Futility and late move pruning: skips the next child of the last plie if
+ * it's a quiet move that's unlikely to raise alpha, given the static
+ * evaluation and how late it comes. */
+static bool
+sstack_prune_next(struct SStack *stack)
+{
+	struct SStackPlieIter *plie = sstack_last(stack);
+	if (plie->stage != PLIE_STAGE_MOVES || plie->pv || !plie->quiet) {
+		return false;
+	}
+	const struct Selectivity *sel = stack->selectivity;
+	float alpha, beta;
+	sstack_window(stack, &alpha, &beta);
+	int depth = plie->depth;
+	// Quiet moves come in no particular order, so lateness alone says little:
+	// it also takes a static evaluation that a single move can't lift to alpha.
+	bool is_late = depth <= LATE_MOVE_PRUNING_MAX_DEPTH &&
+	               plie->iter.child_i >= sel->late_move_counts[depth] &&
+	               plie->static_eval + sel->late_move_margin <= alpha;
+	bool is_futile = depth <= FUTILITY_MAX_DEPTH &&
+	                 plie->static_eval + sel->futility_margins[depth] <= alpha;
+	if ((!is_late && !is_futile) || fabsf(alpha) >= SCORE_MATE_BOUND) {
+		return false;
+	}
+	const struct Board *board = sstack_board(stack);
+	const struct Move *mv = plie->iter.moves + plie->iter.child_i;
+	// King steps are worth more to the evaluation than any margin.
+	if (move_is_tactical(board, mv) ||
+	    PIECE_CODE_TYPE(board->squares[mv->source]) == PIECE_TYPE_KING ||
+	    move_gives_check(board, mv)) {
+		return false;
+	}
+	SSTACK_STATS_INC(stack, pruned_moves_count);
+	// Whatever the move is worth, it's assumed not to be above alpha.
+	plie->best_eval_so_far = fmaxf(plie->best_eval_so_far, alpha);
+	plie->iter.child_i++;
+	return true;
+}
+
+/* Searches the next child of the last plie, unless it's pruned. */
+static void
+sstack_search_next(struct SStack *stack)
+{
+	struct SStackPlieIter *plie = sstack_last(stack);
+	if (!plie->child_ready) {
+		if (sstack_prune_next(stack)) {
+			return;
+		}
+		sstack_prepare_child(stack);
+	}
+	if (plie->child_depth > 0) {
+		sstack_push(stack);
+		return;
+	}
+	stack->nodes_count++;
+	if (stack->plie_i + 1 > stack->seldepth) {
+		stack->seldepth = stack->plie_i + 1;
+	}
+	stack->pv_lengths[stack->plie_i + 1] = 0;
+	float eval = sstack_eval_leaf(stack);
+	sstack_supply_child_eval(stack, plie->iter.moves[plie->iter.child_i], eval);
+}
+
+/* Moves the last plie on to its next stage, once it's done with the current
+ * one. Returns false if the plie is done altogether instead. */
+static bool
+sstack_next_stage(struct SStack *stack)
+{
+	struct SStackPlieIter *plie = sstack_last(stack);
+	const struct Selectivity *sel = stack->selectivity;
+	float eval = plie->best_eval_so_far;
+	switch (plie->stage) {
+		case PLIE_STAGE_NULL_MOVE:
+			if (eval < plie->beta) {
+				break;
+			}
+			SSTACK_STATS_INC(stack, null_move_cutoffs_count);
+			if (plie->depth >= sel->null_move_verification_min_depth) {
+				ssplieiter_set_stage(plie, PLIE_STAGE_VERIFICATION);
+				return true;
+			}
+			SSTACK_STATS_INC(stack, pruned_nodes_count);
+			// Passing can't possibly mate, so such scores are not to be
+			// trusted.
+			if (eval >= SCORE_MATE_BOUND) {
+				plie->best_eval_so_far = plie->beta;
+			}
+			return false;
+		case PLIE_STAGE_VERIFICATION:
+			if (eval >= plie->beta) {
+				SSTACK_STATS_INC(stack, pruned_nodes_count);
+				return false;
+			}
 			break;
+		case PLIE_STAGE_PROBCUT:
+			if (eval >= plie->beta + sel->probcut_margin) {
+				SSTACK_STATS_INC(stack, pruned_nodes_count);
+				return false;
+			}
+			ssplieiter_set_stage(plie, PLIE_STAGE_MOVES);
+			return true;
 		default:
-			break;
+			return false;
+	}
+	ssplieiter_set_stage(plie, sstack_stage_after_null_move(stack));
+	return true;
+}
+
+// Returns false if the search was interrupted before visiting the whole tree.
+bool
+sstack_run(struct SStack *stack)
+{
+	while (true) {
+		struct SStackPlieIter *last_plie = sstack_last(stack);
+		if (stack->max_nodes_count && stack->nodes_count >= stack->max_nodes_count) {
+			return false;
+		}
+		// Timers are relatively expensive, so we don't check them at every
+		// node.
+		if ((stack->nodes_count & 0x3ff) == 0 && stack->signals &&
+		    search_signals_should_stop(stack->signals)) {
+			return false;
+		}
+		// We use depth-first search (DFS) to explore the game tree.
+		if (ssplieiter_has_next(last_plie)) {
+			sstack_search_next(stack);
+		} else if (sstack_next_stage(stack)) {
+			// Same plie, other children.
+		} else if (stack->plie_i == 0) {
+			return true;
+		} else {
+			sstack_pop(stack);
+		}
+	}
+}
+
+void
+search_results_init(struct SearchResults *results, struct SStack *stack, size_t multipv)
+{
+	const struct SStackPlieIter *root = stack->plies;
+	results->best_move = MOVE_IDENTITY;
+	results->ponder_move = MOVE_IDENTITY;
+	results->centipawns = root->best_eval_so_far;
+	results->depth = stack->desired_depth + 1;
+	results->seldepth = stack->seldepth;
+	results->nodes_count = stack->nodes_count;
+	results->lines_count = 0;
+	// Interrupted searches only have lines for the root moves searched so far.
+	// The sort is stable, so that ties go to the earliest move like
+	// `best_child_i_so_far` does.
+	struct SearchLine *lines = stack->root_lines;
+	size_t lines_count = root->iter.child_i;
+	for (size_t i = 1; i < lines_count; i++) {
+		struct SearchLine line = lines[i];
+		size_t j = i;
+		for (; j > 0 && lines[j - 1].centipawns < line.centipawns; j--) {
+			lines[j] = lines[j - 1];
+		}
+		lines[j] = line;
+	}
+	if (multipv > SEARCH_MAX_MULTIPV) {
+		multipv = SEARCH_MAX_MULTIPV;
+	}
+	results->lines_count = multipv > lines_count ? lines_count : multipv;
+	if (results->lines_count == 0 && lines_count > 0) {
+		results->lines_count = 1;
+	}
+	memcpy(results->lines, lines, results->lines_count * sizeof(struct SearchLine));
+	if (results->lines_count > 0) {
+		results->best_move = lines[0].pv[0];
+		if (lines[0].pv_length > 1) {
+			results->ponder_move = lines[0].pv[1];
+		}
 	}
 }
 
+/* Writes one "info" line per principal variation, all at once. */
 void
-ssplieiter_eval_leaf(struct SStackPlieIter *leaf, struct Board *board)
+search_results_print(const struct SearchResults *results, puint64 elapsed_usecs, FILE *output)
 {
-	position_do_move_and_flip(board, &leaf->iter.moves[leaf->iter.child_i]);
-	float eval = position_eval(board) * leaf->multiplier;
-	position_undo_move_and_flip(board, &leaf->iter.moves[leaf->iter.child_i]);
-	ssplieiter_supply_eval(leaf, eval);
+	puint64 elapsed_ms = elapsed_usecs / 1000;
+	puint64 nps = elapsed_usecs ? results->nodes_count * 1000000 / elapsed_usecs : 0;
+	flockfile(output);
+	for (size_t i = 0; i < results->lines_count; i++) {
+		const struct SearchLine *line = results->lines + i;
+		char score[32];
+		int mate_in_moves = score_to_mate_in_moves(line->centipawns);
+		if (mate_in_moves) {
+			snprintf(score, sizeof(score), "mate %d", mate_in_moves);
+		} else {
+			snprintf(score, sizeof(score), "cp %d", score_to_centipawns(line->centipawns));
+		}
+		fprintf(output,
+		        "info depth %d seldepth %d multipv %zu score %s nodes %zu nps %" PRIu64
+		        " time %" PRIu64 " pv",
+		        results->depth,
+		        results->seldepth,
+		        i + 1,
+		        score,
+		        results->nodes_count,
+		        (uint64_t)nps,
+		        (uint64_t)elapsed_ms);
+		for (int j = 0; j < line->pv_length; j++) {
+			char buf[MOVE_STRING_MAX_LENGTH] = { '\0' };
+			move_to_string(line->pv[j], buf);
+			fprintf(output, " %s", buf);
+		}
+		fputc('\n', output);
+	}
+	fflush(output);
+	funlockfile(output);
 }
 
-struct SearchResults
+double
+search_stats_branching_factor(const struct SearchStats *stats, size_t iteration_i)
 {
-	struct Move best_move;
-	struct Move ponder_move;
-	float centipawns;
-};
+	if (iteration_i == 0 || iteration_i >= stats->iterations_count ||
+	    stats->nodes_count_by_iteration[iteration_i - 1] == 0) {
+		return 0.0;
+	}
+	return (double)stats->nodes_count_by_iteration[iteration_i] /
+	       stats->nodes_count_by_iteration[iteration_i - 1];
+}
+
+#if ZULOID_ENABLE_SEARCH_DEBUGGING
+static void
+search_stats_add_iteration(struct SearchStats *stats,
+                           const struct SearchStats *iteration,
+                           size_t nodes_count)
+{
+	stats->interior_nodes_count += iteration->interior_nodes_count;
+	stats->leaves_count += iteration->leaves_count;
+	stats->terminal_nodes_count += iteration->terminal_nodes_count;
+	stats->draws_count += iteration->draws_count;
+	stats->eval_cache_hits_count += iteration->eval_cache_hits_count;
+	stats->qnodes_count += iteration->qnodes_count;
+	stats->beta_cutoffs_count += iteration->beta_cutoffs_count;
+	stats->first_move_cutoffs_count += iteration->first_move_cutoffs_count;
+	stats->pruned_nodes_count += iteration->pruned_nodes_count;
+	stats->pruned_moves_count += iteration->pruned_moves_count;
+	stats->null_moves_count += iteration->null_moves_count;
+	stats->null_move_cutoffs_count += iteration->null_move_cutoffs_count;
+	stats->reductions_count += iteration->reductions_count;
+	stats->reduction_researches_count += iteration->reduction_researches_count;
+	stats->researches_count += iteration->researches_count;
+	stats->nodes_count_by_iteration[stats->iterations_count++] = nodes_count;
+}
+#endif
+
+bool
+search_signals_should_stop(struct SearchSignals *signals)
+{
+	if (p_atomic_int_get(&signals->stop)) {
+		return true;
+	} else if (p_atomic_int_get(&signals->ponder)) {
+		return false;
+	}
+	pint time_limit_in_ms = p_atomic_int_get(&signals->time_limit_in_ms);
+	return time_limit_in_ms &&
+	       p_time_profiler_elapsed_usecs(signals->timer) / 1000 >= (puint64)time_limit_in_ms;
+}
 
 void
-search_results_init(struct SearchResults *results, const struct SStack *stack)
+position_search(const struct Board *board,
+                const struct History *history,
+                const struct Config *config,
+                int max_depth,
+                struct SearchSignals *signals,
+                struct SearchResults *results)
+{
+	// Other threads might change `board` while we search.
+	struct Board root = *board;
+	// Histories that don't end with `board` are stale, e.g. after editing
+	// the position by other means.
+	struct History root_history;
+	history_init(&root_history);
+	if (history && history->count > 0 && history_last(history) == root.hash) {
+		history_copy(&root_history, history);
+	} else {
+		history_reset(&root_history, &root);
+	}
+	// Contempt 0 makes draws as good as a one pawn advantage, 1 as bad as a one
+	// pawn disadvantage.
+	float draw_score = 1.0 - 2.0 * config->contempt;
+	struct SearchStats stats = { 0 };
+	size_t nodes_count = 0;
+	if (max_depth > SEARCH_MAX_DEPTH) {
+		max_depth = SEARCH_MAX_DEPTH;
+	}
+	PTimeProfiler *timer = p_time_profiler_new();
+	// Evaluations and pawn structures outlive iterations, and they're not
+	// shared with other searches.
+	struct Cache *cache = cache_new(SEARCH_EVAL_CACHE_SIZE_IN_BYTES);
+	struct PawnTable *pawn_table = pawn_table_new(PAWN_TABLE_SIZE_IN_BYTES);
+	struct Selectivity selectivity;
+	selectivity_init(&selectivity, config->selectivity);
+	int multipv = config->multipv > SEARCH_MAX_MULTIPV ? SEARCH_MAX_MULTIPV : config->multipv;
+	// Iterative deepening, so that interrupted searches still end with the
+	// results of the last completed iteration.
+	for (int depth = 1; depth <= max_depth; depth++) {
+		struct SStack stack = sstack_new(&root, &root_history, depth - 1, config->output);
+		stack.draw_score = draw_score;
+		stack.nodes_count = nodes_count;
+		// The first iteration is cheap, and without it there'd be no move to
+		// report at all.
+		stack.max_nodes_count = depth > 1 ? config->max_nodes_count : 0;
+		stack.signals = depth > 1 ? signals : NULL;
+		stack.cache = cache;
+		stack.pawn_table = pawn_table;
+		stack.selectivity = &selectivity;
+		stack.multipv = multipv > 1 ? multipv : 1;
+		bool completed = sstack_run(&stack);
+#if ZULOID_ENABLE_SEARCH_DEBUGGING
+		// Interrupted iterations would make for misleading branching factors.
+		if (completed) {
+			search_stats_add_iteration(&stats, &stack.stats, stack.nodes_count - nodes_count);
+		}
+#endif
+		if (completed || depth == 1) {
+			search_results_init(results, &stack, config->multipv);
+			if (config->output) {
+				search_results_print(
+				  results, p_time_profiler_elapsed_usecs(timer), config->output);
+			}
+		}
+		nodes_count = stack.nodes_count;
+		sstack_delete(&stack);
+		if (!completed) {
+			break;
+		}
+		// The next iteration is going to take several times longer than this
+		// one, so it's pointless to start it with less than half the time.
+		if (signals && !p_atomic_int_get(&signals->ponder) &&
+		    p_atomic_int_get(&signals->time_limit_in_ms) &&
+		    p_time_profiler_elapsed_usecs(signals->timer) / 1000 * 2 >=
+		      (puint64)p_atomic_int_get(&signals->time_limit_in_ms)) {
+			break;
+		}
+	}
+	p_time_profiler_free(timer);
+	cache_delete(cache);
+	pawn_table_delete(pawn_table);
+	history_delete(&root_history);
+	results->nodes_count = nodes_count;
+	results->stats = stats;
+}
+
+static float
+quiesce(struct Board *board, float alpha, float beta, int plie, struct Board *leaf)
 {
+	float stand_pat = position_eval(board) * (board->side_to_move == COLOR_WHITE ? 1.0 : -1.0);
+	if (leaf) {
+		*leaf = *board;
+	}
+	if (stand_pat >= beta || plie >= QUIESCENCE_MAX_PLIES) {
+		return stand_pat;
+	} else if (stand_pat > alpha) {
+		alpha = stand_pat;
+	}
+	struct Move moves[MAX_MOVES];
+	size_t captures_count = gen_attacks_against_from(moves,
+	                                                 board,
+	                                                 board->bb[color_other(board->side_to_move)],
+	                                                 board->side_to_move,
+	                                                 board->en_passant_target,
+	                                                 false);
+	// Good captures first make for earlier cutoffs.
+	moves_sort_by_mvv_lva(moves, captures_count, board);
+	struct Board child_leaf;
+	for (size_t i = 0; i < captures_count; i++) {
+		position_do_move_and_flip(board, moves + i);
+		if (position_is_illegal(board)) {
+			position_undo_move_and_flip(board, moves + i);
+			continue;
+		}
+		float score =
+		  -quiesce(board, -beta, -alpha, plie + 1, leaf ? &child_leaf : NULL);
+		position_undo_move_and_flip(board, moves + i);
+		if (score > alpha) {
+			alpha = score;
+			if (leaf) {
+				*leaf = child_leaf;
+			}
+		}
+		if (alpha >= beta) {
+			break;
+		}
+	}
+	return alpha;
+}
+
+float
+position_quiesce(struct Board *board, float alpha, float beta, struct Board *leaf)
+{
+	return quiesce(board, alpha, beta, 0, leaf);
+}
+
+/* Fills `results` with a book move for `engine->board`, if there's any. */
+static bool
+engine_probe_book(struct Engine *engine, struct SearchResults *results)
+{
+	const struct Board *board = &engine->board;
+	size_t plies_count = (board->moves_count - 1) * 2 + board->side_to_move;
+	if (!engine->book ||
+	    (engine->config.book_max_plies && plies_count >= engine->config.book_max_plies)) {
+		return false;
+	}
+	struct Move mv;
+	if (!book_probe(engine->book,
+	                board,
+	                engine->config.book_best_move_only,
+	                prng_next(&engine->prng_state),
+	                &mv)) {
+		return false;
+	}
 	*results = (struct SearchResults){
-		.best_move = stack->plies[0].iter.moves[stack->plies[0].best_child_i_so_far],
-		// FIXME: `.ponder_move` is the best-scoring move in the subtree of the
-		// best-scoring move of the first plie.
-		.ponder_move = stack->plies[1].best_child_i_so_far,
-		.centipawns = stack->plies[0].best_eval_so_far,
+		.best_move = mv,
+		.ponder_move = MOVE_IDENTITY,
+		.lines = { { .pv_length = 1, .pv = { mv } } },
+		.lines_count = 1,
 	};
+	return true;
 }
 
-void
-finish_search(const struct Engine *engine, const struct SStack *stack)
+/* Only touches the `search_*` fields of `engine`, besides the thread-safe
+ * ones. */
+static ppointer
+engine_search_run(ppointer data)
 {
-	struct SearchResults result;
-	search_results_init(&result, stack);
+	struct Engine *engine = data;
+	struct SearchSignals *signals = &engine->search_signals;
+	const struct Config *config = &engine->search_config;
+	struct SearchResults *results = &engine->search_results;
+	int max_depth = config->max_depth ? (int)config->max_depth : SEARCH_MAX_DEPTH;
+	if (!engine->search_is_book_move) {
+		position_search(
+		  &engine->search_board, &engine->search_history, config, max_depth, signals, results);
+	}
+	puint64 elapsed_usecs = p_time_profiler_elapsed_usecs(signals->timer);
+	pint time_limit_in_ms = p_atomic_int_get(&signals->time_limit_in_ms);
+	metrics_add_search(engine->metrics,
+	                   results->nodes_count,
+	                   elapsed_usecs,
+	                   time_limit_in_ms && elapsed_usecs / 1000 > (puint64)time_limit_in_ms);
+	// Pondering searches that end on their own must wait for either "stop" or
+	// "ponderhit" before reporting.
+	while (p_atomic_int_get(&signals->ponder) && !p_atomic_int_get(&signals->stop)) {
+		p_uthread_sleep(1);
+	}
 	char buf[MOVE_STRING_MAX_LENGTH] = { '\0' };
-	move_to_string(result.best_move, buf);
-	fprintf(engine->config.output, "bestmove %s\n", buf);
+	move_to_string(results->best_move, buf);
+	engine_output_begin(engine);
+	if (moves_eq(&results->ponder_move, &MOVE_IDENTITY)) {
+		fprintf(config->output, "bestmove %s\n", buf);
+	} else {
+		char ponder_buf[MOVE_STRING_MAX_LENGTH] = { '\0' };
+		move_to_string(results->ponder_move, ponder_buf);
+		fprintf(config->output, "bestmove %s ponder %s\n", buf, ponder_buf);
+	}
+	engine_output_end(engine);
+	p_atomic_int_set(&engine->status, STATUS_IDLE);
+	return NULL;
 }
 
 void
 engine_start_search(struct Engine *engine)
 {
-	struct SStack stack = sstack_new(engine);
-	while (true) {
-		struct SStackPlieIter *last_plie = sstack_last(&stack);
-		// We use depth-first search (DFS) to explore the game tree.
-		if (!plieiter_has_next(&last_plie->iter)) {
-			if (stack.plie_i == 0) {
-				break;
-			} else {
-				sstack_pop(&stack);
-			}
-		} else if (stack.plie_i == stack.desired_depth) {
-			ssplieiter_eval_leaf(last_plie, &stack.board);
-		} else {
-			sstack_push(&stack);
-		}
+	assert(engine);
+	// The previous search might have ended on its own, but its thread is
+	// still to be joined.
+	engine_stop_search(engine);
+	engine->search_board = engine->board;
+	history_copy(&engine->search_history, &engine->history);
+	engine->search_config = engine->config;
+	engine->search_is_book_move = engine_probe_book(engine, &engine->search_results);
+	if (engine->search_is_book_move) {
+		ENGINE_LOGF(engine, "[INFO] Book move.\n");
 	}
-	finish_search(engine, &stack);
-	sstack_delete(&stack);
+	p_atomic_int_set(&engine->search_signals.stop, 0);
+	p_time_profiler_reset(engine->search_signals.timer);
+	p_atomic_int_set(&engine->status, STATUS_SEARCH);
+	engine->search_thread = p_uthread_create(engine_search_run, engine, true, "search");
 }
 
 void
-engine_stop_search(struct Engine *engine)
+engine_ponderhit(struct Engine *engine)
 {
 	assert(engine);
-	ENGINE_LOGF(engine, "[INFO] Interrupting search.\n");
+	struct SearchSignals *signals = &engine->search_signals;
+	// The time limit was set for a search starting now, not when pondering
+	// started.
+	pint time_limit_in_ms = p_atomic_int_get(&signals->time_limit_in_ms);
+	if (time_limit_in_ms) {
+		time_limit_in_ms += p_time_profiler_elapsed_usecs(signals->timer) / 1000;
+		p_atomic_int_set(&signals->time_limit_in_ms, time_limit_in_ms);
+	}
+	p_atomic_int_set(&signals->ponder, 0);
 }
 
 void
-agent_delete(struct Agent *agent)
+engine_stop_search(struct Engine *engine)
 {
-	free(agent);
+	assert(engine);
+	if (!engine->search_thread) {
+		return;
+	}
+	ENGINE_LOGF(engine, "[INFO] Interrupting search.\n");
+	p_atomic_int_set(&engine->search_signals.stop, 1);
+	p_uthread_join(engine->search_thread);
+	p_uthread_unref(engine->search_thread);
+	engine->search_thread = NULL;
+	engine->search_stats = engine->search_results.stats;
+	p_atomic_int_set(&engine->status, STATUS_IDLE);
 }
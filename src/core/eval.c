@@ -1,69 +1,265 @@
 /* SPDX-License-Identifier: GPL-3.0-only */
 
 #include "core/eval.h"
-#include "agent.h"
-#include "base64/base64.h"
-#include "cJSON/cJSON.h"
+#include "chess/attack_maps.h"
 #include "chess/bb.h"
-#include "chess/fen.h"
-#include "chess/movegen.h"
+#include "chess/color.h"
+#include "chess/coordinates.h"
+#include "chess/pieces.h"
 #include "chess/position.h"
-#include "engine.h"
-#include "eval.h"
+#include "chess/threats.h"
+#include "core/generated/eval_params.h"
 #include "libpopcnt/libpopcnt.h"
-#include "mt-64/mt-64.h"
 #include "utils.h"
-#include <float.h>
 #include <math.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include <string.h>
 
-const float WEIGHTS_BY_POS[SQUARES_COUNT] = {
-	0.4, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.4, //
-	0.6, 0.6, 0.6, 0.6, 0.6, 0.6, 0.6, 0.6, //
-	0.7, 0.7, 0.7, 0.7, 0.7, 0.7, 0.7, 0.7, //
-	0.7, 0.7, 0.7, 0.8, 0.8, 0.7, 0.7, 0.7, //
-	0.7, 0.7, 0.7, 0.8, 0.8, 0.7, 0.7, 0.7, //
-	0.7, 0.7, 0.7, 0.7, 0.7, 0.7, 0.7, 0.7, //
-	0.6, 0.6, 0.6, 0.6, 0.6, 0.6, 0.6, 0.6, //
-	0.4, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.4, //
-};
-
-float
-eval_bbwscore(Bitboard bb, float weight)
+static float
+eval_bbwscore(Bitboard bb,
+              enum PieceType ptype,
+              const struct EvalParams *params,
+              struct EvalParams *gradient,
+              float scale)
 {
 	Square square = 0;
 	float score = 0.0;
 	while (bb) {
 		POP_LSB(square, bb);
-		score += WEIGHTS_BY_POS[square] * weight;
+		score += params->weights_by_pos[square] * params->material[ptype];
+		if (gradient) {
+			gradient->weights_by_pos[square] += scale * params->material[ptype];
+			gradient->material[ptype] += scale * params->weights_by_pos[square];
+		}
 	}
 	return score;
 }
 
+/* `count` times `param`, which the gradient tracks too. */
+static float
+eval_term(const float *param, float *gradient_param, size_t count, float scale)
+{
+	if (gradient_param) {
+		*gradient_param += scale * count;
+	}
+	return *param * count;
+}
+
+#define EVAL_TERM(field, count)                                                            \
+	eval_term(&params->field, gradient ? &gradient->field : NULL, (count), scale)
+
+/* Mobility, king safety and hanging pieces, all popcounts of attack maps. */
+static float
+eval_attacks(const struct Board *pos,
+             enum Color side,
+             const struct AttackMaps maps[COLORS_COUNT],
+             const struct EvalParams *params,
+             struct EvalParams *gradient,
+             float scale)
+{
+	const struct AttackMaps *ours = maps + side;
+	const struct AttackMaps *theirs = maps + color_other(side);
+	Bitboard safe = ~pos->bb[side] & ~theirs->pawns;
+	size_t knight_moves_count = 0;
+	size_t slider_moves_count[PIECE_TYPE_LAST_PRIMITIVE + 1] = { 0 };
+	for (size_t i = 0; i < LANES_COUNT; i++) {
+		knight_moves_count += popcnt64(ours->knights[i] & safe);
+	}
+	for (enum Direction dir = 0; dir < DIRECTIONS_COUNT; dir++) {
+		enum PieceType ptype = dir >= DIRECTION_NE ? PIECE_TYPE_BISHOP : PIECE_TYPE_ROOK;
+		slider_moves_count[ptype] += popcnt64(ours->sliders[dir] & safe);
+	}
+	Bitboard their_pieces = pos->bb[color_other(side)];
+	Bitboard king_zone = theirs->king | (their_pieces & pos->bb[PIECE_TYPE_KING]);
+	Bitboard hanging = their_pieces & ~pos->bb[PIECE_TYPE_PAWN] &
+	                   ~pos->bb[PIECE_TYPE_KING] & ours->all & ~theirs->all;
+	return EVAL_TERM(mobility[PIECE_TYPE_PAWN], popcnt64(ours->pawns & safe)) +
+	       EVAL_TERM(mobility[PIECE_TYPE_KNIGHT], knight_moves_count) +
+	       EVAL_TERM(mobility[PIECE_TYPE_BISHOP], slider_moves_count[PIECE_TYPE_BISHOP]) +
+	       EVAL_TERM(mobility[PIECE_TYPE_ROOK], slider_moves_count[PIECE_TYPE_ROOK]) +
+	       EVAL_TERM(mobility[PIECE_TYPE_KING], popcnt64(ours->king & safe)) +
+	       EVAL_TERM(king_zone_attacks, popcnt64(ours->all & king_zone)) +
+	       EVAL_TERM(king_zone_double_attacks, popcnt64(ours->double_attacks & king_zone)) +
+	       EVAL_TERM(hanging_pieces, popcnt64(hanging));
+}
+
+/* Pawn structure, mostly as cached in `pawns`. */
+static float
+eval_pawns(const struct Board *pos,
+           enum Color side,
+           const struct PawnEntry *pawns,
+           const struct AttackMaps maps[COLORS_COUNT],
+           const struct EvalParams *params,
+           struct EvalParams *gradient,
+           float scale)
+{
+	float score = 0.0;
+	for (Rank rank = 0; rank <= RANK_MAX; rank++) {
+		score += EVAL_TERM(passed_pawns[rank], pawns->passed_by_rank[side][rank]);
+	}
+	Bitboard minor_pieces =
+	  pos->bb[PIECE_TYPE_KNIGHT] | (pos->bb[PIECE_TYPE_BISHOP] & ~pos->bb[PIECE_TYPE_ROOK]);
+	Bitboard outposts = pos->bb[side] & minor_pieces & maps[side].pawns &
+	                    ~pawns->attack_spans[color_other(side)];
+	return score + EVAL_TERM(isolated_pawns, pawns->isolated_count[side]) +
+	       EVAL_TERM(doubled_pawns, pawns->doubled_count[side]) +
+	       EVAL_TERM(backward_pawns, pawns->backward_count[side]) +
+	       EVAL_TERM(outposts, popcnt64(outposts));
+}
+
+static float
+eval_color(const struct Board *pos,
+           enum Color side,
+           const struct PawnEntry *pawns,
+           const struct AttackMaps maps[COLORS_COUNT],
+           const struct EvalParams *params,
+           struct EvalParams *gradient,
+           float scale)
+{
+	float score = 0.0;
+	for (enum PieceType ptype = PIECE_TYPE_FIRST_PRIMITIVE;
+	     ptype <= PIECE_TYPE_LAST_PRIMITIVE;
+	     ptype++) {
+		score += eval_bbwscore(pos->bb[side] & pos->bb[ptype], ptype, params, gradient, scale);
+	}
+	return score + eval_attacks(pos, side, maps, params, gradient, scale) +
+	       eval_pawns(pos, side, pawns, maps, params, gradient, scale);
+}
+
+static float
+eval_position(const struct Board *pos,
+              const struct PawnEntry *pawns,
+              const struct EvalParams *params,
+              struct EvalParams *gradient,
+              float scale)
+{
+	float tempo_sign = pos->side_to_move == COLOR_WHITE ? 1.0 : -1.0;
+	if (gradient) {
+		gradient->tempo += scale * tempo_sign;
+	}
+	struct AttackMaps maps[COLORS_COUNT];
+	position_attack_maps(pos, maps);
+	return eval_color(pos, COLOR_WHITE, pawns, maps, params, gradient, scale) -
+	       eval_color(pos, COLOR_BLACK, pawns, maps, params, gradient, -scale) +
+	       params->tempo * tempo_sign;
+}
+
 float
 position_eval_color(const struct Board *pos, enum Color side)
 {
-	return eval_bbwscore(pos->bb[side] & pos->bb[PIECE_TYPE_PAWN], 1.0) +
-	       eval_bbwscore(pos->bb[side] & pos->bb[PIECE_TYPE_KNIGHT], 3.0) +
-	       eval_bbwscore(pos->bb[side] & pos->bb[PIECE_TYPE_BISHOP], 3.1) +
-	       eval_bbwscore(pos->bb[side] & pos->bb[PIECE_TYPE_KING], 1000.0) +
-	       eval_bbwscore(pos->bb[side] & pos->bb[PIECE_TYPE_ROOK], 5.0);
+	struct PawnEntry pawns;
+	pawn_entry_init(&pawns, pos);
+	struct AttackMaps maps[COLORS_COUNT];
+	position_attack_maps(pos, maps);
+	return eval_color(pos, side, &pawns, maps, &EVAL_PARAMS, NULL, 0.0);
 }
 
 float
-position_eval_turn(const struct Board *pos)
+position_eval_with_params(const struct Board *pos,
+                          const struct EvalParams *params,
+                          struct EvalParams *gradient,
+                          float scale)
 {
-	const float scores[COLORS_COUNT] = { 0.18, -0.18 };
-	return scores[pos->side_to_move];
+	struct PawnEntry pawns;
+	pawn_entry_init(&pawns, pos);
+	return eval_position(pos, &pawns, params, gradient, scale);
 }
 
 float
 position_eval(const struct Board *pos)
 {
-	float w_score = position_eval_color(pos, COLOR_WHITE);
-	float b_score = position_eval_color(pos, COLOR_BLACK);
-	return w_score - b_score + position_eval_turn(pos);
+	return position_eval_with_params(pos, &EVAL_PARAMS, NULL, 0.0);
+}
+
+float
+position_eval_with_pawn_table(const struct Board *pos, struct PawnTable *pawn_table)
+{
+	return eval_position(pos, pawn_table_probe(pawn_table, pos), &EVAL_PARAMS, NULL, 0.0);
+}
+
+float
+eval_max_move_swing(void)
+{
+	const struct EvalParams *params = &EVAL_PARAMS;
+	float min_weight = INFINITY;
+	float max_weight = -INFINITY;
+	for (Square sq = 0; sq < SQUARES_COUNT; sq++) {
+		min_weight = fminf(min_weight, params->weights_by_pos[sq]);
+		max_weight = fmaxf(max_weight, params->weights_by_pos[sq]);
+	}
+	// Queens count as both bishops and rooks.
+	float max_material =
+	  params->material[PIECE_TYPE_BISHOP] + params->material[PIECE_TYPE_ROOK];
+	for (enum PieceType ptype = PIECE_TYPE_PAWN; ptype < PIECE_TYPE_KING; ptype++) {
+		max_material = fmaxf(max_material, params->material[ptype]);
+	}
+	return max_material * (max_weight - min_weight);
+}
+
+float
+eval_king_step_gain(const struct Board *pos, enum Color side)
+{
+	const struct EvalParams *params = &EVAL_PARAMS;
+	Bitboard king = pos->bb[side] & pos->bb[PIECE_TYPE_KING];
+	if (!king) {
+		return 0.0;
+	}
+	Square from = LSB(king);
+	Bitboard targets = threats_by_king(from) & ~pos->bb[side];
+	Square to = 0;
+	float max_weight = params->weights_by_pos[from];
+	while (targets) {
+		POP_LSB(to, targets);
+		max_weight = fmaxf(max_weight, params->weights_by_pos[to]);
+	}
+	return params->material[PIECE_TYPE_KING] * (max_weight - params->weights_by_pos[from]);
+}
+
+int
+eval_params_export(const struct EvalParams *params, const char *identifier, FILE *stream)
+{
+	static const char *const PIECE_TYPE_NAMES[] = {
+		[PIECE_TYPE_PAWN] = "PIECE_TYPE_PAWN",     [PIECE_TYPE_KNIGHT] = "PIECE_TYPE_KNIGHT",
+		[PIECE_TYPE_BISHOP] = "PIECE_TYPE_BISHOP", [PIECE_TYPE_ROOK] = "PIECE_TYPE_ROOK",
+		[PIECE_TYPE_KING] = "PIECE_TYPE_KING",
+	};
+	fprintf(stream, "\nconst struct EvalParams %s = {\n\t.material = {\n", identifier);
+	for (enum PieceType ptype = PIECE_TYPE_FIRST_PRIMITIVE;
+	     ptype <= PIECE_TYPE_LAST_PRIMITIVE;
+	     ptype++) {
+		fprintf(stream, "\t\t[%s] = %.4f,\n", PIECE_TYPE_NAMES[ptype], params->material[ptype]);
+	}
+	fprintf(stream, "\t},\n\t.tempo = %.4f,\n\t.weights_by_pos = {\n", params->tempo);
+	for (Square sq = 0; sq < SQUARES_COUNT; sq++) {
+		fprintf(stream,
+		        "%s%.4f,%s",
+		        sq % 8 == 0 ? "\t\t" : " ",
+		        params->weights_by_pos[sq],
+		        sq % 8 == 7 ? " //\n" : "");
+	}
+	fprintf(stream, "\t},\n\t.mobility = {\n");
+	for (enum PieceType ptype = PIECE_TYPE_FIRST_PRIMITIVE;
+	     ptype <= PIECE_TYPE_LAST_PRIMITIVE;
+	     ptype++) {
+		fprintf(stream, "\t\t[%s] = %.4f,\n", PIECE_TYPE_NAMES[ptype], params->mobility[ptype]);
+	}
+	fprintf(stream,
+	        "\t},\n\t.king_zone_attacks = %.4f,\n\t.king_zone_double_attacks = %.4f,\n"
+	        "\t.hanging_pieces = %.4f,\n",
+	        params->king_zone_attacks,
+	        params->king_zone_double_attacks,
+	        params->hanging_pieces);
+	fprintf(stream, "\t.passed_pawns = {");
+	for (Rank rank = 0; rank <= RANK_MAX; rank++) {
+		fprintf(stream, " %.4f,", params->passed_pawns[rank]);
+	}
+	fprintf(stream,
+	        " },\n\t.isolated_pawns = %.4f,\n\t.doubled_pawns = %.4f,\n"
+	        "\t.backward_pawns = %.4f,\n\t.outposts = %.4f,\n};\n",
+	        params->isolated_pawns,
+	        params->doubled_pawns,
+	        params->backward_pawns,
+	        params->outposts);
+	return 0;
 }
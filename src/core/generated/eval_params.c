@@ -0,0 +1,39 @@
+/* SPDX-License-Identifier: GPL-3.0-only */
+
+#include "core/generated/eval_params.h"
+
+const struct EvalParams EVAL_PARAMS = {
+	.material = {
+		[PIECE_TYPE_PAWN] = 1.0,
+		[PIECE_TYPE_KNIGHT] = 3.0,
+		[PIECE_TYPE_BISHOP] = 3.1,
+		[PIECE_TYPE_ROOK] = 5.0,
+		[PIECE_TYPE_KING] = 1000.0,
+	},
+	.tempo = 0.18,
+	.weights_by_pos = {
+		0.4, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.4, //
+		0.6, 0.6, 0.6, 0.6, 0.6, 0.6, 0.6, 0.6, //
+		0.7, 0.7, 0.7, 0.7, 0.7, 0.7, 0.7, 0.7, //
+		0.7, 0.7, 0.7, 0.8, 0.8, 0.7, 0.7, 0.7, //
+		0.7, 0.7, 0.7, 0.8, 0.8, 0.7, 0.7, 0.7, //
+		0.7, 0.7, 0.7, 0.7, 0.7, 0.7, 0.7, 0.7, //
+		0.6, 0.6, 0.6, 0.6, 0.6, 0.6, 0.6, 0.6, //
+		0.4, 0.5, 0.5, 0.5, 0.5, 0.5, 0.5, 0.4, //
+	},
+	.mobility = {
+		[PIECE_TYPE_PAWN] = 0.0,
+		[PIECE_TYPE_KNIGHT] = 0.03,
+		[PIECE_TYPE_BISHOP] = 0.025,
+		[PIECE_TYPE_ROOK] = 0.015,
+		[PIECE_TYPE_KING] = 0.0,
+	},
+	.king_zone_attacks = 0.04,
+	.king_zone_double_attacks = 0.03,
+	.hanging_pieces = 0.1,
+	.passed_pawns = { 0.0, 0.05, 0.1, 0.15, 0.3, 0.5, 0.8, 0.0 },
+	.isolated_pawns = -0.12,
+	.doubled_pawns = -0.1,
+	.backward_pawns = -0.08,
+	.outposts = 0.15,
+};
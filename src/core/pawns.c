@@ -0,0 +1,134 @@
+/* SPDX-License-Identifier: GPL-3.0-only */
+
+/* Pawn structure features, computed set-wise from the pawn bitboards and
+ * cached by pawn hash. Squares are `file * 8 + rank`, so each file is a byte
+ * and moving forward for White is a left shift by one. */
+
+#include "core/pawns.h"
+#include "chess/bb.h"
+#include "chess/color.h"
+#include "chess/pieces.h"
+#include "libpopcnt/libpopcnt.h"
+#include "utils.h"
+#include <string.h>
+
+#define RANK_1_BB 0x0101010101010101ULL
+#define RANK_8_BB 0x8080808080808080ULL
+
+static Bitboard
+bb_north_fill(Bitboard bb)
+{
+	bb |= (bb << 1) & 0xfefefefefefefefeULL;
+	bb |= (bb << 2) & 0xfcfcfcfcfcfcfcfcULL;
+	return bb | ((bb << 4) & 0xf0f0f0f0f0f0f0f0ULL);
+}
+
+static Bitboard
+bb_south_fill(Bitboard bb)
+{
+	bb |= (bb >> 1) & 0x7f7f7f7f7f7f7f7fULL;
+	bb |= (bb >> 2) & 0x3f3f3f3f3f3f3f3fULL;
+	return bb | ((bb >> 4) & 0x0f0f0f0f0f0f0f0fULL);
+}
+
+/* The neighbouring files. */
+static Bitboard
+bb_sides(Bitboard bb)
+{
+	return (bb << 8) | (bb >> 8);
+}
+
+/* One square ahead, from the point of view of `color`. */
+static Bitboard
+bb_forward(Bitboard bb, enum Color color)
+{
+	return color == COLOR_WHITE ? (bb << 1) & ~RANK_1_BB : (bb >> 1) & ~RANK_8_BB;
+}
+
+/* All squares ahead. */
+static Bitboard
+bb_front_span(Bitboard bb, enum Color color)
+{
+	bb = bb_forward(bb, color);
+	return color == COLOR_WHITE ? bb_north_fill(bb) : bb_south_fill(bb);
+}
+
+static void
+pawn_entry_init_color(struct PawnEntry *entry, const struct Board *pos, enum Color color)
+{
+	enum Color other = color_other(color);
+	Bitboard ours = pos->bb[PIECE_TYPE_PAWN] & pos->bb[color];
+	Bitboard theirs = pos->bb[PIECE_TYPE_PAWN] & pos->bb[other];
+	Bitboard their_front_spans = bb_front_span(theirs, other);
+	Bitboard our_attack_spans = bb_sides(bb_front_span(ours, color));
+	entry->attack_spans[color] = our_attack_spans;
+	// Of doubled pawns, only the front one can be passed.
+	Bitboard passed = ours & ~their_front_spans & ~bb_sides(their_front_spans) &
+	                  ~bb_front_span(ours, other);
+	while (passed) {
+		Square sq = LSB(passed);
+		passed &= passed - 1;
+		Rank rank = square_rank(sq);
+		entry->passed_by_rank[color][color == COLOR_WHITE ? rank : RANK_MAX - rank]++;
+	}
+	// Every pawn with another one of ours behind it.
+	entry->doubled_count[color] = popcnt64(ours & bb_front_span(ours, color));
+	Bitboard files = bb_north_fill(ours) | bb_south_fill(ours);
+	entry->isolated_count[color] = popcnt64(ours & ~bb_sides(files));
+	// Pawns that can't advance without being captured, and that no other pawn
+	// of ours can ever support.
+	Bitboard their_attacks = bb_sides(bb_forward(theirs, other));
+	Bitboard stops = bb_forward(ours, color) & their_attacks & ~our_attack_spans;
+	entry->backward_count[color] = popcnt64(bb_forward(stops, other));
+}
+
+void
+pawn_entry_init(struct PawnEntry *entry, const struct Board *pos)
+{
+	memset(entry, 0, sizeof(*entry));
+	entry->pawn_hash = pos->pawn_hash;
+	pawn_entry_init_color(entry, pos, COLOR_WHITE);
+	pawn_entry_init_color(entry, pos, COLOR_BLACK);
+}
+
+struct PawnTable
+{
+	size_t mask;
+	struct PawnEntry *entries;
+};
+
+struct PawnTable *
+pawn_table_new(size_t size_in_bytes)
+{
+	// A power of two, so that indexing is a mask.
+	size_t count = 1;
+	while (count * 2 * sizeof(struct PawnEntry) <= size_in_bytes) {
+		count *= 2;
+	}
+	struct PawnTable *table = exit_if_null(malloc(sizeof(struct PawnTable)));
+	// All-zero entries are those of positions without pawns, whose pawn hash
+	// is zero, so empty slots need no special treatment.
+	table->entries = exit_if_null(calloc(count, sizeof(struct PawnEntry)));
+	table->mask = count - 1;
+	return table;
+}
+
+void
+pawn_table_delete(struct PawnTable *table)
+{
+	if (!table) {
+		return;
+	}
+	free(table->entries);
+	free(table);
+}
+
+const struct PawnEntry *
+pawn_table_probe(struct PawnTable *table, const struct Board *pos)
+{
+	struct PawnEntry *entry = table->entries + (pos->pawn_hash & table->mask);
+	if (entry->pawn_hash != pos->pawn_hash) {
+		pawn_entry_init(entry, pos);
+	}
+	return entry;
+}
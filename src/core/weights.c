@@ -0,0 +1,190 @@
+/* SPDX-License-Identifier: GPL-3.0-only */
+
+#include "core/weights.h"
+#include "utils.h"
+#include <assert.h>
+#include <fcntl.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define XXH_INLINE_ALL
+#include "xxHash/xxhash.h"
+
+const char WEIGHTS_MAGIC[8] = { 'Z', 'U', 'L', 'W', 'G', 'H', 'T', 'S' };
+
+struct Weights
+{
+	const uint8_t *data;
+	size_t size;
+	const struct WeightsHeader *header;
+	const struct WeightsTensor *tensors;
+};
+
+static uint64_t
+align_up(uint64_t offset)
+{
+	return (offset + WEIGHTS_ALIGNMENT - 1) & ~(uint64_t)(WEIGHTS_ALIGNMENT - 1);
+}
+
+static bool
+weights_are_valid(const struct Weights *weights)
+{
+	const struct WeightsHeader *header = weights->header;
+	if (weights->size < sizeof(struct WeightsHeader) ||
+	    memcmp(header->magic, WEIGHTS_MAGIC, sizeof(WEIGHTS_MAGIC)) != 0 ||
+	    header->version != WEIGHTS_VERSION) {
+		return false;
+	}
+	// Sizes come straight from the file, so they're compared against what's
+	// left of it rather than added up, which could overflow.
+	size_t tensors_size = weights->size - sizeof(struct WeightsHeader);
+	if (header->tensors_count > tensors_size / sizeof(struct WeightsTensor)) {
+		return false;
+	}
+	uint64_t tensors_end =
+	  sizeof(struct WeightsHeader) + header->tensors_count * sizeof(struct WeightsTensor);
+	if (header->payload_offset < tensors_end || header->payload_offset > weights->size ||
+	    header->payload_offset % WEIGHTS_ALIGNMENT != 0 ||
+	    header->payload_size > weights->size - header->payload_offset) {
+		return false;
+	}
+	uint64_t payload_end = header->payload_offset + header->payload_size;
+	for (uint32_t i = 0; i < header->tensors_count; i++) {
+		const struct WeightsTensor *tensor = weights->tensors + i;
+		if (tensor->offset % WEIGHTS_ALIGNMENT != 0 ||
+		    tensor->offset < header->payload_offset || tensor->offset > payload_end ||
+		    tensor->size_in_bytes > payload_end - tensor->offset ||
+		    !memchr(tensor->name, '\0', WEIGHTS_TENSOR_NAME_SIZE)) {
+			return false;
+		}
+	}
+	return XXH64(weights->data + header->payload_offset, header->payload_size, 0) ==
+	       header->checksum;
+}
+
+struct Weights *
+weights_open(const char *path)
+{
+	assert(path);
+	int fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		return NULL;
+	}
+	struct stat info;
+	if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+		close(fd);
+		return NULL;
+	}
+	// A shared, read-only mapping lets every engine process on the host use the
+	// very same physical pages.
+	void *data = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		return NULL;
+	}
+	struct Weights *weights = exit_if_null(malloc(sizeof(struct Weights)));
+	*weights = (struct Weights){
+		.data = data,
+		.size = info.st_size,
+		.header = data,
+		.tensors = (const struct WeightsTensor *)((const uint8_t *)data +
+		                                          sizeof(struct WeightsHeader)),
+	};
+	if (!weights_are_valid(weights)) {
+		weights_close(weights);
+		return NULL;
+	}
+	return weights;
+}
+
+const void *
+weights_tensor(const struct Weights *weights, const char *name, size_t *size_in_bytes)
+{
+	assert(weights);
+	assert(name);
+	for (uint32_t i = 0; i < weights->header->tensors_count; i++) {
+		const struct WeightsTensor *tensor = weights->tensors + i;
+		if (strcmp(tensor->name, name) == 0) {
+			if (size_in_bytes) {
+				*size_in_bytes = tensor->size_in_bytes;
+			}
+			return weights->data + tensor->offset;
+		}
+	}
+	return NULL;
+}
+
+void
+weights_close(struct Weights *weights)
+{
+	if (!weights) {
+		return;
+	}
+	munmap((void *)weights->data, weights->size);
+	free(weights);
+}
+
+int
+weights_write(FILE *stream,
+              const char *const names[],
+              const void *const data[],
+              const size_t sizes[],
+              size_t count)
+{
+	assert(stream);
+	struct WeightsHeader header = {
+		.version = WEIGHTS_VERSION,
+		.tensors_count = count,
+		.payload_offset = align_up(sizeof(struct WeightsHeader) +
+		                           count * sizeof(struct WeightsTensor)),
+	};
+	memcpy(header.magic, WEIGHTS_MAGIC, sizeof(WEIGHTS_MAGIC));
+	struct WeightsTensor *tensors =
+	  exit_if_null(calloc(count ? count : 1, sizeof(struct WeightsTensor)));
+	uint64_t offset = header.payload_offset;
+	for (size_t i = 0; i < count; i++) {
+		if (strlen(names[i]) >= WEIGHTS_TENSOR_NAME_SIZE) {
+			free(tensors);
+			return ERR_CODE_INVALID_WEIGHTS;
+		}
+		strcpy(tensors[i].name, names[i]);
+		tensors[i].offset = offset;
+		tensors[i].size_in_bytes = sizes[i];
+		offset = align_up(offset + sizes[i]);
+	}
+	header.payload_size = offset - header.payload_offset;
+	// The checksum covers the zero padding as well, so we must hash the payload
+	// exactly as it will be laid out on disk.
+	static const uint8_t PADDING[WEIGHTS_ALIGNMENT] = { 0 };
+	XXH64_state_t *state = exit_if_null(XXH64_createState());
+	XXH64_reset(state, 0);
+	for (size_t i = 0; i < count; i++) {
+		XXH64_update(state, data[i], sizes[i]);
+		XXH64_update(state, PADDING, align_up(sizes[i]) - sizes[i]);
+	}
+	header.checksum = XXH64_digest(state);
+	XXH64_freeState(state);
+	int err = ERR_CODE_NONE;
+	size_t padding = header.payload_offset - sizeof(struct WeightsHeader) -
+	                 count * sizeof(struct WeightsTensor);
+	if (fwrite(&header, sizeof(header), 1, stream) != 1 ||
+	    fwrite(tensors, sizeof(struct WeightsTensor), count, stream) != count ||
+	    fwrite(PADDING, 1, padding, stream) != padding) {
+		err = ERR_CODE_IO;
+	}
+	for (size_t i = 0; i < count && !err; i++) {
+		padding = align_up(sizes[i]) - sizes[i];
+		if (fwrite(data[i], 1, sizes[i], stream) != sizes[i] ||
+		    fwrite(PADDING, 1, padding, stream) != padding) {
+			err = ERR_CODE_IO;
+		}
+	}
+	free(tensors);
+	return err;
+}
@@ -3,10 +3,14 @@
 #include "engine.h"
 #include "agent.h"
 #include "cache/cache.h"
+#include "chess/book.h"
 #include "chess/fen.h"
+#include "chess/history.h"
+#include "chess/move.h"
 #include "chess/position.h"
+#include "logger.h"
 #include "meta.h"
-#include "mt-64/mt-64.h"
+#include "metrics.h"
 #include "protocols/uci.h"
 #include "utils.h"
 #include <assert.h>
@@ -20,12 +24,11 @@ const struct Config CONFIG_DEFAULT;
 void
 init_subsystems(void)
 {
-	init_genrand64(ZULOID_PRNG_SEED);
 	p_libsys_init();
-	// UCI (and CECP as well, for that matter) is a line-oriented protocol; so
-	// we want to turn line buffering on.
-	setvbuf(stdin, NULL, _IOLBF, 0);
-	setvbuf(stdout, NULL, _IOLBF, 0);
+	// Input is read straight from the file descriptor, see `struct
+	// LineReader`. Output is flushed once per message rather than once per
+	// line, see `engine_output_end`.
+	setvbuf(stdout, NULL, _IOFBF, ENGINE_OUTPUT_BUFFER_SIZE);
 }
 
 struct Engine *
@@ -42,25 +45,104 @@ engine_init(struct Engine *engine)
 	*engine = (struct Engine){
 		.time_controls = { time_control_new_bullet(), time_control_new_bullet() },
 		.cache = NULL,
+		.metrics = metrics_new(),
+		.logger = logger_new(),
+		.book = NULL,
 		.agent = agent_new(),
-		.seed = 0xcfca130b,
+		.prng_state = ZULOID_PRNG_SEED,
 		.status = STATUS_IDLE,
 		.config = CONFIG_DEFAULT,
+		.game_moves = NULL,
+		.game_moves_count = 0,
+		.game_moves_capacity = 0,
+		.search_thread = NULL,
+		.search_signals = { .stop = 0, .ponder = 0, .time_limit_in_ms = 0 },
+		.search_is_book_move = false,
+		.search_stats = { 0 },
 	};
+	engine->search_signals.timer = p_time_profiler_new();
+	for (int color = 0; color < COLORS_COUNT; color++) {
+		game_clock_init(engine->game_clocks + color, engine->time_controls[color]);
+	}
 	engine->config.output = stdout;
-	position_init_from_fen(&engine->board, FEN_OF_INITIAL_POSITION);
+	history_init(&engine->history);
+	history_init(&engine->search_history);
+	engine_reset_game(engine, &POSITION_INIT);
 }
 
 void
 engine_delete(struct Engine *engine)
 {
+	engine_stop_search(engine);
+	p_time_profiler_free(engine->search_signals.timer);
+	p_time_profiler_free(engine->game_clocks[COLOR_WHITE].timer);
+	p_time_profiler_free(engine->game_clocks[COLOR_BLACK].timer);
 	time_control_delete(engine->time_controls[COLOR_WHITE]);
 	time_control_delete(engine->time_controls[COLOR_BLACK]);
 	cache_delete(engine->cache);
+	metrics_delete(engine->metrics);
+	logger_delete(engine->logger);
+	book_close(engine->book);
 	agent_delete(engine->agent);
+	history_delete(&engine->history);
+	history_delete(&engine->search_history);
+	free(engine->game_moves);
 	free(engine);
 }
 
+void
+engine_reset_game(struct Engine *engine, const struct Board *base)
+{
+	engine->game_base = *base;
+	engine->board = *base;
+	engine->game_moves_count = 0;
+	history_reset(&engine->history, base);
+}
+
+void
+engine_play_move(struct Engine *engine, struct Move mv)
+{
+	if (engine->game_moves_count == engine->game_moves_capacity) {
+		engine->game_moves_capacity =
+		  engine->game_moves_capacity ? engine->game_moves_capacity * 2 : 128;
+		engine->game_moves = exit_if_null(realloc(
+		  engine->game_moves, engine->game_moves_capacity * sizeof(struct Move)));
+	}
+	position_play_move(&engine->board, &mv);
+	engine->game_moves[engine->game_moves_count++] = mv;
+	history_push(&engine->history, engine->board.hash);
+}
+
+void
+engine_take_back_moves(struct Engine *engine, size_t count)
+{
+	while (engine->game_moves_count > count) {
+		position_take_back_move(&engine->board,
+		                        engine->game_moves + --engine->game_moves_count);
+		history_pop(&engine->history);
+	}
+}
+
+bool
+engine_game_is_consistent(const struct Engine *engine)
+{
+	return engine->history.count == engine->game_moves_count + 1 &&
+	       history_last(&engine->history) == engine->board.hash;
+}
+
+void
+engine_output_begin(struct Engine *engine)
+{
+	flockfile(engine->config.output);
+}
+
+void
+engine_output_end(struct Engine *engine)
+{
+	fflush(engine->config.output);
+	funlockfile(engine->config.output);
+}
+
 void
 engine_logf(struct Engine *engine,
             const char *filename,
@@ -71,14 +153,19 @@ engine_logf(struct Engine *engine,
 	assert(engine);
 	assert(filename);
 	assert(function_name);
-	if (!engine->config.debug) {
-		return;
-	}
-	fprintf(engine->config.output, "info string ");
-	fprintf(engine->config.output, "%s:%zu @ %s -- ", filename, line_num, function_name);
 	va_list args;
 	va_start(args, function_name);
-	vfprintf(engine->config.output, va_arg(args, const char *), args);
+	const char *format = va_arg(args, const char *);
+	// The log file, if any, takes the place of protocol output.
+	if (logger_is_open(engine->logger)) {
+		logger_vlogf(engine->logger, filename, line_num, function_name, format, args);
+	} else if (engine->config.debug) {
+		engine_output_begin(engine);
+		fprintf(engine->config.output, "info string ");
+		fprintf(engine->config.output, "%s:%zu @ %s -- ", filename, line_num, function_name);
+		vfprintf(engine->config.output, format, args);
+		engine_output_end(engine);
+	}
 	va_end(args);
 }
 
@@ -88,6 +175,7 @@ const struct Config CONFIG_DEFAULT = {
 	.contempt = 0.3,
 	.selectivity = 0.5,
 	.ponder = false,
+	.multipv = 1,
 	.max_nodes_count = 0,
 	.max_depth = 0,
 	.protocol = engine_call_uci,
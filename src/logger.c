@@ -0,0 +1,266 @@
+/* SPDX-License-Identifier: GPL-3.0-only */
+
+#include "logger.h"
+#include "utils.h"
+#include <assert.h>
+#include <plibsys.h>
+#include <stdio.h>
+#include <string.h>
+
+struct LogRecord
+{
+	puint64 usecs;
+	const char *filename;
+	const char *function_name;
+	size_t line_num;
+	char message[LOGGER_MESSAGE_SIZE];
+};
+
+/* Single-producer, single-consumer. `head` and `tail` only ever grow (modulo
+ * overflow), and they're only written by the flusher thread and the owner
+ * thread respectively. */
+struct LogRing
+{
+	struct LogRing *next;
+	volatile pint head;
+	volatile pint tail;
+	volatile pint dropped_count;
+	// Rings outlive their threads and are handed over to new ones once
+	// drained.
+	volatile pint is_owned;
+	struct LogRecord records[LOGGER_RING_SIZE];
+};
+
+struct Logger
+{
+	PTimeProfiler *uptime;
+	PUThreadKey *ring_key;
+	// Protects additions to `rings`, which are never removed.
+	PMutex *rings_mutex;
+	struct LogRing *volatile rings;
+	volatile pint is_open;
+	// Threads inside `logger_vlogf` that might have seen `is_open` set. The
+	// log file is only closed once there are none left.
+	volatile pint writers_count;
+	FILE *file;
+	/* -- Flusher thread. */
+	PUThread *thread;
+	volatile pint stop;
+};
+
+static void
+log_ring_release(ppointer data)
+{
+	struct LogRing *ring = data;
+	p_atomic_int_set(&ring->is_owned, 0);
+}
+
+struct Logger *
+logger_new(void)
+{
+	struct Logger *logger = exit_if_null(malloc(sizeof(struct Logger)));
+	*logger = (struct Logger){
+		.uptime = p_time_profiler_new(),
+		.ring_key = p_uthread_local_new(log_ring_release),
+		.rings_mutex = p_mutex_new(),
+		.rings = NULL,
+		.is_open = 0,
+		.writers_count = 0,
+		.file = NULL,
+		.thread = NULL,
+		.stop = 0,
+	};
+	return logger;
+}
+
+static struct LogRing *
+logger_claim_ring(struct Logger *logger)
+{
+	p_mutex_lock(logger->rings_mutex);
+	// Only drained rings are handed over, so that every thread gets the full
+	// capacity.
+	struct LogRing *ring = logger->rings;
+	while (ring && (p_atomic_int_get(&ring->is_owned) ||
+	                p_atomic_int_get(&ring->head) != p_atomic_int_get(&ring->tail))) {
+		ring = ring->next;
+	}
+	if (!ring) {
+		ring = exit_if_null(malloc(sizeof(struct LogRing)));
+		ring->next = logger->rings;
+		ring->head = 0;
+		ring->tail = 0;
+		ring->dropped_count = 0;
+		p_atomic_pointer_set(&logger->rings, ring);
+	}
+	p_atomic_int_set(&ring->is_owned, 1);
+	p_mutex_unlock(logger->rings_mutex);
+	p_uthread_set_local(logger->ring_key, ring);
+	return ring;
+}
+
+void
+logger_vlogf(struct Logger *logger,
+             const char *filename,
+             size_t line_num,
+             const char *function_name,
+             const char *format,
+             va_list args)
+{
+	// Announces ourselves before checking `is_open`, so that `logger_close`
+	// either sees us or we see it.
+	p_atomic_int_inc(&logger->writers_count);
+	if (!p_atomic_int_get(&logger->is_open)) {
+		p_atomic_int_add(&logger->writers_count, -1);
+		return;
+	}
+	struct LogRing *ring = p_uthread_get_local(logger->ring_key);
+	if (!ring) {
+		ring = logger_claim_ring(logger);
+	}
+	puint tail = ring->tail;
+	if (tail - (puint)p_atomic_int_get(&ring->head) == LOGGER_RING_SIZE) {
+		p_atomic_int_inc(&ring->dropped_count);
+		p_atomic_int_add(&logger->writers_count, -1);
+		return;
+	}
+	struct LogRecord *record = ring->records + tail % LOGGER_RING_SIZE;
+	record->usecs = p_time_profiler_elapsed_usecs(logger->uptime);
+	record->filename = filename;
+	record->function_name = function_name;
+	record->line_num = line_num;
+	vsnprintf(record->message, LOGGER_MESSAGE_SIZE, format, args);
+	// Publishes the record.
+	p_atomic_int_set(&ring->tail, (pint)(tail + 1));
+	p_atomic_int_add(&logger->writers_count, -1);
+}
+
+static void
+log_record_write(const struct LogRecord *record, FILE *file)
+{
+	size_t length = strcspn(record->message, "\n");
+	fprintf(file,
+	        "%.6f %s:%zu @ %s -- %.*s\n",
+	        record->usecs / 1e6,
+	        record->filename,
+	        record->line_num,
+	        record->function_name,
+	        (int)length,
+	        record->message);
+}
+
+/* Returns the number of records written. */
+static size_t
+logger_drain(struct Logger *logger)
+{
+	size_t count = 0;
+	for (struct LogRing *ring = p_atomic_pointer_get(&logger->rings); ring;
+	     ring = ring->next) {
+		puint head = ring->head;
+		puint tail = p_atomic_int_get(&ring->tail);
+		pint dropped_count = p_atomic_int_get(&ring->dropped_count);
+		if (head == tail && !dropped_count) {
+			continue;
+		}
+		for (; head != tail; head++, count++) {
+			log_record_write(ring->records + head % LOGGER_RING_SIZE, logger->file);
+		}
+		if (dropped_count) {
+			fprintf(logger->file, "[WARN] %d log records dropped.\n", dropped_count);
+		}
+		// Records are only given back once they're out of our hands, so that
+		// `logger_flush` can rely on empty rings.
+		fflush(logger->file);
+		p_atomic_int_set(&ring->head, (pint)head);
+		p_atomic_int_add(&ring->dropped_count, -dropped_count);
+	}
+	return count;
+}
+
+static ppointer
+logger_flusher_run(ppointer data)
+{
+	struct Logger *logger = data;
+	while (!p_atomic_int_get(&logger->stop)) {
+		if (!logger_drain(logger)) {
+			p_uthread_sleep(LOGGER_FLUSH_INTERVAL_IN_MS);
+		}
+	}
+	logger_drain(logger);
+	return NULL;
+}
+
+static void
+logger_close(struct Logger *logger)
+{
+	if (!logger->thread) {
+		return;
+	}
+	p_atomic_int_set(&logger->is_open, 0);
+	// Writers that got past the `is_open` check must be done before the final
+	// drain, or their records would be lost.
+	while (p_atomic_int_get(&logger->writers_count)) {
+		p_uthread_sleep(1);
+	}
+	p_atomic_int_set(&logger->stop, 1);
+	p_uthread_join(logger->thread);
+	p_uthread_unref(logger->thread);
+	logger->thread = NULL;
+	p_atomic_int_set(&logger->stop, 0);
+	fclose(logger->file);
+	logger->file = NULL;
+}
+
+void
+logger_delete(struct Logger *logger)
+{
+	if (!logger) {
+		return;
+	}
+	logger_close(logger);
+	p_uthread_local_free(logger->ring_key);
+	while (logger->rings) {
+		struct LogRing *next = logger->rings->next;
+		free(logger->rings);
+		logger->rings = next;
+	}
+	p_mutex_free(logger->rings_mutex);
+	p_time_profiler_free(logger->uptime);
+	free(logger);
+}
+
+int
+logger_open(struct Logger *logger, const char *path)
+{
+	logger_close(logger);
+	if (!path) {
+		return ERR_CODE_NONE;
+	}
+	logger->file = fopen(path, "a");
+	if (!logger->file) {
+		return ERR_CODE_IO;
+	}
+	logger->thread = p_uthread_create(logger_flusher_run, logger, true, "logger");
+	p_atomic_int_set(&logger->is_open, 1);
+	return ERR_CODE_NONE;
+}
+
+bool
+logger_is_open(const struct Logger *logger)
+{
+	return p_atomic_int_get(&logger->is_open);
+}
+
+void
+logger_flush(struct Logger *logger)
+{
+	if (!logger->thread) {
+		return;
+	}
+	for (struct LogRing *ring = p_atomic_pointer_get(&logger->rings); ring;
+	     ring = ring->next) {
+		while (p_atomic_int_get(&ring->head) != p_atomic_int_get(&ring->tail) ||
+		       p_atomic_int_get(&ring->dropped_count)) {
+			p_uthread_sleep(1);
+		}
+	}
+}
@@ -2,19 +2,44 @@
 
 #include "engine.h"
 #include "meta.h"
+#include "modes.h"
+#include "protocols/support/line_reader.h"
 #include "feature_flags.h"
 #include "utils.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 
 #ifdef ZULOID_ENABLE_SHOW_PID
 #include <plibsys.h>
 #endif
 
+struct Mode
+{
+	const char *name;
+	int (*run)(int argc, char **argv);
+};
+
+const struct Mode MODES[] = {
+	{ "analyze", mode_analyze },
+	{ "convert", mode_convert },
+	{ "makebook", mode_makebook },
+	{ "selfplay", mode_selfplay },
+	{ "tune", mode_tune },
+};
+
 int
 main(int argc, char **argv)
 {
 	init_subsystems();
+	for (size_t i = 0; argc > 1 && i < ARRAY_SIZE(MODES); i++) {
+		if (strcmp(argv[1], MODES[i].name) == 0) {
+			int status = MODES[i].run(argc - 2, argv + 2);
+			p_libsys_shutdown();
+			return status;
+		}
+	}
 	struct Engine *engine = engine_new();
 	// The number sign ensures minimal possibility of accidental evaluation by
 	// the client.
@@ -23,14 +48,19 @@ main(int argc, char **argv)
 #ifdef ZULOID_ENABLE_SHOW_PID
 	printf("# Process ID: %d\n", p_process_get_current_pid());
 #endif
-	for (int i = 1; i < argc && engine->status != STATUS_EXIT; i++) {
+	fflush(stdout);
+	for (int i = 1; i < argc && p_atomic_int_get(&engine->status) != STATUS_EXIT; i++) {
 		engine->config.protocol(engine, argv[i]);
 	}
-	while (engine->status != STATUS_EXIT) {
-		char *line = read_line(stdin);
-		engine->config.protocol(engine, line);
-		free(line);
+	struct LineReader reader;
+	line_reader_init(&reader, STDIN_FILENO);
+	while (p_atomic_int_get(&engine->status) != STATUS_EXIT) {
+		char *line = line_reader_next(&reader);
+		// Nobody is left to talk to once input is over.
+		char quit_cmd[] = "quit";
+		engine->config.protocol(engine, line ? line : quit_cmd);
 	}
+	line_reader_free(&reader);
 	engine_delete(engine);
 	p_libsys_shutdown();
 	return EXIT_SUCCESS;
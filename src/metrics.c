@@ -0,0 +1,259 @@
+/* SPDX-License-Identifier: GPL-3.0-only */
+
+#include "metrics.h"
+#include "utils.h"
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+struct Metrics
+{
+	// Protects the counters, which only change once per search.
+	PMutex *mutex;
+	PTimeProfiler *uptime;
+	size_t searches_count;
+	size_t nodes_count;
+	puint64 search_usecs;
+	size_t time_losses_count;
+	double last_nps;
+	/* -- Exporter thread. */
+	PUThread *thread;
+	volatile pint stop;
+	PSocket *socket;
+	char *path;
+};
+
+struct Metrics *
+metrics_new(void)
+{
+	struct Metrics *metrics = exit_if_null(malloc(sizeof(struct Metrics)));
+	*metrics = (struct Metrics){
+		.mutex = p_mutex_new(),
+		.uptime = p_time_profiler_new(),
+		.searches_count = 0,
+		.nodes_count = 0,
+		.search_usecs = 0,
+		.time_losses_count = 0,
+		.last_nps = 0.0,
+		.thread = NULL,
+		.stop = 0,
+		.socket = NULL,
+		.path = NULL,
+	};
+	return metrics;
+}
+
+static void
+metrics_stop_exporter(struct Metrics *metrics)
+{
+	if (!metrics->thread) {
+		return;
+	}
+	p_atomic_int_set(&metrics->stop, 1);
+	p_uthread_join(metrics->thread);
+	p_uthread_unref(metrics->thread);
+	metrics->thread = NULL;
+	p_atomic_int_set(&metrics->stop, 0);
+}
+
+void
+metrics_delete(struct Metrics *metrics)
+{
+	if (!metrics) {
+		return;
+	}
+	metrics_stop_exporter(metrics);
+	if (metrics->socket) {
+		p_socket_close(metrics->socket, NULL);
+		p_socket_free(metrics->socket);
+	}
+	free(metrics->path);
+	p_time_profiler_free(metrics->uptime);
+	p_mutex_free(metrics->mutex);
+	free(metrics);
+}
+
+void
+metrics_add_search(struct Metrics *metrics,
+                   size_t nodes_count,
+                   puint64 elapsed_usecs,
+                   bool is_time_loss)
+{
+	p_mutex_lock(metrics->mutex);
+	metrics->searches_count++;
+	metrics->nodes_count += nodes_count;
+	metrics->search_usecs += elapsed_usecs;
+	metrics->time_losses_count += is_time_loss;
+	if (elapsed_usecs) {
+		metrics->last_nps = nodes_count * 1000000.0 / elapsed_usecs;
+	}
+	p_mutex_unlock(metrics->mutex);
+}
+
+size_t
+metrics_sprint(struct Metrics *metrics, char *buf, size_t size)
+{
+	p_mutex_lock(metrics->mutex);
+	int length = snprintf(
+	  buf,
+	  size,
+	  "# TYPE zuloid_uptime_seconds gauge\n"
+	  "# UNIT zuloid_uptime_seconds seconds\n"
+	  "# HELP zuloid_uptime_seconds Time since the engine started.\n"
+	  "zuloid_uptime_seconds %.3f\n"
+	  "# TYPE zuloid_search_seconds summary\n"
+	  "# UNIT zuloid_search_seconds seconds\n"
+	  "# HELP zuloid_search_seconds Time spent on each search.\n"
+	  "zuloid_search_seconds_count %zu\n"
+	  "zuloid_search_seconds_sum %.6f\n"
+	  "# TYPE zuloid_search_nodes counter\n"
+	  "# HELP zuloid_search_nodes Nodes visited by all searches.\n"
+	  "zuloid_search_nodes_total %zu\n"
+	  "# TYPE zuloid_nps gauge\n"
+	  "# HELP zuloid_nps Nodes per second of the last search.\n"
+	  "zuloid_nps %.0f\n"
+	  "# TYPE zuloid_time_losses counter\n"
+	  "# HELP zuloid_time_losses Searches that took longer than their time limit.\n"
+	  "zuloid_time_losses_total %zu\n"
+	  "# EOF\n",
+	  p_time_profiler_elapsed_usecs(metrics->uptime) / 1e6,
+	  metrics->searches_count,
+	  metrics->search_usecs / 1e6,
+	  metrics->nodes_count,
+	  metrics->last_nps,
+	  metrics->time_losses_count);
+	p_mutex_unlock(metrics->mutex);
+	return length < 0 ? 0 : (size_t)length;
+}
+
+static void
+metrics_respond(struct Metrics *metrics, PSocket *client)
+{
+	// The request itself doesn't matter, but HTTP clients expect it to be
+	// read.
+	char request[1024];
+	p_socket_receive(client, request, sizeof(request), NULL);
+	char body[METRICS_MAX_SIZE];
+	size_t body_length = metrics_sprint(metrics, body, sizeof(body));
+	char header[256];
+	int header_length =
+	  snprintf(header,
+	           sizeof(header),
+	           "HTTP/1.0 200 OK\r\n"
+	           "Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n"
+	           "Content-Length: %zu\r\n"
+	           "Connection: close\r\n\r\n",
+	           body_length);
+	p_socket_send(client, header, header_length, NULL);
+	p_socket_send(client, body, body_length, NULL);
+	p_socket_close(client, NULL);
+	p_socket_free(client);
+}
+
+static void
+metrics_write_file(struct Metrics *metrics)
+{
+	// Scrapers must never see a half-written file.
+	char tmp_path[FILENAME_MAX];
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", metrics->path);
+	FILE *file = fopen(tmp_path, "w");
+	if (!file) {
+		return;
+	}
+	char body[METRICS_MAX_SIZE];
+	size_t body_length = metrics_sprint(metrics, body, sizeof(body));
+	bool ok = fwrite(body, 1, body_length, file) == body_length;
+	if (fclose(file) == 0 && ok) {
+		rename(tmp_path, metrics->path);
+	} else {
+		remove(tmp_path);
+	}
+}
+
+static ppointer
+metrics_exporter_run(ppointer data)
+{
+	struct Metrics *metrics = data;
+	PTimeProfiler *timer = p_time_profiler_new();
+	bool is_first_write = true;
+	while (!p_atomic_int_get(&metrics->stop)) {
+		// The socket has a timeout, so that we get to check `stop` regularly.
+		if (!metrics->socket) {
+			p_uthread_sleep(100);
+		} else if (p_socket_io_condition_wait(
+		             metrics->socket, P_SOCKET_IO_CONDITION_POLLIN, NULL)) {
+			PSocket *client = p_socket_accept(metrics->socket, NULL);
+			if (client) {
+				metrics_respond(metrics, client);
+			}
+		}
+		if (metrics->path &&
+		    (is_first_write ||
+		     p_time_profiler_elapsed_usecs(timer) / 1000 >= METRICS_FILE_INTERVAL_IN_MS)) {
+			metrics_write_file(metrics);
+			p_time_profiler_reset(timer);
+			is_first_write = false;
+		}
+	}
+	// One last time, so that the file is up to date when we stop.
+	if (metrics->path) {
+		metrics_write_file(metrics);
+	}
+	p_time_profiler_free(timer);
+	return NULL;
+}
+
+static void
+metrics_start_exporter(struct Metrics *metrics)
+{
+	assert(!metrics->thread);
+	if (metrics->socket || metrics->path) {
+		metrics->thread = p_uthread_create(metrics_exporter_run, metrics, true, "metrics");
+	}
+}
+
+int
+metrics_serve(struct Metrics *metrics, int port)
+{
+	metrics_stop_exporter(metrics);
+	int err = ERR_CODE_NONE;
+	if (metrics->socket) {
+		p_socket_close(metrics->socket, NULL);
+		p_socket_free(metrics->socket);
+		metrics->socket = NULL;
+	}
+	if (port > 0) {
+		PSocket *socket = p_socket_new(
+		  P_SOCKET_FAMILY_INET, P_SOCKET_TYPE_STREAM, P_SOCKET_PROTOCOL_TCP, NULL);
+		PSocketAddress *address = p_socket_address_new("127.0.0.1", port);
+		if (socket && address && p_socket_bind(socket, address, true, NULL) &&
+		    p_socket_listen(socket, NULL)) {
+			p_socket_set_timeout(socket, 100);
+			metrics->socket = socket;
+		} else {
+			err = ERR_CODE_IO;
+			if (socket) {
+				p_socket_free(socket);
+			}
+		}
+		if (address) {
+			p_socket_address_free(address);
+		}
+	}
+	metrics_start_exporter(metrics);
+	return err;
+}
+
+int
+metrics_export_to_file(struct Metrics *metrics, const char *path)
+{
+	metrics_stop_exporter(metrics);
+	free(metrics->path);
+	metrics->path = NULL;
+	if (path) {
+		metrics->path = exit_if_null(malloc(strlen(path) + 1));
+		strcpy(metrics->path, path);
+	}
+	metrics_start_exporter(metrics);
+	return ERR_CODE_NONE;
+}
@@ -0,0 +1,321 @@
+/* SPDX-License-Identifier: GPL-3.0-only */
+
+/* Analyzes every position of an EPD (or FEN) file, without any protocol in
+ * between. Worker threads take positions one at a time and run their own
+ * searches, sharing only the read-only attack tables. Results are written as
+ * soon as they're ready, one JSON object per line; they carry the input line
+ * number, since they might come out of order. */
+
+#include "cJSON/cJSON.h"
+#include "chess/fen.h"
+#include "chess/move.h"
+#include "chess/position.h"
+#include "core/search.h"
+#include "engine.h"
+#include "modes.h"
+#include "protocols/support/line_reader.h"
+#include "utils.h"
+#include <assert.h>
+#include <plibsys.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct AnalyzeSettings
+{
+	const char *input_path;
+	const char *output_path;
+	int threads_count;
+	int max_depth;
+	size_t max_nodes_count;
+	int movetime_in_ms;
+	size_t multipv;
+};
+
+struct Analysis
+{
+	const struct AnalyzeSettings *settings;
+	// Protects `reader` and `lines_count`.
+	PMutex *input_mutex;
+	FILE *input;
+	struct LineReader reader;
+	size_t lines_count;
+	// Protects `output` and the counters.
+	PMutex *output_mutex;
+	FILE *output;
+	size_t positions_count;
+	size_t skipped_count;
+};
+
+struct AnalyzeWorker
+{
+	struct Analysis *analysis;
+	PUThread *thread;
+	struct Config config;
+	struct SearchSignals signals;
+	struct SearchResults results;
+	// The shared reader reuses its buffer, so lines are copied here. It only
+	// ever grows.
+	char *line;
+	size_t line_capacity;
+};
+
+/* Returns a copy of the next non-empty line in `worker->line` and sets its
+ * line number, or returns NULL at the end of the input. */
+static char *
+analysis_next_line(struct Analysis *analysis, struct AnalyzeWorker *worker, size_t *line_num)
+{
+	char *line;
+	p_mutex_lock(analysis->input_mutex);
+	while ((line = line_reader_next(&analysis->reader))) {
+		*line_num = ++analysis->lines_count;
+		line = strtrim(line, WHITESPACE);
+		if (*line) {
+			break;
+		}
+	}
+	if (line) {
+		size_t size = strlen(line) + 1;
+		if (size > worker->line_capacity) {
+			worker->line_capacity = size * 2;
+			worker->line = exit_if_null(realloc(worker->line, worker->line_capacity));
+		}
+		line = memcpy(worker->line, line, size);
+	}
+	p_mutex_unlock(analysis->input_mutex);
+	return line;
+}
+
+/* The value of the "id" opcode, if any. Quotes are stripped in place. */
+static const char *
+epd_operations_id(char *operations)
+{
+	char *id = strstr(operations, "id ");
+	if (!id || (id != operations && !isspace(id[-1]) && id[-1] != ';')) {
+		return NULL;
+	}
+	id += 3 + strspn(id + 3, WHITESPACE);
+	if (*id == '"') {
+		char *end = strchr(++id, '"');
+		if (end) {
+			*end = '\0';
+		}
+	} else {
+		id[strcspn(id, "; \t")] = '\0';
+	}
+	return id;
+}
+
+static cJSON *
+json_from_move(struct Move mv)
+{
+	if (moves_eq(&mv, &MOVE_IDENTITY)) {
+		return cJSON_CreateNull();
+	}
+	char buf[MOVE_STRING_MAX_LENGTH] = { '\0' };
+	move_to_string(mv, buf);
+	return cJSON_CreateString(buf);
+}
+
+static void
+json_add_search_results(cJSON *json, const struct SearchResults *results, puint64 elapsed_usecs)
+{
+	cJSON_AddNumberToObject(json, "depth", results->depth);
+	cJSON_AddNumberToObject(json, "nodes", results->nodes_count);
+	cJSON_AddNumberToObject(json, "time", elapsed_usecs / 1000);
+	cJSON_AddItemToObject(json, "bestmove", json_from_move(results->best_move));
+	cJSON_AddItemToObject(json, "ponder", json_from_move(results->ponder_move));
+	cJSON *lines = cJSON_AddArrayToObject(json, "lines");
+	for (size_t i = 0; i < results->lines_count; i++) {
+		const struct SearchLine *line = results->lines + i;
+		cJSON *item = cJSON_CreateObject();
+		int mate_in_moves = score_to_mate_in_moves(line->centipawns);
+		if (mate_in_moves) {
+			cJSON_AddNumberToObject(item, "mate", mate_in_moves);
+		} else {
+			cJSON_AddNumberToObject(item, "cp", score_to_centipawns(line->centipawns));
+		}
+		cJSON *pv = cJSON_AddArrayToObject(item, "pv");
+		for (int j = 0; j < line->pv_length; j++) {
+			cJSON_AddItemToArray(pv, json_from_move(line->pv[j]));
+		}
+		cJSON_AddItemToArray(lines, item);
+	}
+}
+
+static void
+analyze_worker_search(struct AnalyzeWorker *worker, const struct Board *board, cJSON *json)
+{
+	const struct AnalyzeSettings *settings = worker->analysis->settings;
+	struct SearchSignals *signals = &worker->signals;
+	p_atomic_int_set(&signals->stop, 0);
+	p_atomic_int_set(&signals->time_limit_in_ms, settings->movetime_in_ms);
+	p_time_profiler_reset(signals->timer);
+	position_search(
+	  board, NULL, &worker->config, settings->max_depth, signals, &worker->results);
+	json_add_search_results(
+	  json, &worker->results, p_time_profiler_elapsed_usecs(signals->timer));
+}
+
+static void
+analysis_write(struct Analysis *analysis, cJSON *json, bool is_valid)
+{
+	char *str = cJSON_PrintUnformatted(json);
+	p_mutex_lock(analysis->output_mutex);
+	fputs(str, analysis->output);
+	fputc('\n', analysis->output);
+	analysis->positions_count += is_valid;
+	analysis->skipped_count += !is_valid;
+	p_mutex_unlock(analysis->output_mutex);
+	cJSON_free(str);
+}
+
+static ppointer
+analyze_worker_run(ppointer data)
+{
+	struct AnalyzeWorker *worker = data;
+	struct Analysis *analysis = worker->analysis;
+	size_t line_num;
+	char *line;
+	while ((line = analysis_next_line(analysis, worker, &line_num))) {
+		cJSON *json = cJSON_CreateObject();
+		cJSON_AddNumberToObject(json, "line", line_num);
+		struct Board board;
+		char *operations = NULL;
+		bool is_valid = position_init_from_epd(&board, line, &operations) == ERR_CODE_NONE;
+		const char *id = is_valid ? epd_operations_id(operations) : NULL;
+		if (id) {
+			cJSON_AddStringToObject(json, "id", id);
+		}
+		if (is_valid) {
+			char fen[FEN_SIZE];
+			cJSON_AddStringToObject(json, "fen", fen_from_position(fen, &board, ' '));
+			analyze_worker_search(worker, &board, json);
+		} else {
+			cJSON_AddStringToObject(json, "error", "Invalid FEN.");
+		}
+		analysis_write(analysis, json, is_valid);
+		cJSON_Delete(json);
+	}
+	return NULL;
+}
+
+static int
+analyze_settings_parse(struct AnalyzeSettings *settings, int argc, char **argv)
+{
+	*settings = (struct AnalyzeSettings){
+		.input_path = NULL,
+		.output_path = NULL,
+		.threads_count = 1,
+		.max_depth = 0,
+		.max_nodes_count = 0,
+		.movetime_in_ms = 0,
+		.multipv = 1,
+	};
+	for (int i = 0; i + 1 < argc; i += 2) {
+		if (strcmp(argv[i], "--input") == 0) {
+			settings->input_path = argv[i + 1];
+		} else if (strcmp(argv[i], "--output") == 0) {
+			settings->output_path = argv[i + 1];
+		} else if (strcmp(argv[i], "--threads") == 0) {
+			settings->threads_count = atoi(argv[i + 1]);
+		} else if (strcmp(argv[i], "--depth") == 0) {
+			settings->max_depth = atoi(argv[i + 1]);
+		} else if (strcmp(argv[i], "--nodes") == 0) {
+			settings->max_nodes_count = strtoull(argv[i + 1], NULL, 10);
+		} else if (strcmp(argv[i], "--movetime") == 0) {
+			settings->movetime_in_ms = atoi(argv[i + 1]);
+		} else if (strcmp(argv[i], "--multipv") == 0) {
+			settings->multipv = strtoull(argv[i + 1], NULL, 10);
+		} else {
+			return ERR_CODE_UNSUPPORTED;
+		}
+	}
+	if (argc % 2 != 0 || !settings->input_path || settings->threads_count < 1 ||
+	    settings->max_depth < 0 || settings->max_depth > SEARCH_MAX_DEPTH ||
+	    settings->movetime_in_ms < 0 || settings->multipv < 1 ||
+	    settings->multipv > SEARCH_MAX_MULTIPV) {
+		return ERR_CODE_UNSUPPORTED;
+	}
+	// Without any limits, a shallow search is better than an endless one.
+	if (!settings->max_depth) {
+		bool has_limits = settings->max_nodes_count || settings->movetime_in_ms;
+		settings->max_depth = has_limits ? SEARCH_MAX_DEPTH : 5;
+	}
+	return ERR_CODE_NONE;
+}
+
+int
+mode_analyze(int argc, char **argv)
+{
+	struct AnalyzeSettings settings;
+	if (analyze_settings_parse(&settings, argc, argv)) {
+		fputs("Usage: zuloid analyze --input <file.epd> [--output <file.jsonl>] [--threads <n>]\n"
+		      "         [--depth <plies>] [--nodes <n>] [--movetime <ms>] [--multipv <n>]\n",
+		      stderr);
+		return EXIT_FAILURE;
+	}
+	FILE *input = fopen(settings.input_path, "r");
+	if (!input) {
+		fprintf(stderr, "[ERROR] Can't open '%s'.\n", settings.input_path);
+		return EXIT_FAILURE;
+	}
+	FILE *output = settings.output_path ? fopen(settings.output_path, "w") : stdout;
+	if (!output) {
+		fprintf(stderr, "[ERROR] Can't open '%s'.\n", settings.output_path);
+		fclose(input);
+		return EXIT_FAILURE;
+	}
+	struct Analysis analysis = {
+		.settings = &settings,
+		.input_mutex = p_mutex_new(),
+		.input = input,
+		.lines_count = 0,
+		.output_mutex = p_mutex_new(),
+		.output = output,
+		.positions_count = 0,
+		.skipped_count = 0,
+	};
+	line_reader_init(&analysis.reader, fileno(input));
+	struct AnalyzeWorker *workers =
+	  exit_if_null(calloc(settings.threads_count, sizeof(struct AnalyzeWorker)));
+	for (int i = 0; i < settings.threads_count; i++) {
+		workers[i].analysis = &analysis;
+		workers[i].config = (struct Config){
+			// Analysis should be objective about draws.
+			.contempt = 0.5,
+			.multipv = settings.multipv,
+			.max_nodes_count = settings.max_nodes_count,
+			.max_depth = settings.max_depth,
+			.output = NULL,
+		};
+		workers[i].signals = (struct SearchSignals){
+			.stop = 0,
+			.ponder = 0,
+			.time_limit_in_ms = 0,
+			.timer = p_time_profiler_new(),
+		};
+		workers[i].thread = p_uthread_create(analyze_worker_run, workers + i, true, "analyze");
+	}
+	for (int i = 0; i < settings.threads_count; i++) {
+		p_uthread_join(workers[i].thread);
+		p_uthread_unref(workers[i].thread);
+		p_time_profiler_free(workers[i].signals.timer);
+		free(workers[i].line);
+	}
+	free(workers);
+	line_reader_free(&analysis.reader);
+	fclose(analysis.input);
+	p_mutex_free(analysis.input_mutex);
+	p_mutex_free(analysis.output_mutex);
+	int status = EXIT_SUCCESS;
+	if (analysis.output != stdout && fclose(analysis.output) != 0) {
+		fprintf(stderr, "[ERROR] Can't write to '%s'.\n", settings.output_path);
+		status = EXIT_FAILURE;
+	}
+	fprintf(stderr,
+	        "# %zu positions analyzed, %zu lines skipped.\n",
+	        analysis.positions_count,
+	        analysis.skipped_count);
+	return status;
+}
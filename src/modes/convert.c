@@ -0,0 +1,192 @@
+/* SPDX-License-Identifier: GPL-3.0-only */
+
+/* Converts EPD and PGN files into packed positions. EPD labels are taken from
+ * the "ce" (centipawn evaluation) and "c9" (game result) opcodes, or from a
+ * bare result string such as "1-0" or "[0.5]" anywhere after the FEN fields.
+ * PGN games yield every position before each move of the main line. */
+
+#include "chess/fen.h"
+#include "chess/move.h"
+#include "chess/packed.h"
+#include "chess/pgn.h"
+#include "chess/position.h"
+#include "modes.h"
+#include "protocols/support/line_reader.h"
+#include "utils.h"
+#include <assert.h>
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct Conversion
+{
+	struct PackedWriter *writer;
+	size_t positions_count;
+	size_t skipped_count;
+};
+
+/* Parses a game result, from White's point of view. */
+static int
+string_to_packed_result(const char *str)
+{
+	if (strstr(str, "1/2-1/2") || strstr(str, "[0.5]")) {
+		return PACKED_RESULT_DRAW;
+	} else if (strstr(str, "1-0") || strstr(str, "[1.0]")) {
+		return PACKED_RESULT_WIN;
+	} else if (strstr(str, "0-1") || strstr(str, "[0.0]")) {
+		return PACKED_RESULT_LOSS;
+	}
+	return PACKED_RESULT_UNKNOWN;
+}
+
+static int
+packed_result_for(int white_result, enum Color side_to_move)
+{
+	if (white_result == PACKED_RESULT_UNKNOWN || side_to_move == COLOR_WHITE) {
+		return white_result;
+	}
+	return PACKED_RESULT_WIN - white_result;
+}
+
+static int
+convert_epd_line(struct Conversion *conversion, char *line)
+{
+	struct Board board;
+	char *operations = NULL;
+	int err = position_init_from_epd(&board, line, &operations);
+	if (err) {
+		return err;
+	}
+	struct PackedPosition packed;
+	packed_from_position(&packed, &board);
+	packed.result =
+	  packed_result_for(string_to_packed_result(operations), board.side_to_move);
+	const char *ce = strstr(operations, "ce ");
+	if (ce && (ce == operations || isspace(ce[-1]) || ce[-1] == ';')) {
+		char *end = NULL;
+		long centipawns = strtol(ce + 3, &end, 10);
+		if (end != ce + 3 && centipawns > -INT16_MAX && centipawns < INT16_MAX) {
+			packed.score = centipawns;
+		}
+	}
+	conversion->positions_count++;
+	return packed_writer_push(conversion->writer, &packed);
+}
+
+/* Positions of the PGN game being read are buffered until its result is
+ * known. */
+struct PgnRecords
+{
+	struct Conversion *conversion;
+	struct PackedPosition *records;
+	size_t count;
+	size_t capacity;
+};
+
+static void
+pgn_records_push(void *data, const struct Board *pos, const struct Move *mv)
+{
+	UNUSED(mv);
+	struct PgnRecords *records = data;
+	if (records->count == records->capacity) {
+		records->capacity = records->capacity ? records->capacity * 2 : 128;
+		records->records = exit_if_null(
+		  realloc(records->records, records->capacity * sizeof(struct PackedPosition)));
+	}
+	packed_from_position(records->records + records->count++, pos);
+}
+
+static int
+pgn_records_flush(void *data, const struct PgnParser *parser)
+{
+	struct PgnRecords *records = data;
+	struct Conversion *conversion = records->conversion;
+	int err = ERR_CODE_NONE;
+	if (!parser->is_valid) {
+		conversion->skipped_count++;
+	}
+	for (size_t i = 0; i < records->count && parser->is_valid && !err; i++) {
+		struct PackedPosition *record = records->records + i;
+		record->result = packed_result_for((int)parser->result, record->flags & 1);
+		err = packed_writer_push(conversion->writer, record);
+		conversion->positions_count++;
+	}
+	records->count = 0;
+	return err;
+}
+
+static bool
+path_has_extension(const char *path, const char *extension)
+{
+	size_t path_length = strlen(path);
+	size_t extension_length = strlen(extension);
+	return path_length >= extension_length &&
+	       strncmpci(path + path_length - extension_length, extension) == 0;
+}
+
+int
+mode_convert(int argc, char **argv)
+{
+	const char *input_path = NULL;
+	const char *output_path = NULL;
+	for (int i = 0; i + 1 < argc; i += 2) {
+		if (strcmp(argv[i], "--input") == 0) {
+			input_path = argv[i + 1];
+		} else if (strcmp(argv[i], "--output") == 0) {
+			output_path = argv[i + 1];
+		}
+	}
+	if (!input_path || !output_path || argc % 2 != 0) {
+		fputs("Usage: zuloid convert --input <file.epd|file.pgn> --output <file>\n", stderr);
+		return EXIT_FAILURE;
+	}
+	FILE *input = fopen(input_path, "r");
+	if (!input) {
+		fprintf(stderr, "[ERROR] Can't open '%s'.\n", input_path);
+		return EXIT_FAILURE;
+	}
+	struct Conversion conversion = {
+		.writer = packed_writer_open(output_path),
+		.positions_count = 0,
+		.skipped_count = 0,
+	};
+	if (!conversion.writer) {
+		fprintf(stderr, "[ERROR] Can't open '%s'.\n", output_path);
+		fclose(input);
+		return EXIT_FAILURE;
+	}
+	bool is_pgn = path_has_extension(input_path, ".pgn");
+	struct PgnRecords records = { .conversion = &conversion, .records = NULL };
+	struct PgnParser parser;
+	pgn_parser_init(&parser, pgn_records_push, pgn_records_flush, &records);
+	struct LineReader reader;
+	line_reader_init(&reader, fileno(input));
+	int err = ERR_CODE_NONE;
+	char *line;
+	while (!err && (line = line_reader_next(&reader))) {
+		char *trimmed = strtrim(line, WHITESPACE);
+		if (is_pgn) {
+			err = pgn_parser_feed(&parser, trimmed);
+		} else if (*trimmed && convert_epd_line(&conversion, trimmed) != ERR_CODE_NONE) {
+			conversion.skipped_count++;
+		}
+	}
+	line_reader_free(&reader);
+	if (is_pgn && !err) {
+		err = pgn_parser_finish(&parser);
+	}
+	free(records.records);
+	fclose(input);
+	if (packed_writer_close(conversion.writer) != ERR_CODE_NONE || err) {
+		fprintf(stderr, "[ERROR] Can't write to '%s'.\n", output_path);
+		return EXIT_FAILURE;
+	}
+	fprintf(stderr,
+	        "# %zu positions written to '%s', %zu %s skipped.\n",
+	        conversion.positions_count,
+	        output_path,
+	        conversion.skipped_count,
+	        is_pgn ? "games" : "lines");
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,634 @@
+/* SPDX-License-Identifier: GPL-3.0-only */
+
+/* Builds Polyglot opening books out of PGN files. The main thread splits the
+ * input into batches of whole games, which worker threads parse and aggregate
+ * into a sharded hash map of (position, move) statistics. Shards that outgrow
+ * their share of the memory budget are sorted and spilled to temporary files,
+ * and all runs are finally merged into the sorted book. */
+
+#include "chess/book.h"
+#include "chess/color.h"
+#include "chess/move.h"
+#include "chess/pgn.h"
+#include "chess/position.h"
+#include "modes.h"
+#include "protocols/support/line_reader.h"
+#include "utils.h"
+#include <assert.h>
+#include <plibsys.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum
+{
+	MAKEBOOK_SHARDS_COUNT = 64,
+	MAKEBOOK_SHARD_MIN_CAPACITY = 1024,
+	MAKEBOOK_GAMES_PER_JOB = 256,
+	/* Jobs waiting to be parsed, per thread. */
+	MAKEBOOK_JOBS_PER_THREAD = 4,
+	/* Polyglot books can't have more than this many moves per position
+	 * anyway. */
+	MAKEBOOK_MAX_MOVES_PER_KEY = 256,
+};
+
+struct MakebookSettings
+{
+	const char *input_path;
+	const char *output_path;
+	int threads_count;
+	int max_plies;
+	int min_games;
+	size_t memory_in_mib;
+};
+
+/* Statistics of a move from a position. Empty hash map slots have no games. */
+struct BookRecord
+{
+	uint64_t key;
+	uint16_t move;
+	uint32_t games_count;
+	/* In half points, for the side that played the move. */
+	uint32_t score;
+};
+
+struct BookShard
+{
+	PMutex *mutex;
+	struct BookRecord *slots;
+	size_t capacity;
+	size_t count;
+};
+
+/* A sorted sequence of records, either in memory or spilled to a file. */
+struct BookRun
+{
+	FILE *file;
+	const struct BookRecord *records;
+	size_t count;
+	size_t next;
+	struct BookRecord head;
+};
+
+/* Some lines of PGN text, holding whole games only. */
+struct MakebookJob
+{
+	char *text;
+	size_t length;
+	size_t capacity;
+};
+
+struct Makebook
+{
+	const struct MakebookSettings *settings;
+	struct BookShard shards[MAKEBOOK_SHARDS_COUNT];
+	size_t shard_max_capacity;
+	// Protects `runs` and `runs_count`.
+	PMutex *runs_mutex;
+	struct BookRun *runs;
+	size_t runs_count;
+	// A bounded queue of jobs.
+	PMutex *jobs_mutex;
+	PCondVariable *jobs_not_empty;
+	PCondVariable *jobs_not_full;
+	struct MakebookJob **jobs;
+	size_t jobs_capacity;
+	size_t jobs_first;
+	size_t jobs_count;
+	bool jobs_done;
+	volatile pint games_count;
+	volatile pint skipped_count;
+};
+
+/* Moves are only added to the book once the game result is known. */
+struct MakebookPendingMove
+{
+	uint64_t key;
+	uint16_t move;
+	enum Color side_to_move;
+};
+
+struct MakebookWorker
+{
+	struct Makebook *makebook;
+	PUThread *thread;
+	struct PgnParser parser;
+	int plies_count;
+	struct MakebookPendingMove *pending;
+	size_t pending_count;
+};
+
+static int
+book_record_cmp(const void *r1, const void *r2)
+{
+	const struct BookRecord *record_1 = r1;
+	const struct BookRecord *record_2 = r2;
+	if (record_1->key != record_2->key) {
+		return record_1->key < record_2->key ? -1 : 1;
+	}
+	return (int)record_1->move - (int)record_2->move;
+}
+
+static size_t
+book_shard_slot(const struct BookShard *shard, uint64_t key, uint16_t move)
+{
+	// Keys are random already, but their highest bits select the shard.
+	return (key ^ (move * 0x9e3779b97f4a7c15ULL)) & (shard->capacity - 1);
+}
+
+static void
+book_shard_insert(struct BookShard *shard, const struct BookRecord *record)
+{
+	size_t i = book_shard_slot(shard, record->key, record->move);
+	while (shard->slots[i].games_count &&
+	       (shard->slots[i].key != record->key || shard->slots[i].move != record->move)) {
+		i = (i + 1) & (shard->capacity - 1);
+	}
+	struct BookRecord *slot = shard->slots + i;
+	if (!slot->games_count) {
+		*slot = (struct BookRecord){ .key = record->key, .move = record->move };
+		shard->count++;
+	}
+	slot->games_count += record->games_count;
+	slot->score += record->score;
+}
+
+static void
+book_shard_resize(struct BookShard *shard, size_t capacity)
+{
+	struct BookRecord *old_slots = shard->slots;
+	size_t old_capacity = shard->capacity;
+	shard->slots = exit_if_null(calloc(capacity, sizeof(struct BookRecord)));
+	shard->capacity = capacity;
+	shard->count = 0;
+	for (size_t i = 0; i < old_capacity; i++) {
+		if (old_slots[i].games_count) {
+			book_shard_insert(shard, old_slots + i);
+		}
+	}
+	free(old_slots);
+}
+
+/* Moves all records to the start of `shard->slots`, sorted. The shard is no
+ * longer a valid hash map afterwards. */
+static void
+book_shard_sort(struct BookShard *shard)
+{
+	size_t count = 0;
+	for (size_t i = 0; i < shard->capacity; i++) {
+		if (shard->slots[i].games_count) {
+			shard->slots[count++] = shard->slots[i];
+		}
+	}
+	assert(count == shard->count);
+	qsort(shard->slots, count, sizeof(struct BookRecord), book_record_cmp);
+}
+
+static void
+makebook_add_run(struct Makebook *makebook, struct BookRun run)
+{
+	p_mutex_lock(makebook->runs_mutex);
+	makebook->runs = exit_if_null(
+	  realloc(makebook->runs, (makebook->runs_count + 1) * sizeof(struct BookRun)));
+	makebook->runs[makebook->runs_count++] = run;
+	p_mutex_unlock(makebook->runs_mutex);
+}
+
+/* Writes the shard out as a sorted run and empties it. */
+static void
+makebook_spill_shard(struct Makebook *makebook, struct BookShard *shard)
+{
+	FILE *file = tmpfile();
+	book_shard_sort(shard);
+	if (!file || fwrite(shard->slots, sizeof(struct BookRecord), shard->count, file) !=
+	               shard->count) {
+		fputs("[ERROR] Can't write temporary files.\n", stderr);
+		exit(EXIT_FAILURE);
+	}
+	makebook_add_run(makebook, (struct BookRun){ .file = file, .count = shard->count });
+	memset(shard->slots, 0, shard->capacity * sizeof(struct BookRecord));
+	shard->count = 0;
+}
+
+static void
+makebook_add(struct Makebook *makebook, const struct BookRecord *record)
+{
+	struct BookShard *shard = makebook->shards + (record->key >> 58);
+	p_mutex_lock(shard->mutex);
+	// Linear probing gets slow past half load.
+	if (shard->count * 2 >= shard->capacity) {
+		if (shard->capacity * 2 <= makebook->shard_max_capacity) {
+			book_shard_resize(shard, shard->capacity * 2);
+		} else {
+			makebook_spill_shard(makebook, shard);
+		}
+	}
+	book_shard_insert(shard, record);
+	p_mutex_unlock(shard->mutex);
+}
+
+static void
+makebook_worker_on_move(void *data, const struct Board *pos, const struct Move *mv)
+{
+	struct MakebookWorker *worker = data;
+	if (worker->plies_count++ >= worker->makebook->settings->max_plies) {
+		return;
+	}
+	worker->pending[worker->pending_count++] = (struct MakebookPendingMove){
+		.key = position_polyglot_key(pos),
+		.move = book_move_encode(mv),
+		.side_to_move = pos->side_to_move,
+	};
+}
+
+static int
+makebook_worker_on_game(void *data, const struct PgnParser *parser)
+{
+	struct MakebookWorker *worker = data;
+	struct Makebook *makebook = worker->makebook;
+	if (!parser->is_valid || parser->result == PGN_RESULT_UNKNOWN) {
+		p_atomic_int_inc(&makebook->skipped_count);
+	} else {
+		p_atomic_int_inc(&makebook->games_count);
+		for (size_t i = 0; i < worker->pending_count; i++) {
+			const struct MakebookPendingMove *pending = worker->pending + i;
+			struct BookRecord record = {
+				.key = pending->key,
+				.move = pending->move,
+				.games_count = 1,
+				.score = pending->side_to_move == COLOR_WHITE
+				           ? parser->result
+				           : PGN_RESULT_WHITE_WINS - parser->result,
+			};
+			makebook_add(makebook, &record);
+		}
+	}
+	worker->plies_count = 0;
+	worker->pending_count = 0;
+	return ERR_CODE_NONE;
+}
+
+/* Returns NULL once there are no jobs left. */
+static struct MakebookJob *
+makebook_pop_job(struct Makebook *makebook)
+{
+	p_mutex_lock(makebook->jobs_mutex);
+	while (makebook->jobs_count == 0 && !makebook->jobs_done) {
+		p_cond_variable_wait(makebook->jobs_not_empty, makebook->jobs_mutex);
+	}
+	struct MakebookJob *job = NULL;
+	if (makebook->jobs_count > 0) {
+		job = makebook->jobs[makebook->jobs_first];
+		makebook->jobs_first = (makebook->jobs_first + 1) % makebook->jobs_capacity;
+		makebook->jobs_count--;
+		p_cond_variable_signal(makebook->jobs_not_full);
+	}
+	p_mutex_unlock(makebook->jobs_mutex);
+	return job;
+}
+
+static void
+makebook_push_job(struct Makebook *makebook, struct MakebookJob *job)
+{
+	p_mutex_lock(makebook->jobs_mutex);
+	while (makebook->jobs_count == makebook->jobs_capacity) {
+		p_cond_variable_wait(makebook->jobs_not_full, makebook->jobs_mutex);
+	}
+	size_t i = (makebook->jobs_first + makebook->jobs_count++) % makebook->jobs_capacity;
+	makebook->jobs[i] = job;
+	p_cond_variable_signal(makebook->jobs_not_empty);
+	p_mutex_unlock(makebook->jobs_mutex);
+}
+
+static ppointer
+makebook_worker_run(ppointer data)
+{
+	struct MakebookWorker *worker = data;
+	struct MakebookJob *job;
+	while ((job = makebook_pop_job(worker->makebook))) {
+		char *save = NULL;
+		for (char *line = strtok_r(job->text, "\n", &save); line;
+		     line = strtok_r(NULL, "\n", &save)) {
+			pgn_parser_feed(&worker->parser, line);
+		}
+		// Jobs hold whole games only.
+		pgn_parser_finish(&worker->parser);
+		free(job->text);
+		free(job);
+	}
+	return NULL;
+}
+
+static void
+makebook_job_append(struct MakebookJob *job, const char *line)
+{
+	size_t length = strlen(line);
+	if (job->length + length + 2 > job->capacity) {
+		job->capacity = (job->length + length + 2) * 2;
+		job->text = exit_if_null(realloc(job->text, job->capacity));
+	}
+	memcpy(job->text + job->length, line, length);
+	job->length += length;
+	job->text[job->length++] = '\n';
+	job->text[job->length] = '\0';
+}
+
+/* Splits `input` into jobs of whole games. Games end where the tags of the next
+ * one begin. */
+static void
+makebook_read_games(struct Makebook *makebook, FILE *input)
+{
+	struct MakebookJob *job = exit_if_null(calloc(1, sizeof(struct MakebookJob)));
+	size_t games_count = 0;
+	bool has_movetext = false;
+	struct LineReader reader;
+	line_reader_init(&reader, fileno(input));
+	char *line;
+	while ((line = line_reader_next(&reader))) {
+		char *trimmed = strtrim(line, WHITESPACE);
+		if (*trimmed == '[' && has_movetext) {
+			has_movetext = false;
+			if (++games_count % MAKEBOOK_GAMES_PER_JOB == 0) {
+				makebook_push_job(makebook, job);
+				job = exit_if_null(calloc(1, sizeof(struct MakebookJob)));
+			}
+		} else if (*trimmed && *trimmed != '[') {
+			has_movetext = true;
+		}
+		if (*trimmed) {
+			makebook_job_append(job, trimmed);
+		}
+	}
+	line_reader_free(&reader);
+	makebook_push_job(makebook, job);
+	p_mutex_lock(makebook->jobs_mutex);
+	makebook->jobs_done = true;
+	p_cond_variable_broadcast(makebook->jobs_not_empty);
+	p_mutex_unlock(makebook->jobs_mutex);
+}
+
+static bool
+book_run_next(struct BookRun *run)
+{
+	if (run->next == run->count) {
+		return false;
+	} else if (run->file) {
+		if (fread(&run->head, sizeof(struct BookRecord), 1, run->file) != 1) {
+			fputs("[ERROR] Can't read temporary files.\n", stderr);
+			exit(EXIT_FAILURE);
+		}
+	} else {
+		run->head = run->records[run->next];
+	}
+	run->next++;
+	return true;
+}
+
+/* A binary min-heap of runs, ordered by their heads. */
+static void
+book_runs_sift_down(struct BookRun **heap, size_t count, size_t i)
+{
+	while (true) {
+		size_t smallest = i;
+		for (size_t child = 2 * i + 1; child <= 2 * i + 2 && child < count; child++) {
+			if (book_record_cmp(&heap[child]->head, &heap[smallest]->head) < 0) {
+				smallest = child;
+			}
+		}
+		if (smallest == i) {
+			return;
+		}
+		struct BookRun *tmp = heap[i];
+		heap[i] = heap[smallest];
+		heap[smallest] = tmp;
+		i = smallest;
+	}
+}
+
+static int
+book_entry_weight_cmp(const void *r1, const void *r2)
+{
+	uint32_t score_1 = ((const struct BookRecord *)r1)->score;
+	uint32_t score_2 = ((const struct BookRecord *)r2)->score;
+	return (score_1 < score_2) - (score_1 > score_2);
+}
+
+static void
+write_big_endian(FILE *file, uint64_t value, size_t count)
+{
+	while (count-- > 0) {
+		fputc((value >> (count * 8)) & 0xff, file);
+	}
+}
+
+/* Writes the moves of a single position, best first. Weights are scaled down
+ * to fit into 16 bits if need be. */
+static size_t
+makebook_write_key(const struct MakebookSettings *settings,
+                   struct BookRecord *records,
+                   size_t count,
+                   FILE *output)
+{
+	qsort(records, count, sizeof(struct BookRecord), book_entry_weight_cmp);
+	uint32_t max_score = count ? records[0].score : 0;
+	size_t entries_count = 0;
+	for (size_t i = 0; i < count; i++) {
+		uint64_t weight = records[i].score;
+		if (max_score > UINT16_MAX) {
+			weight = weight * UINT16_MAX / max_score;
+		}
+		if (records[i].games_count < (uint32_t)settings->min_games || weight == 0) {
+			continue;
+		}
+		write_big_endian(output, records[i].key, 8);
+		write_big_endian(output, records[i].move, 2);
+		write_big_endian(output, weight, 2);
+		write_big_endian(output, 0, 4);
+		entries_count++;
+	}
+	return entries_count;
+}
+
+/* Merges all runs into the book, summing up the statistics of equal records.
+ * Returns the number of book entries. */
+static size_t
+makebook_merge(struct Makebook *makebook, FILE *output)
+{
+	struct BookRun **heap =
+	  exit_if_null(malloc((makebook->runs_count + 1) * sizeof(struct BookRun *)));
+	size_t heap_count = 0;
+	for (size_t i = 0; i < makebook->runs_count; i++) {
+		struct BookRun *run = makebook->runs + i;
+		if (run->file) {
+			rewind(run->file);
+		}
+		if (book_run_next(run)) {
+			heap[heap_count++] = run;
+		}
+	}
+	for (size_t i = heap_count; i-- > 0;) {
+		book_runs_sift_down(heap, heap_count, i);
+	}
+	struct BookRecord moves[MAKEBOOK_MAX_MOVES_PER_KEY];
+	size_t moves_count = 0;
+	size_t entries_count = 0;
+	while (heap_count > 0) {
+		struct BookRecord record = heap[0]->head;
+		if (!book_run_next(heap[0])) {
+			heap[0] = heap[--heap_count];
+		}
+		book_runs_sift_down(heap, heap_count, 0);
+		struct BookRecord *last = moves_count ? moves + moves_count - 1 : NULL;
+		if (last && last->key == record.key && last->move == record.move) {
+			last->games_count += record.games_count;
+			last->score += record.score;
+			continue;
+		} else if (last && last->key != record.key) {
+			entries_count += makebook_write_key(makebook->settings, moves, moves_count, output);
+			moves_count = 0;
+		}
+		if (moves_count < MAKEBOOK_MAX_MOVES_PER_KEY) {
+			moves[moves_count++] = record;
+		}
+	}
+	entries_count += makebook_write_key(makebook->settings, moves, moves_count, output);
+	free(heap);
+	return entries_count;
+}
+
+static int
+makebook_settings_parse(struct MakebookSettings *settings, int argc, char **argv)
+{
+	*settings = (struct MakebookSettings){
+		.input_path = NULL,
+		.output_path = NULL,
+		.threads_count = 1,
+		.max_plies = 40,
+		.min_games = 3,
+		.memory_in_mib = 1024,
+	};
+	for (int i = 0; i + 1 < argc; i += 2) {
+		if (strcmp(argv[i], "--input") == 0) {
+			settings->input_path = argv[i + 1];
+		} else if (strcmp(argv[i], "--output") == 0) {
+			settings->output_path = argv[i + 1];
+		} else if (strcmp(argv[i], "--threads") == 0) {
+			settings->threads_count = atoi(argv[i + 1]);
+		} else if (strcmp(argv[i], "--max-plies") == 0) {
+			settings->max_plies = atoi(argv[i + 1]);
+		} else if (strcmp(argv[i], "--min-games") == 0) {
+			settings->min_games = atoi(argv[i + 1]);
+		} else if (strcmp(argv[i], "--memory") == 0) {
+			settings->memory_in_mib = strtoull(argv[i + 1], NULL, 10);
+		} else {
+			return ERR_CODE_UNSUPPORTED;
+		}
+	}
+	if (argc % 2 != 0 || !settings->input_path || !settings->output_path ||
+	    settings->threads_count < 1 || settings->max_plies < 0 || settings->min_games < 1 ||
+	    settings->memory_in_mib < 1) {
+		return ERR_CODE_UNSUPPORTED;
+	}
+	return ERR_CODE_NONE;
+}
+
+int
+mode_makebook(int argc, char **argv)
+{
+	struct MakebookSettings settings;
+	if (makebook_settings_parse(&settings, argc, argv)) {
+		fputs("Usage: zuloid makebook --input <file.pgn> --output <file.bin> [--threads <n>]\n"
+		      "         [--max-plies <n>] [--min-games <n>] [--memory <MiB>]\n",
+		      stderr);
+		return EXIT_FAILURE;
+	}
+	FILE *input = fopen(settings.input_path, "r");
+	if (!input) {
+		fprintf(stderr, "[ERROR] Can't open '%s'.\n", settings.input_path);
+		return EXIT_FAILURE;
+	}
+	FILE *output = fopen(settings.output_path, "wb");
+	if (!output) {
+		fprintf(stderr, "[ERROR] Can't open '%s'.\n", settings.output_path);
+		fclose(input);
+		return EXIT_FAILURE;
+	}
+	struct Makebook makebook = {
+		.settings = &settings,
+		.shard_max_capacity = MAKEBOOK_SHARD_MIN_CAPACITY,
+		.runs_mutex = p_mutex_new(),
+		.jobs_mutex = p_mutex_new(),
+		.jobs_not_empty = p_cond_variable_new(),
+		.jobs_not_full = p_cond_variable_new(),
+		.jobs_capacity = settings.threads_count * MAKEBOOK_JOBS_PER_THREAD,
+	};
+	makebook.jobs = exit_if_null(malloc(makebook.jobs_capacity * sizeof(struct MakebookJob *)));
+	size_t shard_max_size = (settings.memory_in_mib << 20) / MAKEBOOK_SHARDS_COUNT;
+	while (makebook.shard_max_capacity * 2 * sizeof(struct BookRecord) <= shard_max_size) {
+		makebook.shard_max_capacity *= 2;
+	}
+	for (size_t i = 0; i < MAKEBOOK_SHARDS_COUNT; i++) {
+		makebook.shards[i] = (struct BookShard){
+			.mutex = p_mutex_new(),
+			.slots = exit_if_null(
+			  calloc(MAKEBOOK_SHARD_MIN_CAPACITY, sizeof(struct BookRecord))),
+			.capacity = MAKEBOOK_SHARD_MIN_CAPACITY,
+		};
+	}
+	struct MakebookWorker *workers =
+	  exit_if_null(calloc(settings.threads_count, sizeof(struct MakebookWorker)));
+	for (int i = 0; i < settings.threads_count; i++) {
+		workers[i].makebook = &makebook;
+		workers[i].pending =
+		  exit_if_null(malloc((settings.max_plies + 1) * sizeof(struct MakebookPendingMove)));
+		pgn_parser_init(
+		  &workers[i].parser, makebook_worker_on_move, makebook_worker_on_game, workers + i);
+		workers[i].thread =
+		  p_uthread_create(makebook_worker_run, workers + i, true, "makebook");
+	}
+	makebook_read_games(&makebook, input);
+	for (int i = 0; i < settings.threads_count; i++) {
+		p_uthread_join(workers[i].thread);
+		p_uthread_unref(workers[i].thread);
+		free(workers[i].pending);
+	}
+	free(workers);
+	fclose(input);
+	// Whatever is left in memory is merged with the spilled runs.
+	size_t spilled_runs_count = makebook.runs_count;
+	for (size_t i = 0; i < MAKEBOOK_SHARDS_COUNT; i++) {
+		struct BookShard *shard = makebook.shards + i;
+		book_shard_sort(shard);
+		makebook_add_run(&makebook,
+		                 (struct BookRun){ .records = shard->slots, .count = shard->count });
+	}
+	size_t entries_count = makebook_merge(&makebook, output);
+	for (size_t i = 0; i < makebook.runs_count; i++) {
+		if (makebook.runs[i].file) {
+			fclose(makebook.runs[i].file);
+		}
+	}
+	for (size_t i = 0; i < MAKEBOOK_SHARDS_COUNT; i++) {
+		p_mutex_free(makebook.shards[i].mutex);
+		free(makebook.shards[i].slots);
+	}
+	free(makebook.runs);
+	free(makebook.jobs);
+	p_mutex_free(makebook.runs_mutex);
+	p_mutex_free(makebook.jobs_mutex);
+	p_cond_variable_free(makebook.jobs_not_empty);
+	p_cond_variable_free(makebook.jobs_not_full);
+	if (fclose(output) != 0) {
+		fprintf(stderr, "[ERROR] Can't write to '%s'.\n", settings.output_path);
+		return EXIT_FAILURE;
+	}
+	fprintf(stderr,
+	        "# %d games read, %d skipped, %zu temporary runs; %zu entries written to '%s'.\n",
+	        makebook.games_count,
+	        makebook.skipped_count,
+	        spilled_runs_count,
+	        entries_count,
+	        settings.output_path);
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,295 @@
+/* SPDX-License-Identifier: GPL-3.0-only */
+
+/* Generates training data by letting the engine play against itself. Every
+ * position of every game is written to the output file as a `struct
+ * PackedPosition`, labelled with the search score and the final game result. */
+
+#include "chess/bb.h"
+#include "chess/color.h"
+#include "chess/history.h"
+#include "chess/move.h"
+#include "chess/movegen.h"
+#include "chess/packed.h"
+#include "chess/position.h"
+#include "core/search.h"
+#include "engine.h"
+#include "libpopcnt/libpopcnt.h"
+#include "meta.h"
+#include "modes.h"
+#include "utils.h"
+#include <assert.h>
+#include <plibsys.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum
+{
+	SELFPLAY_MAX_PLIES = 400,
+};
+
+struct SelfplaySettings
+{
+	int games_count;
+	int threads_count;
+	int max_depth;
+	size_t max_nodes_count;
+	float noise;
+	int random_plies;
+	float chess960_ratio;
+	uint64_t seed;
+	const char *output_path;
+};
+
+struct Selfplay
+{
+	const struct SelfplaySettings *settings;
+	struct PackedWriter *writer;
+	// Protects `writer` and `positions_count`.
+	PMutex *mutex;
+	volatile pint next_game_i;
+	size_t positions_count;
+};
+
+struct SelfplayWorker
+{
+	struct Selfplay *selfplay;
+	PUThread *thread;
+	uint64_t prng_state;
+	struct PackedPosition records[SELFPLAY_MAX_PLIES];
+};
+
+static float
+prng_next_float(uint64_t *state)
+{
+	return (prng_next(state) >> 40) / (float)(1 << 24);
+}
+
+static int16_t
+score_to_packed(float score)
+{
+	float centipawns = score * 100;
+	if (centipawns > INT16_MAX) {
+		return INT16_MAX;
+	} else if (centipawns < -INT16_MAX) {
+		return -INT16_MAX;
+	}
+	return (int16_t)centipawns;
+}
+
+static bool
+position_is_dead(const struct Board *pos)
+{
+	// Only the bare kings are left.
+	return popcnt64(pos->bb[COLOR_WHITE] | pos->bb[COLOR_BLACK]) <= 2;
+}
+
+static void
+selfplay_init_opening(struct SelfplayWorker *worker, struct Board *board)
+{
+	const struct SelfplaySettings *settings = worker->selfplay->settings;
+	if (prng_next_float(&worker->prng_state) < settings->chess960_ratio) {
+		position_init_960(board, &worker->prng_state);
+	} else {
+		*board = POSITION_INIT;
+	}
+}
+
+/* Picks the move to play at `plie`. `results` is only filled in past the
+ * random opening plies. */
+static struct Move
+selfplay_pick_move(struct SelfplayWorker *worker,
+                   const struct Board *board,
+                   const struct History *history,
+                   const struct Config *config,
+                   const struct Move moves[],
+                   size_t moves_count,
+                   int plie,
+                   struct SearchResults *results)
+{
+	const struct SelfplaySettings *settings = worker->selfplay->settings;
+	// Random openings aren't recorded, so they need no search at all.
+	if (plie < settings->random_plies) {
+		return moves[prng_next(&worker->prng_state) % moves_count];
+	}
+	position_search(board, history, config, settings->max_depth, NULL, results);
+	bool random = prng_next_float(&worker->prng_state) < config->move_selection_noise;
+	if (random || moves_eq(&results->best_move, &MOVE_IDENTITY)) {
+		return moves[prng_next(&worker->prng_state) % moves_count];
+	}
+	return results->best_move;
+}
+
+/* Plays a single game, buffering its positions in `worker->records`. Returns
+ * the number of buffered positions and sets `*result` from White's point of
+ * view. */
+static size_t
+selfplay_play_game(struct SelfplayWorker *worker, int *result)
+{
+	const struct SelfplaySettings *settings = worker->selfplay->settings;
+	struct Config config = {
+		.move_selection_noise = settings->noise,
+		// Both sides use the same engine, so neither should avoid draws.
+		.contempt = 0.5,
+		.max_nodes_count = settings->max_nodes_count,
+		.max_depth = settings->max_depth,
+		.output = NULL,
+	};
+	struct Board board;
+	selfplay_init_opening(worker, &board);
+	struct History history;
+	history_init(&history);
+	history_reset(&history, &board);
+	struct Move moves[MAX_MOVES];
+	size_t records_count = 0;
+	*result = PACKED_RESULT_DRAW;
+	for (int plie = 0; plie < SELFPLAY_MAX_PLIES; plie++) {
+		size_t moves_count = gen_legal_moves(moves, &board);
+		if (moves_count == 0) {
+			if (position_is_check(&board)) {
+				*result = board.side_to_move == COLOR_WHITE ? PACKED_RESULT_LOSS
+				                                            : PACKED_RESULT_WIN;
+			}
+			break;
+		} else if (board.reversible_moves_count >= FIFTY_MOVES_RULE_PLIES ||
+		           history_is_repetition(&history, board.reversible_moves_count) ||
+		           position_is_dead(&board)) {
+			// Drawn: fifty-move rule, repetition or insufficient material.
+			break;
+		}
+		struct SearchResults results;
+		struct Move move = selfplay_pick_move(
+		  worker, &board, &history, &config, moves, moves_count, plie, &results);
+		// Opening moves are random, so there's little to learn from them.
+		if (plie >= settings->random_plies) {
+			struct PackedPosition *record = worker->records + records_count++;
+			packed_from_position(record, &board);
+			record->score = score_to_packed(results.centipawns);
+		}
+		position_play_move(&board, &move);
+		history_push(&history, board.hash);
+	}
+	history_delete(&history);
+	for (size_t i = 0; i < records_count; i++) {
+		struct PackedPosition *record = worker->records + i;
+		bool white_to_move = (record->flags & 1) == COLOR_WHITE;
+		record->result = white_to_move ? *result : PACKED_RESULT_WIN - *result;
+	}
+	return records_count;
+}
+
+static ppointer
+selfplay_worker_run(ppointer data)
+{
+	struct SelfplayWorker *worker = data;
+	struct Selfplay *selfplay = worker->selfplay;
+	while (p_atomic_int_add(&selfplay->next_game_i, 1) <
+	       selfplay->settings->games_count) {
+		int result;
+		size_t records_count = selfplay_play_game(worker, &result);
+		// Whole games are written at once, so records from different threads
+		// never interleave within a game.
+		p_mutex_lock(selfplay->mutex);
+		for (size_t i = 0; i < records_count; i++) {
+			packed_writer_push(selfplay->writer, worker->records + i);
+		}
+		selfplay->positions_count += records_count;
+		p_mutex_unlock(selfplay->mutex);
+	}
+	return NULL;
+}
+
+static int
+selfplay_settings_parse(struct SelfplaySettings *settings, int argc, char **argv)
+{
+	*settings = (struct SelfplaySettings){
+		.games_count = 1,
+		.threads_count = 1,
+		.max_depth = 3,
+		.max_nodes_count = 0,
+		.noise = 0.0,
+		.random_plies = 8,
+		.chess960_ratio = 0.0,
+		.seed = ZULOID_PRNG_SEED,
+		.output_path = NULL,
+	};
+	for (int i = 0; i < argc; i++) {
+		const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+		if (!value) {
+			return ERR_CODE_UNSUPPORTED;
+		} else if (strcmp(argv[i], "--games") == 0) {
+			settings->games_count = atoi(value);
+		} else if (strcmp(argv[i], "--threads") == 0) {
+			settings->threads_count = atoi(value);
+		} else if (strcmp(argv[i], "--depth") == 0) {
+			settings->max_depth = atoi(value);
+		} else if (strcmp(argv[i], "--nodes") == 0) {
+			settings->max_nodes_count = strtoull(value, NULL, 10);
+		} else if (strcmp(argv[i], "--noise") == 0) {
+			settings->noise = atof(value);
+		} else if (strcmp(argv[i], "--random-plies") == 0) {
+			settings->random_plies = atoi(value);
+		} else if (strcmp(argv[i], "--960") == 0) {
+			settings->chess960_ratio = atof(value);
+		} else if (strcmp(argv[i], "--seed") == 0) {
+			settings->seed = strtoull(value, NULL, 10);
+		} else if (strcmp(argv[i], "--output") == 0) {
+			settings->output_path = value;
+		} else {
+			return ERR_CODE_UNSUPPORTED;
+		}
+		i++;
+	}
+	if (!settings->output_path || settings->games_count < 0 ||
+	    settings->threads_count < 1 || settings->max_depth < 1) {
+		return ERR_CODE_UNSUPPORTED;
+	}
+	return ERR_CODE_NONE;
+}
+
+int
+mode_selfplay(int argc, char **argv)
+{
+	struct SelfplaySettings settings;
+	if (selfplay_settings_parse(&settings, argc, argv)) {
+		fputs("Usage: zuloid selfplay --output <file> [--games <n>] [--threads <n>]\n"
+		      "         [--depth <plies>] [--nodes <n>] [--noise <p>]\n"
+		      "         [--random-plies <n>] [--960 <ratio>] [--seed <n>]\n",
+		      stderr);
+		return EXIT_FAILURE;
+	}
+	struct Selfplay selfplay = {
+		.settings = &settings,
+		.writer = packed_writer_open(settings.output_path),
+		.mutex = p_mutex_new(),
+		.next_game_i = 0,
+		.positions_count = 0,
+	};
+	if (!selfplay.writer) {
+		fprintf(stderr, "[ERROR] Can't open '%s'.\n", settings.output_path);
+		p_mutex_free(selfplay.mutex);
+		return EXIT_FAILURE;
+	}
+	struct SelfplayWorker *workers =
+	  exit_if_null(malloc(settings.threads_count * sizeof(struct SelfplayWorker)));
+	for (int i = 0; i < settings.threads_count; i++) {
+		workers[i].selfplay = &selfplay;
+		workers[i].prng_state = settings.seed + i;
+		workers[i].thread =
+		  p_uthread_create(selfplay_worker_run, workers + i, true, "selfplay");
+	}
+	for (int i = 0; i < settings.threads_count; i++) {
+		p_uthread_join(workers[i].thread);
+		p_uthread_unref(workers[i].thread);
+	}
+	free(workers);
+	p_mutex_free(selfplay.mutex);
+	int status = packed_writer_close(selfplay.writer) ? EXIT_FAILURE : EXIT_SUCCESS;
+	fprintf(stderr,
+	        "# Played %d games, %zu positions written to '%s'.\n",
+	        settings.games_count,
+	        selfplay.positions_count,
+	        settings.output_path);
+	return status;
+}
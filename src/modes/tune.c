@@ -0,0 +1,287 @@
+/* SPDX-License-Identifier: GPL-3.0-only */
+
+/* Texel tuning of the evaluation parameters. Each labelled position is first
+ * resolved to a quiet one by quiescence search, then the mean squared error
+ * between game results and sigmoid(K * eval) is minimized by gradient descent
+ * (Adam). See https://www.chessprogramming.org/Texel%27s_Tuning_Method. */
+
+#include "chess/packed.h"
+#include "chess/position.h"
+#include "core/eval.h"
+#include "core/generated/eval_params.h"
+#include "core/search.h"
+#include "modes.h"
+#include "utils.h"
+#include <assert.h>
+#include <math.h>
+#include <plibsys.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct TuneSettings
+{
+	const char *input_path;
+	const char *output_path;
+	int threads_count;
+	int iterations_count;
+	float learning_rate;
+};
+
+struct Tuner
+{
+	const struct TuneSettings *settings;
+	/* Quiet positions, with results from White's point of view. */
+	struct PackedPosition *positions;
+	size_t positions_count;
+	struct EvalParams params;
+	float k;
+};
+
+/* Each worker handles a contiguous slice of the positions, and accumulates its
+ * own loss and gradient so that no locking is needed. */
+struct TuneWorker
+{
+	struct Tuner *tuner;
+	PUThread *thread;
+	const struct PackedReader *reader;
+	size_t first;
+	size_t last;
+	// Outputs.
+	size_t positions_count;
+	double loss;
+	struct EvalParams gradient;
+};
+
+static float
+sigmoid(float k, float eval)
+{
+	return 1.0 / (1.0 + expf(-k * eval));
+}
+
+static float
+packed_result_to_float(const struct PackedPosition *packed)
+{
+	return packed->result * 0.5;
+}
+
+static ppointer
+tune_worker_resolve(ppointer data)
+{
+	struct TuneWorker *worker = data;
+	struct Tuner *tuner = worker->tuner;
+	worker->positions_count = 0;
+	for (size_t i = worker->first; i < worker->last; i++) {
+		const struct PackedPosition *packed = packed_reader_get(worker->reader, i);
+		if (packed->result == PACKED_RESULT_UNKNOWN) {
+			continue;
+		}
+		struct Board board;
+		struct Board leaf;
+		position_init_from_packed(&board, packed);
+		position_quiesce(&board, -SCORE_MATE, SCORE_MATE, &leaf);
+		// Resolved positions are compacted at the start of this worker's
+		// slice.
+		struct PackedPosition *quiet = tuner->positions + worker->first + worker->positions_count++;
+		packed_from_position(quiet, &leaf);
+		quiet->result = packed->flags & 1 ? PACKED_RESULT_WIN - packed->result : packed->result;
+	}
+	return NULL;
+}
+
+static ppointer
+tune_worker_run(ppointer data)
+{
+	struct TuneWorker *worker = data;
+	const struct Tuner *tuner = worker->tuner;
+	worker->loss = 0.0;
+	memset(&worker->gradient, 0, sizeof(struct EvalParams));
+	for (size_t i = worker->first; i < worker->first + worker->positions_count; i++) {
+		struct Board board;
+		position_init_from_packed(&board, tuner->positions + i);
+		float eval = position_eval_with_params(&board, &tuner->params, NULL, 0.0);
+		float prediction = sigmoid(tuner->k, eval);
+		float error = packed_result_to_float(tuner->positions + i) - prediction;
+		worker->loss += error * error;
+		// d(error^2)/d(eval), then the chain rule takes care of the rest.
+		float scale = -2.0 * error * tuner->k * prediction * (1.0 - prediction);
+		position_eval_with_params(&board, &tuner->params, &worker->gradient, scale);
+	}
+	return NULL;
+}
+
+static void
+tune_workers_spawn(struct TuneWorker *workers, int count, PUThreadFunc func)
+{
+	for (int i = 0; i < count; i++) {
+		workers[i].thread = p_uthread_create(func, workers + i, true, "tune");
+	}
+	for (int i = 0; i < count; i++) {
+		p_uthread_join(workers[i].thread);
+		p_uthread_unref(workers[i].thread);
+	}
+}
+
+/* Mean loss over all positions. The gradient is left in `gradient`, if not
+ * NULL. */
+static double
+tuner_loss(struct Tuner *tuner, struct TuneWorker *workers, struct EvalParams *gradient)
+{
+	int threads_count = tuner->settings->threads_count;
+	tune_workers_spawn(workers, threads_count, tune_worker_run);
+	double loss = 0.0;
+	size_t count = 0;
+	float *sum = (float *)gradient;
+	if (sum) {
+		memset(gradient, 0, sizeof(struct EvalParams));
+	}
+	for (int i = 0; i < threads_count; i++) {
+		loss += workers[i].loss;
+		count += workers[i].positions_count;
+		const float *partial = (const float *)&workers[i].gradient;
+		for (size_t j = 0; sum && j < EVAL_PARAMS_COUNT; j++) {
+			sum[j] += partial[j];
+		}
+	}
+	for (size_t j = 0; sum && count && j < EVAL_PARAMS_COUNT; j++) {
+		sum[j] /= count;
+	}
+	return count ? loss / count : 0.0;
+}
+
+/* Finds the scaling constant that best fits the initial parameters, by
+ * repeatedly narrowing a linear scan. */
+static void
+tuner_fit_k(struct Tuner *tuner, struct TuneWorker *workers)
+{
+	float best_k = 1.0;
+	double best_loss = INFINITY;
+	float step = 1.0;
+	for (int round = 0; round < 4; round++, step /= 10) {
+		float center = best_k;
+		for (int i = -9; i <= 9; i++) {
+			tuner->k = center + i * step;
+			if (tuner->k <= 0.0) {
+				continue;
+			}
+			double loss = tuner_loss(tuner, workers, NULL);
+			if (loss < best_loss) {
+				best_loss = loss;
+				best_k = tuner->k;
+			}
+		}
+	}
+	tuner->k = best_k;
+}
+
+static void
+tuner_descend(struct Tuner *tuner, struct TuneWorker *workers)
+{
+	const float BETA_1 = 0.9;
+	const float BETA_2 = 0.999;
+	const float EPSILON = 1e-8;
+	float *params = (float *)&tuner->params;
+	struct EvalParams gradient;
+	float moments[EVAL_PARAMS_COUNT] = { 0.0 };
+	float velocities[EVAL_PARAMS_COUNT] = { 0.0 };
+	const float *g = (const float *)&gradient;
+	for (int t = 1; t <= tuner->settings->iterations_count; t++) {
+		double loss = tuner_loss(tuner, workers, &gradient);
+		for (size_t j = 0; j < EVAL_PARAMS_COUNT; j++) {
+			moments[j] = BETA_1 * moments[j] + (1 - BETA_1) * g[j];
+			velocities[j] = BETA_2 * velocities[j] + (1 - BETA_2) * g[j] * g[j];
+			float m = moments[j] / (1 - powf(BETA_1, t));
+			float v = velocities[j] / (1 - powf(BETA_2, t));
+			params[j] -= tuner->settings->learning_rate * m / (sqrtf(v) + EPSILON);
+		}
+		if (t % 10 == 0 || t == 1) {
+			fprintf(stderr, "# Iteration %d, loss %.6f\n", t, loss);
+		}
+	}
+}
+
+static int
+tune_settings_parse(struct TuneSettings *settings, int argc, char **argv)
+{
+	*settings = (struct TuneSettings){
+		.input_path = NULL,
+		.output_path = NULL,
+		.threads_count = 1,
+		.iterations_count = 500,
+		.learning_rate = 0.002,
+	};
+	for (int i = 0; i + 1 < argc; i += 2) {
+		if (strcmp(argv[i], "--input") == 0) {
+			settings->input_path = argv[i + 1];
+		} else if (strcmp(argv[i], "--output") == 0) {
+			settings->output_path = argv[i + 1];
+		} else if (strcmp(argv[i], "--threads") == 0) {
+			settings->threads_count = atoi(argv[i + 1]);
+		} else if (strcmp(argv[i], "--iterations") == 0) {
+			settings->iterations_count = atoi(argv[i + 1]);
+		} else if (strcmp(argv[i], "--learning-rate") == 0) {
+			settings->learning_rate = atof(argv[i + 1]);
+		} else {
+			return ERR_CODE_UNSUPPORTED;
+		}
+	}
+	if (argc % 2 != 0 || !settings->input_path || !settings->output_path ||
+	    settings->threads_count < 1 || settings->iterations_count < 0) {
+		return ERR_CODE_UNSUPPORTED;
+	}
+	return ERR_CODE_NONE;
+}
+
+int
+mode_tune(int argc, char **argv)
+{
+	struct TuneSettings settings;
+	if (tune_settings_parse(&settings, argc, argv)) {
+		fputs("Usage: zuloid tune --input <file> --output <file.c> [--threads <n>]\n"
+		      "         [--iterations <n>] [--learning-rate <x>]\n",
+		      stderr);
+		return EXIT_FAILURE;
+	}
+	struct PackedReader *reader = packed_reader_open(settings.input_path);
+	if (!reader) {
+		fprintf(stderr, "[ERROR] Can't read '%s'.\n", settings.input_path);
+		return EXIT_FAILURE;
+	}
+	size_t count = packed_reader_count(reader);
+	struct Tuner tuner = {
+		.settings = &settings,
+		.positions = exit_if_null(malloc((count ? count : 1) * sizeof(struct PackedPosition))),
+		.positions_count = 0,
+		.params = EVAL_PARAMS,
+		.k = 1.0,
+	};
+	struct TuneWorker *workers =
+	  exit_if_null(calloc(settings.threads_count, sizeof(struct TuneWorker)));
+	for (int i = 0; i < settings.threads_count; i++) {
+		workers[i].tuner = &tuner;
+		workers[i].reader = reader;
+		workers[i].first = count * i / settings.threads_count;
+		workers[i].last = count * (i + 1) / settings.threads_count;
+	}
+	tune_workers_spawn(workers, settings.threads_count, tune_worker_resolve);
+	packed_reader_close(reader);
+	for (int i = 0; i < settings.threads_count; i++) {
+		tuner.positions_count += workers[i].positions_count;
+	}
+	fprintf(stderr, "# %zu labelled positions.\n", tuner.positions_count);
+	tuner_fit_k(&tuner, workers);
+	fprintf(stderr, "# K = %.4f\n", tuner.k);
+	tuner_descend(&tuner, workers);
+	free(workers);
+	free(tuner.positions);
+	FILE *output = fopen(settings.output_path, "w");
+	if (!output) {
+		fprintf(stderr, "[ERROR] Can't open '%s'.\n", settings.output_path);
+		return EXIT_FAILURE;
+	}
+	fputs("/* SPDX-License-Identifier: GPL-3.0-only */\n\n"
+	      "#include \"core/generated/eval_params.h\"\n",
+	      output);
+	eval_params_export(&tuner.params, "EVAL_PARAMS", output);
+	return fclose(output) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
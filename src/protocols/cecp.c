@@ -41,12 +41,14 @@ engine_call_cecp_protover(struct Engine *engine, struct PState *pstate)
 		"nps=0",     "pause=1",  "memory=1",    "smp=1",      "usermove=1",
 		"exclude=1", "sigint=0", "sigterm=0",   "setboard=1", "reuse=0",
 	};
+	engine_output_begin(engine);
 	fputs("feature", engine->config.output);
 	for (size_t i = 0; i < ARRAY_SIZE(features); i++) {
 		fprintf(engine->config.output, " %s", features[i]);
 	}
 	fputc('\n', engine->config.output);
 	fputs("feature done=1\n", engine->config.output);
+	engine_output_end(engine);
 }
 
 void
@@ -64,14 +66,17 @@ void
 engine_call_cecp_quit(struct Engine *engine, struct PState *pstate)
 {
 	UNUSED(pstate);
-	engine->status = STATUS_EXIT;
+	engine_stop_search(engine);
+	p_atomic_int_set(&engine->status, STATUS_EXIT);
 }
 
 void
 engine_call_cecp_playother(struct Engine *engine, struct PState *pstate)
 {
 	UNUSED(pstate);
-	engine->board.side_to_move = color_other(engine->board.side_to_move);
+	struct Board board = engine->board;
+	position_flip_side_to_move(&board);
+	engine_reset_game(engine, &board);
 }
 
 void
@@ -95,7 +100,9 @@ engine_call_cecp_setboard(struct Engine *engine, struct PState *pstate)
 		}
 		fen_fields[i] = token;
 	}
-	position_init_from_fen_fields(&engine->board, fen_fields);
+	struct Board board;
+	position_init_from_fen_fields(&board, fen_fields);
+	engine_reset_game(engine, &board);
 }
 
 void
@@ -109,14 +116,14 @@ void
 engine_call_cecp_result(struct Engine *engine, struct PState *pstate)
 {
 	UNUSED(pstate);
-	engine->status = STATUS_IDLE;
+	engine_stop_search(engine);
 }
 
 void
 engine_call_cecp_new(struct Engine *engine, struct PState *pstate)
 {
 	UNUSED(pstate);
-	position_init_from_fen(&engine->board, FEN_OF_INITIAL_POSITION);
+	engine_reset_game(engine, &POSITION_INIT);
 }
 
 void
@@ -178,7 +185,7 @@ engine_call_cecp_usermove(struct Engine *engine, struct PState *pstate)
 	if (token) {
 		struct Move mv;
 		string_to_move(token, &mv);
-		position_do_move_and_flip(&engine->board, &mv);
+		engine_play_move(engine, mv);
 	} else {
 		display_err_syntax(engine->config.output);
 	}
@@ -222,13 +229,17 @@ engine_call_cecp_sd(struct Engine *engine, struct PState *pstate)
 void
 engine_call_cecp_exit(struct Engine *engine, struct PState *pstate)
 {
-	engine->status = STATUS_IDLE;
 	engine_stop_search(engine);
 }
 
 void
 engine_call_cecp_analyze(struct Engine *engine, struct PState *pstate)
 {
+	engine->config.max_depth = 0;
+	engine->config.max_nodes_count = 0;
+	// Analysis mode never ends on its own.
+	p_atomic_int_set(&engine->search_signals.time_limit_in_ms, 0);
+	p_atomic_int_set(&engine->search_signals.ponder, 1);
 	engine_start_search(engine);
 }
 
@@ -308,9 +319,11 @@ const struct PCommand CECP_COMMANDS[] = {
 };
 
 void
-engine_call_cecp(struct Engine *engine, const char *str)
+engine_call_cecp(struct Engine *engine, char *str)
 {
-	struct PState *pstate = pstate_new(str, CECP_COMMANDS, ARRAY_SIZE(CECP_COMMANDS));
+	struct PState state;
+	struct PState *pstate = &state;
+	pstate_init(pstate, str, CECP_COMMANDS, ARRAY_SIZE(CECP_COMMANDS));
 	if (!pstate->token) {
 		;
 	} else if (pstate->cmd) {
@@ -319,9 +332,10 @@ engine_call_cecp(struct Engine *engine, const char *str)
 	} else if (string_represents_coordinate_notation_move(pstate->token)) {
 		struct Move move;
 		string_to_move(pstate->token, &move);
-		position_do_move_and_flip(&engine->board, &move);
+		engine_play_move(engine, move);
 	} else {
 		display_err_invalid_command(engine->config.output);
 	}
-	pstate_free(pstate);
+	// The whole response goes out at once.
+	fflush(engine->config.output);
 }
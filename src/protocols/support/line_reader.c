@@ -0,0 +1,85 @@
+/* SPDX-License-Identifier: GPL-3.0-only */
+
+#include "protocols/support/line_reader.h"
+#include "utils.h"
+#include <assert.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+
+void
+line_reader_init(struct LineReader *reader, int fd)
+{
+	assert(reader);
+	*reader = (struct LineReader){
+		.fd = fd,
+		.buf = exit_if_null(malloc(LINE_READER_MIN_CAPACITY)),
+		.capacity = LINE_READER_MIN_CAPACITY,
+		.start = 0,
+		.end = 0,
+		.is_eof = false,
+	};
+}
+
+void
+line_reader_free(struct LineReader *reader)
+{
+	free(reader->buf);
+	reader->buf = NULL;
+}
+
+/* Makes room for more input, moving unread input to the front of the buffer
+ * or, if it already fills the buffer, growing it. Then reads as much as
+ * available. */
+static void
+line_reader_fill(struct LineReader *reader)
+{
+	if (reader->start > 0) {
+		memmove(reader->buf, reader->buf + reader->start, reader->end - reader->start);
+		reader->end -= reader->start;
+		reader->start = 0;
+	}
+	// One byte is always left for the null terminator.
+	if (reader->end + 1 == reader->capacity) {
+		reader->capacity *= 2;
+		reader->buf = exit_if_null(realloc(reader->buf, reader->capacity));
+	}
+	ssize_t count;
+	do {
+		count = read(reader->fd, reader->buf + reader->end, reader->capacity - reader->end - 1);
+	} while (count < 0 && errno == EINTR);
+	if (count <= 0) {
+		reader->is_eof = true;
+	} else {
+		reader->end += count;
+	}
+}
+
+char *
+line_reader_next(struct LineReader *reader)
+{
+	// Newlines are only searched for in new input.
+	size_t scanned = reader->start;
+	while (true) {
+		char *newline = memchr(reader->buf + scanned, '\n', reader->end - scanned);
+		if (newline) {
+			char *line = reader->buf + reader->start;
+			*newline = '\0';
+			reader->start = newline - reader->buf + 1;
+			return line;
+		} else if (reader->is_eof) {
+			break;
+		}
+		scanned = reader->end - reader->start;
+		line_reader_fill(reader);
+		scanned += reader->start;
+	}
+	// The last line might lack a newline.
+	if (reader->start == reader->end) {
+		return NULL;
+	}
+	char *line = reader->buf + reader->start;
+	reader->buf[reader->end] = '\0';
+	reader->start = reader->end;
+	return line;
+}
@@ -13,21 +13,12 @@ pcommand_cmp(const void *cmd1, const void *cmd2)
 	return strcmp(s1, s2);
 }
 
-struct PState *
-pstate_new(const char *str, const struct PCommand commands[], size_t count)
+void
+pstate_init(struct PState *pstate, char *str, const struct PCommand commands[], size_t count)
 {
-	struct PState *pstate = malloc(sizeof(struct PState));
-	exit_if_null(pstate);
-	char *str_w = exit_if_null(malloc(strlen(str) + 1));
-	strcpy(str_w, str);
-	*pstate = (struct PState){
-		.original = str,
-		.str = str_w,
-		.token = NULL,
-		.saveptr = NULL,
-		.cmd = NULL,
-	};
-	pstate->token = strtok_r_whitespace(str_w, &pstate->saveptr);
+	pstate->saveptr = NULL;
+	pstate->token = strtok_r_whitespace(str, &pstate->saveptr);
+	pstate->cmd = NULL;
 	if (pstate->token) {
 		struct PCommand key = {
 			.name = pstate->token,
@@ -36,14 +27,6 @@ pstate_new(const char *str, const struct PCommand commands[], size_t count)
 		pstate->cmd = (struct PCommand *)(bsearch(
 		  &key, commands, count, sizeof(struct PCommand), pcommand_cmp));
 	}
-	return pstate;
-}
-
-void
-pstate_free(struct PState *pstate)
-{
-	free(pstate->str);
-	free(pstate);
 }
 
 const char *
@@ -8,19 +8,25 @@
 #include "protocols/uci.h"
 #include "agent.h"
 #include "cache/cache.h"
+#include "cJSON/cJSON.h"
 #include "chess/bb.h"
+#include "chess/book.h"
 #include "chess/fen.h"
 #include "chess/magic.h"
 #include "chess/movegen.h"
 #include "chess/position.h"
 #include "chess/threats.h"
 #include "core/eval.h"
+#include "core/search.h"
 #include "engine.h"
+#include "logger.h"
 #include "meta.h"
+#include "metrics.h"
 #include "protocols/cecp.h"
 #include "protocols/support/err.h"
 #include "protocols/support/pstate.h"
 #include "protocols/support/uci_option.h"
+#include "time/time_manager.h"
 #include "rating.h"
 #include "feature_flags.h"
 #include "utils.h"
@@ -36,6 +42,13 @@ engine_set_ponder(struct Engine *engine, bool val)
 	return 0;
 }
 
+int
+engine_set_multipv(struct Engine *engine, long val)
+{
+	engine->config.multipv = val;
+	return 0;
+}
+
 int
 engine_set_contempt(struct Engine *engine, long val)
 {
@@ -43,6 +56,13 @@ engine_set_contempt(struct Engine *engine, long val)
 	return 0;
 }
 
+int
+engine_set_selectivity(struct Engine *engine, long val)
+{
+	engine->config.selectivity = (float)val / 100.0;
+	return 0;
+}
+
 int
 engine_set_skill_level(struct Engine *engine, long val)
 {
@@ -57,6 +77,64 @@ engine_set_hash(struct Engine *engine, long val)
 	return 0;
 }
 
+int
+engine_set_debug_log_file(struct Engine *engine, const char *val)
+{
+	bool is_empty = !*val || strcmp(val, "<empty>") == 0;
+	int err = logger_open(engine->logger, is_empty ? NULL : val);
+	if (err) {
+		ENGINE_LOGF(engine, "[ERROR] Can't open '%s'.\n", val);
+	}
+	return err;
+}
+
+int
+engine_set_metrics_file(struct Engine *engine, const char *val)
+{
+	bool is_empty = !*val || strcmp(val, "<empty>") == 0;
+	return metrics_export_to_file(engine->metrics, is_empty ? NULL : val);
+}
+
+int
+engine_set_metrics_port(struct Engine *engine, long val)
+{
+	int err = metrics_serve(engine->metrics, val);
+	if (err) {
+		ENGINE_LOGF(engine, "[ERROR] Can't listen on port %ld.\n", val);
+	}
+	return err;
+}
+
+int
+engine_set_book_best_move_only(struct Engine *engine, bool val)
+{
+	engine->config.book_best_move_only = val;
+	return 0;
+}
+
+int
+engine_set_book_depth(struct Engine *engine, long val)
+{
+	engine->config.book_max_plies = val;
+	return 0;
+}
+
+int
+engine_set_book_file(struct Engine *engine, const char *val)
+{
+	book_close(engine->book);
+	engine->book = NULL;
+	if (!*val || strcmp(val, "<empty>") == 0) {
+		return 0;
+	}
+	engine->book = book_open(val);
+	if (!engine->book) {
+		ENGINE_LOGF(engine, "[ERROR] Can't load the opening book '%s'.\n", val);
+		return ERR_CODE_IO;
+	}
+	return 0;
+}
+
 int
 engine_set_uci_limit_strength(struct Engine *engine, bool val)
 {
@@ -120,6 +198,19 @@ engine_set_uci_elo(struct Engine *engine, long val)
 	return 0;
 }
 
+int
+engine_set_weights_file(struct Engine *engine, const char *val)
+{
+	if (strcmp(val, "<empty>") == 0) {
+		return 0;
+	}
+	int err = agent_load_weights(engine->agent, val);
+	if (err) {
+		ENGINE_LOGF(engine, "[ERROR] Can't load weights from '%s'.\n", val);
+	}
+	return err;
+}
+
 /* Option support is quite hairy and messy. I don't want to break pre-existing
  * scripts and configs originally written for other engines.
  *
@@ -132,6 +223,15 @@ static const struct UciOption UCI_OPTIONS[] = {
 	  .type = UCI_OPTION_TYPE_COMBO,
 	  .data.string = { .default_val = "Both",
 	                   .combo_variants = "[Off][White][Black][Both]" } },
+	{ .name = "Best Book Move",
+	  .type = UCI_OPTION_TYPE_CHECK,
+	  .data.check = { .default_val = false, .setter = engine_set_book_best_move_only } },
+	{ .name = "Book Depth",
+	  .type = UCI_OPTION_TYPE_SPIN,
+	  .data.spin = { .default_val = 0, .min = 0, .max = 1000, .setter = engine_set_book_depth } },
+	{ .name = "Book File",
+	  .type = UCI_OPTION_TYPE_STRING,
+	  .data.string = { .default_val = "<empty>", .setter = engine_set_book_file } },
 	{ .name = "Clear Hash",
 	  .type = UCI_OPTION_TYPE_BUTTON,
 	  .data.button = { .setter = NULL } },
@@ -140,23 +240,44 @@ static const struct UciOption UCI_OPTIONS[] = {
 	  .data.spin = { .default_val = 24, .min = -100, .max = 100 } },
 	{ .name = "Debug Log File",
 	  .type = UCI_OPTION_TYPE_STRING,
-	  .data.string = { .default_val = "/tmp/zuloid-tmp" } },
+	  .data.string = { .default_val = "<empty>", .setter = engine_set_debug_log_file } },
 	{ .name = "Hash",
 	  .type = UCI_OPTION_TYPE_SPIN,
 	  .data
 	    .spin = { .default_val = 64, .min = 0, .max = 131072, .setter = engine_set_hash } },
+	{ .name = "Metrics File",
+	  .type = UCI_OPTION_TYPE_STRING,
+	  .data.string = { .default_val = "<empty>", .setter = engine_set_metrics_file } },
+	{ .name = "Metrics Port",
+	  .type = UCI_OPTION_TYPE_SPIN,
+	  .data.spin = { .default_val = 0,
+	                 .min = 0,
+	                 .max = 65535,
+	                 .setter = engine_set_metrics_port } },
 	{ .name = "Minimum Thinking Time",
 	  .type = UCI_OPTION_TYPE_SPIN,
 	  .data.spin = { .default_val = 20, .min = 0, .max = 5000 } },
 	{ .name = "Move Overhead",
 	  .type = UCI_OPTION_TYPE_SPIN,
 	  .data.spin = { .default_val = 30, .min = 30, .max = 60000 } },
+	{ .name = "MultiPV",
+	  .type = UCI_OPTION_TYPE_SPIN,
+	  .data.spin = { .default_val = 1,
+	                 .min = 1,
+	                 .max = SEARCH_MAX_MULTIPV,
+	                 .setter = engine_set_multipv } },
 	{ .name = "nodestime",
 	  .type = UCI_OPTION_TYPE_SPIN,
 	  .data.spin = { .default_val = 0, .min = 0, .max = 10000 } },
 	{ .name = "Ponder",
 	  .type = UCI_OPTION_TYPE_CHECK,
 	  .data.check = { .default_val = false, .setter = engine_set_ponder } },
+	{ .name = "Selectivity",
+	  .type = UCI_OPTION_TYPE_SPIN,
+	  .data.spin = { .default_val = 50,
+	                 .min = 0,
+	                 .max = 100,
+	                 .setter = engine_set_selectivity } },
 	{ .name = "Skill Level",
 	  .type = UCI_OPTION_TYPE_SPIN,
 	  .data.spin = { .default_val = 20,
@@ -203,6 +324,9 @@ static const struct UciOption UCI_OPTIONS[] = {
 	{ .name = "UCI_LimitStrength",
 	  .type = UCI_OPTION_TYPE_CHECK,
 	  .data.check = { .default_val = false, .setter = engine_set_uci_limit_strength } },
+	{ .name = "Weights File",
+	  .type = UCI_OPTION_TYPE_STRING,
+	  .data.string = { .default_val = "<empty>", .setter = engine_set_weights_file } },
 };
 
 extern void
@@ -212,6 +336,7 @@ void
 engine_call_uci_eval(struct Engine *engine, struct PState *pstate)
 {
 	UNUSED(pstate);
+	engine_output_begin(engine);
 	fprintf(engine->config.output,
 	        "wmaterial %f\n",
 	        position_eval_color(&engine->board, COLOR_WHITE));
@@ -219,13 +344,16 @@ engine_call_uci_eval(struct Engine *engine, struct PState *pstate)
 	        "bmaterial %f\n",
 	        position_eval_color(&engine->board, COLOR_BLACK));
 	fprintf(engine->config.output, "totmaterial %f\n", position_eval(&engine->board));
+	engine_output_end(engine);
 }
 
 void
 engine_call_uci_go_perft(struct Engine *engine, const char *arg)
 {
 	if (arg) {
+		engine_output_begin(engine);
 		position_perft(engine->config.output, &engine->board, atoi(arg));
+		engine_output_end(engine);
 	} else {
 		display_err_syntax(engine->config.output);
 	}
@@ -235,8 +363,7 @@ void
 engine_call_uci_go_time(struct Engine *engine, const char *arg, enum Color color)
 {
 	if (arg) {
-		float time = (float)(atol(arg) * 1000);
-		engine->time_controls[color]->time_limit_in_seconds = time;
+		engine->game_clocks[color].time_left_in_seconds = (float)atol(arg) / 1000.0;
 	} else {
 		display_err_syntax(engine->config.output);
 	}
@@ -246,8 +373,7 @@ void
 engine_call_uci_go_inc(struct Engine *engine, const char *arg, enum Color color)
 {
 	if (arg) {
-		float time = (float)(atol(arg) * 1000);
-		engine->time_controls[color]->increment_in_seconds = time;
+		engine->time_controls[color]->increment_in_seconds = (float)atol(arg) / 1000.0;
 	} else {
 		display_err_syntax(engine->config.output);
 	}
@@ -257,29 +383,49 @@ void
 engine_call_uci_go_mate(struct Engine *engine, const char *token)
 {
 	if (token) {
-		engine->config.max_depth = atoi(token);
+		// Mate in N moves takes 2N-1 plies.
+		engine->config.max_depth = atoi(token) * 2 - 1;
 	} else {
 		display_err_syntax(engine->config.output);
 	}
 }
 
-void
-engine_call_uci_go_movetime(struct Engine *engine, const char *token)
+/* How long to think given the current clocks, in milliseconds. */
+static pint
+engine_time_limit_in_ms(struct Engine *engine)
 {
-	if (token) {
-		float time = (float)(atol(token) * 1000);
-		// engine->game_clocks[engine->board.side_to_move].time_left_in_seconds = time;
-	} else {
-		display_err_syntax(engine->config.output);
+	enum Color side = engine->board.side_to_move;
+	struct GameClock *clock = engine->game_clocks + side;
+	struct TimeControl *tc = engine->time_controls[side];
+	int moves_count = tc->max_moves_count > 0 ? tc->max_moves_count : 30;
+	float seconds =
+	  game_clock_estimate_thinking_time_in_seconds(clock, moves_count) + tc->increment_in_seconds;
+	// Pondering saves us some time on average, so we can spend more.
+	if (engine->config.ponder) {
+		seconds *= 1.25;
 	}
+	if (seconds > clock->time_left_in_seconds * 0.8) {
+		seconds = clock->time_left_in_seconds * 0.8;
+	}
+	return seconds > 0.001 ? (pint)(seconds * 1000) : 1;
 }
 
 void
 engine_call_uci_go(struct Engine *engine, struct PState *pstate)
 {
-	if (engine->status != STATUS_IDLE) {
+	if (p_atomic_int_get(&engine->status) != STATUS_IDLE) {
 		return;
 	}
+	// Limits never carry over from one search to the next.
+	engine->config.max_depth = 0;
+	engine->config.max_nodes_count = 0;
+	for (int color = 0; color < COLORS_COUNT; color++) {
+		engine->time_controls[color]->max_moves_count = 0;
+		engine->time_controls[color]->increment_in_seconds = 0;
+	}
+	bool is_ponder = false;
+	bool is_infinite = false;
+	pint movetime_in_ms = 0;
 	const char *token = NULL;
 	while ((token = pstate_next(pstate))) {
 		if (strcmp(token, "perft") == 0) {
@@ -294,27 +440,33 @@ engine_call_uci_go(struct Engine *engine, struct PState *pstate)
 		} else if (strcmp(token, "binc") == 0) {
 			engine_call_uci_go_inc(engine, pstate_next(pstate), COLOR_BLACK);
 		} else if (strcmp(token, "infinite") == 0) {
-			time_control_delete(engine->time_controls[COLOR_WHITE]);
-			time_control_delete(engine->time_controls[COLOR_BLACK]);
+			is_infinite = true;
 		} else if (strcmp(token, "ponder") == 0) {
-			engine->config.ponder = true;
-		} else if (strcmp(token, "movestogo") == 0) {
-			token = pstate_next(pstate);
+			is_ponder = true;
+		} else if (strcmp(token, "movestogo") == 0 && (token = pstate_next(pstate))) {
 			engine->time_controls[COLOR_WHITE]->max_moves_count = atoi(token);
 			engine->time_controls[COLOR_BLACK]->max_moves_count = atoi(token);
-		} else if (strcmp(token, "depth") == 0) {
-			token = pstate_next(pstate);
+		} else if (strcmp(token, "depth") == 0 && (token = pstate_next(pstate))) {
 			engine->config.max_depth = atoi(token);
 		} else if (strcmp(token, "mate") == 0) {
 			engine_call_uci_go_mate(engine, pstate_next(pstate));
-		} else if (strcmp(token, "nodes") == 0) {
-			engine_call_uci_go_mate(engine, pstate_next(pstate));
-		} else if (strcmp(token, "movetime") == 0) {
-			engine_call_uci_go_movetime(engine, pstate_next(pstate));
+		} else if (strcmp(token, "nodes") == 0 && (token = pstate_next(pstate))) {
+			engine->config.max_nodes_count = strtoull(token, NULL, 10);
+		} else if (strcmp(token, "movetime") == 0 && (token = pstate_next(pstate))) {
+			movetime_in_ms = atol(token);
 		} else {
 			ENGINE_LOGF(engine, "# Unrecognized 'go' option '%s'\n", token);
 		}
 	}
+	pint time_limit_in_ms = 0;
+	if (movetime_in_ms) {
+		time_limit_in_ms = movetime_in_ms;
+	} else if (!is_infinite && !engine->config.max_depth && !engine->config.max_nodes_count) {
+		time_limit_in_ms = engine_time_limit_in_ms(engine);
+	}
+	p_atomic_int_set(&engine->search_signals.time_limit_in_ms, time_limit_in_ms);
+	// Infinite searches behave just like endless pondering.
+	p_atomic_int_set(&engine->search_signals.ponder, is_ponder || is_infinite);
 	engine_start_search(engine);
 }
 
@@ -332,6 +484,7 @@ engine_call_uci_listmoves(struct Engine *engine, struct PState *pstate)
 		display_err_syntax(engine->config.output);
 		return;
 	}
+	engine_output_begin(engine);
 	fprintf(engine->config.output, "%zu", count);
 	for (size_t i = 0; i < count; i++) {
 		char buf[8] = { '\0' };
@@ -339,17 +492,34 @@ engine_call_uci_listmoves(struct Engine *engine, struct PState *pstate)
 		fprintf(engine->config.output, " %s", buf);
 	}
 	putc('\n', engine->config.output);
+	engine_output_end(engine);
+}
+
+static bool
+moves_eq_with_promotion(const struct Move *m1, const struct Move *m2)
+{
+	return moves_eq(m1, m2) && m1->promotion == m2->promotion;
+}
+
+static bool
+boards_eq(const struct Board *b1, const struct Board *b2)
+{
+	return b1->hash == b2->hash && b1->reversible_moves_count == b2->reversible_moves_count &&
+	       b1->moves_count == b2->moves_count;
 }
 
 void
 engine_call_uci_position(struct Engine *engine, struct PState *pstate)
 {
+	// Searches don't survive a change of position, not even pondering ones.
+	engine_stop_search(engine);
 	const char *token = pstate_next(pstate);
+	struct Board base;
 	if (!token) {
 		display_err_syntax(engine->config.output);
 		return;
 	} else if (strcmp(token, "startpos") == 0) {
-		engine->board = POSITION_INIT;
+		base = POSITION_INIT;
 	} else if (strcmp(token, "fen") == 0) {
 		const char *fen_fields[6] = { NULL };
 		for (size_t i = 0; i < 6; i++) {
@@ -364,24 +534,50 @@ engine_call_uci_position(struct Engine *engine, struct PState *pstate)
 			}
 			fen_fields[i] = token;
 		}
-		position_init_from_fen_fields(&engine->board, fen_fields);
+		if (position_init_from_fen_fields(&base, fen_fields) != ERR_CODE_NONE) {
+			display_err_syntax(engine->config.output);
+			return;
+		}
 	} else if (strcmp(token, "960") == 0) {
 		/* The "960" command is a custom addition the standard. I figured it could
 		 * be useful for training. */
-		position_init_960(&engine->board);
-	} else if (strcmp(token, "current") != 0) {
+		position_init_960(&base, &engine->prng_state);
+	} else if (strcmp(token, "current") == 0) {
+		base = engine->board;
+	} else {
 		display_err_syntax(engine->config.output);
+		return;
+	}
+	// The game is replayed from scratch only if it doesn't continue the
+	// previous one. "current" continues it by definition.
+	bool is_current = strcmp(token, "current") == 0;
+	size_t moves_count = 0;
+	if (!engine_game_is_consistent(engine) ||
+	    (!is_current && !boards_eq(&base, &engine->game_base))) {
+		engine_reset_game(engine, &base);
+	} else if (is_current) {
+		moves_count = engine->game_moves_count;
 	}
 	if (pstate_skip(pstate, "moves") == -1) {
 		display_err_syntax(engine->config.output);
 		return;
 	}
-	// Now feed moves into the position.
+	// Now feed moves into the position, skipping those that were already
+	// played. The new game might also diverge from the old one or be shorter,
+	// e.g. after a takeback.
 	while ((token = pstate_next(pstate))) {
 		struct Move mv;
 		string_to_move(token, &mv);
-		position_do_move_and_flip(&engine->board, &mv);
+		if (moves_count < engine->game_moves_count &&
+		    moves_eq_with_promotion(&mv, engine->game_moves + moves_count)) {
+			moves_count++;
+			continue;
+		}
+		engine_take_back_moves(engine, moves_count);
+		engine_play_move(engine, mv);
+		moves_count++;
 	}
+	engine_take_back_moves(engine, moves_count);
 }
 
 void
@@ -389,7 +585,9 @@ engine_call_uci_d(struct Engine *engine, struct PState *pstate)
 {
 	const char *token = pstate_next(pstate);
 	if (!token) {
+		engine_output_begin(engine);
 		position_pprint(&engine->board, engine->config.output);
+		engine_output_end(engine);
 	} else if (strcmp(token, "fen") == 0) {
 		char *fen = fen_from_position(NULL, &engine->board, ' ');
 		fprintf(engine->config.output, "%s\n", fen);
@@ -406,7 +604,7 @@ engine_call_uci_d(struct Engine *engine, struct PState *pstate)
 void
 engine_call_uci_setoption(struct Engine *engine, struct PState *pstate)
 {
-	if (engine->status != STATUS_IDLE) {
+	if (p_atomic_int_get(&engine->status) != STATUS_IDLE) {
 		display_err_unspecified(engine->config.output);
 		return;
 	}
@@ -471,18 +669,28 @@ engine_call_uci_isready(struct Engine *engine, struct PState *pstate)
 	fputs("readyok\n", engine->config.output);
 }
 
+void
+engine_call_uci_ponderhit(struct Engine *engine, struct PState *pstate)
+{
+	UNUSED(pstate);
+	if (p_atomic_int_get(&engine->status) == STATUS_SEARCH) {
+		engine_ponderhit(engine);
+	}
+}
+
 void
 engine_call_uci_quit(struct Engine *engine, struct PState *pstate)
 {
 	UNUSED(pstate);
-	engine->status = STATUS_EXIT;
+	engine_stop_search(engine);
+	p_atomic_int_set(&engine->status, STATUS_EXIT);
 }
 
 void
 engine_call_uci_stop(struct Engine *engine, struct PState *pstate)
 {
-	UNUSED(engine);
 	UNUSED(pstate);
+	engine_stop_search(engine);
 }
 
 void
@@ -490,6 +698,7 @@ engine_call_uci_uci(struct Engine *engine, struct PState *pstate)
 {
 	UNUSED(pstate);
 	engine->config.protocol = engine_call_uci;
+	engine_output_begin(engine);
 	fprintf(engine->config.output,
 	        "id name Zuloid %s\n"
 	        "id author Filippo Costa\n",
@@ -497,31 +706,103 @@ engine_call_uci_uci(struct Engine *engine, struct PState *pstate)
 	for (size_t i = 0; i < ARRAY_SIZE(UCI_OPTIONS); i++) {
 		ucioption_fprint(UCI_OPTIONS + i, engine->config.output);
 	}
-	init_threats();
 	fputs("uciok\n", engine->config.output);
+	engine_output_end(engine);
 }
 
+/* Usage: %magics bishop|rook [threads <n>] [attempts <n>]
+ *
+ * Searches new magics and prints them as C source, to replace those in
+ * src/chess/generated/. */
 void
 engine_call_uci_magics(struct Engine *engine, struct PState *pstate)
 {
 	const char *token = pstate_next(pstate);
 	const char *identifier = NULL;
-	void (*finder)(struct Magic *, Square);
-	if (!strcmp(token, "bishop")) {
+	void (*finder)(struct Magic *, size_t, size_t, uint64_t);
+	Bitboard (*slider)(Square, Bitboard);
+	if (token && !strcmp(token, "bishop")) {
 		identifier = "MAGICS_BISHOP";
-		finder = magic_find_bishop;
-	} else if (!strcmp(token, "rook")) {
+		finder = magics_find_bishop;
+		slider = threats_by_bishop_no_init;
+	} else if (token && !strcmp(token, "rook")) {
 		identifier = "MAGICS_ROOK";
-		finder = magic_find_rook;
+		finder = magics_find_rook;
+		slider = threats_by_rook_no_init;
 	} else {
 		display_err_syntax(engine->config.output);
 		return;
 	}
-	struct Magic magics[64];
-	for (Square sq = 0; sq < SQUARES_COUNT; sq++) {
-		finder(magics + sq, sq);
+	long threads_count = 1;
+	long attempts_count = 1 << 16;
+	while ((token = pstate_next(pstate))) {
+		const char *value = pstate_next(pstate);
+		long *dest = NULL;
+		if (!strcmp(token, "threads")) {
+			dest = &threads_count;
+		} else if (!strcmp(token, "attempts")) {
+			dest = &attempts_count;
+		}
+		if (!dest || !value || (*dest = atol(value)) < 1) {
+			display_err_syntax(engine->config.output);
+			return;
+		}
 	}
+	struct Magic magics[SQUARES_COUNT];
+	finder(magics, threads_count, attempts_count, prng_next(&engine->prng_state));
+	size_t offsets[SQUARES_COUNT];
+	size_t size = 0;
+	free(exit_if_null(magics_build_attacks(magics, slider, offsets, &size)));
+	engine_output_begin(engine);
+	fprintf(engine->config.output,
+	        "/* Attack tables: %zu entries, %zu KiB. */\n",
+	        size,
+	        size * sizeof(Bitboard) / 1024);
 	magics_export(magics, identifier, engine->config.output);
+	engine_output_end(engine);
+}
+
+/* Dumps the counters of the last search as a single line of JSON. */
+void
+engine_call_uci_stats(struct Engine *engine, struct PState *pstate)
+{
+	UNUSED(pstate);
+	// Stats are only collected once the search thread is joined.
+	if (p_atomic_int_get(&engine->status) == STATUS_IDLE) {
+		engine_stop_search(engine);
+	}
+	const struct SearchStats *stats = &engine->search_stats;
+	cJSON *json = cJSON_CreateObject();
+	cJSON_AddBoolToObject(json, "enabled", ZULOID_ENABLE_SEARCH_DEBUGGING);
+	cJSON_AddNumberToObject(json, "interior_nodes", stats->interior_nodes_count);
+	cJSON_AddNumberToObject(json, "leaves", stats->leaves_count);
+	cJSON_AddNumberToObject(json, "terminal_nodes", stats->terminal_nodes_count);
+	cJSON_AddNumberToObject(json, "draws", stats->draws_count);
+	cJSON_AddNumberToObject(json, "eval_cache_hits", stats->eval_cache_hits_count);
+	cJSON_AddNumberToObject(json, "qnodes", stats->qnodes_count);
+	cJSON_AddNumberToObject(json, "beta_cutoffs", stats->beta_cutoffs_count);
+	cJSON_AddNumberToObject(json, "first_move_cutoffs", stats->first_move_cutoffs_count);
+	cJSON_AddNumberToObject(json, "pruned_nodes", stats->pruned_nodes_count);
+	cJSON_AddNumberToObject(json, "pruned_moves", stats->pruned_moves_count);
+	cJSON_AddNumberToObject(json, "null_moves", stats->null_moves_count);
+	cJSON_AddNumberToObject(json, "null_move_cutoffs", stats->null_move_cutoffs_count);
+	cJSON_AddNumberToObject(json, "reductions", stats->reductions_count);
+	cJSON_AddNumberToObject(
+	  json, "reduction_researches", stats->reduction_researches_count);
+	cJSON_AddNumberToObject(json, "researches", stats->researches_count);
+	cJSON *iterations = cJSON_AddArrayToObject(json, "iterations");
+	for (size_t i = 0; i < stats->iterations_count; i++) {
+		cJSON *iteration = cJSON_CreateObject();
+		cJSON_AddNumberToObject(iteration, "depth", i + 1);
+		cJSON_AddNumberToObject(iteration, "nodes", stats->nodes_count_by_iteration[i]);
+		cJSON_AddNumberToObject(
+		  iteration, "branching_factor", search_stats_branching_factor(stats, i));
+		cJSON_AddItemToArray(iterations, iteration);
+	}
+	char *str = cJSON_PrintUnformatted(json);
+	fprintf(engine->config.output, "%s\n", str);
+	cJSON_free(str);
+	cJSON_Delete(json);
 }
 
 void
@@ -552,10 +833,12 @@ const struct PCommand UCI_COMMANDS[] = {
 	{ "%eval", engine_call_uci_eval },
 	{ "%listmoves", engine_call_uci_listmoves },
 	{ "%magics", engine_call_uci_magics },
+	{ "%stats", engine_call_uci_stats },
 	{ "d", engine_call_uci_d },
 	{ "debug", engine_call_uci_debug },
 	{ "go", engine_call_uci_go },
 	{ "isready", engine_call_uci_isready },
+	{ "ponderhit", engine_call_uci_ponderhit },
 	{ "position", engine_call_uci_position },
 	{ "quit", engine_call_uci_quit },
 	{ "setoption", engine_call_uci_setoption },
@@ -566,9 +849,11 @@ const struct PCommand UCI_COMMANDS[] = {
 };
 
 void
-engine_call_uci(struct Engine *engine, const char *str)
+engine_call_uci(struct Engine *engine, char *str)
 {
-	struct PState *pstate = pstate_new(str, UCI_COMMANDS, ARRAY_SIZE(UCI_COMMANDS));
+	struct PState state;
+	struct PState *pstate = &state;
+	pstate_init(pstate, str, UCI_COMMANDS, ARRAY_SIZE(UCI_COMMANDS));
 	if (!pstate->token) {
 		;
 	} else if (pstate->cmd) {
@@ -577,5 +862,6 @@ engine_call_uci(struct Engine *engine, const char *str)
 	} else {
 		display_err_invalid_command(engine->config.output);
 	}
-	pstate_free(pstate);
+	// The whole response goes out at once.
+	fflush(engine->config.output);
 }
@@ -75,8 +75,17 @@ strtrim(char *str, const char *trimmable)
 	str += strspn(str, trimmable);
 	// Start from the end and set every byte to the null terminator until a
 	// "good" (i.e. non-`trimmmable`) character is found.
-	for (char *ptr = str + strlen(str); strchr(trimmable, *ptr); ptr--) {
-		*ptr = '\0';
+	for (char *ptr = str + strlen(str); ptr > str && strchr(trimmable, ptr[-1]); ptr--) {
+		ptr[-1] = '\0';
 	}
 	return str;
 }
+
+uint64_t
+prng_next(uint64_t *state)
+{
+	uint64_t z = (*state += 0x9e3779b97f4a7c15);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+	return z ^ (z >> 31);
+}
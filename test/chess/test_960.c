@@ -2,6 +2,8 @@
 #include "chess/movegen.h"
 #include "chess/position.h"
 #include "munit/munit.h"
+#include "utils.h"
+#include <string.h>
 
 enum
 {
@@ -11,9 +13,10 @@ enum
 void
 test_960(void)
 {
+	uint64_t prng_state = 0;
 	for (size_t i = 0; i < NUMBER_OF_TESTS; i++) {
 		struct Board position = POSITION_INIT;
-		position_init_960(&position);
+		position_init_960(&position, &prng_state);
 		Bitboard rooks = position.bb[PIECE_TYPE_ROOK];
 		Bitboard kings = position.bb[PIECE_TYPE_KING];
 		Bitboard bishops_on_white_squares =
@@ -27,5 +30,22 @@ test_960(void)
 		munit_assert_uint64(bishops_on_black_squares, !=, 0);
 		munit_assert_uint64(bishops_on_white_squares, !=, 0);
 		munit_assert_uint64(occupancy, ==, expected_occupancy);
+		// No 960 castling yet: the rights only stay in the standard setup.
+		if (memcmp(position.bb, POSITION_INIT.bb, sizeof(position.bb)) != 0) {
+			munit_assert_int(position.castling_rights, ==, CASTLING_RIGHT_NONE);
+		}
+		munit_assert_uint64(position.hash, ==, position_zobrist(&position));
+	}
+}
+
+void
+test_960_is_deterministic(void)
+{
+	uint64_t prng_states[2] = { 42, 42 };
+	for (size_t i = 0; i < NUMBER_OF_TESTS; i++) {
+		struct Board positions[2];
+		position_init_960(positions + 0, prng_states + 0);
+		position_init_960(positions + 1, prng_states + 1);
+		munit_assert_memory_equal(sizeof(positions[0].bb), positions[0].bb, positions[1].bb);
 	}
 }
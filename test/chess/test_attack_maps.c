@@ -0,0 +1,95 @@
+#include "chess/attack_maps.h"
+#include "chess/fen.h"
+#include "chess/movegen.h"
+#include "chess/position.h"
+#include "chess/threats.h"
+#include "libpopcnt/libpopcnt.h"
+#include "munit/munit.h"
+#include "utils.h"
+
+enum
+{
+	NUMBER_OF_PLAYOUTS = 20,
+	PLAYOUT_LENGTH = 100,
+};
+
+static Bitboard
+pawn_attacks(Square sq, enum Color color)
+{
+	Bitboard bb = square_to_bb(sq);
+	return color == COLOR_WHITE ? ((bb & ~0x8080808080808080ULL) << 9) |
+	                                ((bb & ~0x8080808080808080ULL) >> 7)
+	                            : ((bb & ~0x0101010101010101ULL) << 7) |
+	                                ((bb & ~0x0101010101010101ULL) >> 9);
+}
+
+/* Compares attack maps against table lookups, one piece at a time. */
+static void
+check_attack_maps(const struct Board *pos)
+{
+	struct AttackMaps maps[COLORS_COUNT];
+	position_attack_maps(pos, maps);
+	Bitboard occupancy = pos->bb[COLOR_WHITE] | pos->bb[COLOR_BLACK];
+	for (enum Color color = COLOR_WHITE; color <= COLOR_BLACK; color++) {
+		Bitboard all = 0;
+		Bitboard double_attacks = 0;
+		size_t knight_moves_count = 0;
+		size_t slider_moves_count = 0;
+		for (Square sq = 0; sq < SQUARES_COUNT; sq++) {
+			if (!(pos->bb[color] & square_to_bb(sq))) {
+				continue;
+			}
+			Bitboard attacks[3] = { 0 };
+			if (pos->bb[PIECE_TYPE_PAWN] & square_to_bb(sq)) {
+				attacks[0] = pawn_attacks(sq, color);
+			} else if (pos->bb[PIECE_TYPE_KNIGHT] & square_to_bb(sq)) {
+				attacks[0] = threats_by_knight(sq);
+				knight_moves_count += popcnt64(attacks[0]);
+			} else if (pos->bb[PIECE_TYPE_KING] & square_to_bb(sq)) {
+				attacks[0] = threats_by_king(sq);
+				munit_assert_uint64(attacks[0], ==, maps[color].king);
+			}
+			if (pos->bb[PIECE_TYPE_BISHOP] & square_to_bb(sq)) {
+				attacks[1] = threats_by_bishop(sq, occupancy);
+			}
+			if (pos->bb[PIECE_TYPE_ROOK] & square_to_bb(sq)) {
+				attacks[2] = threats_by_rook(sq, occupancy);
+			}
+			slider_moves_count += popcnt64(attacks[1]) + popcnt64(attacks[2]);
+			// A queen attacks each square just once.
+			Bitboard piece_attacks = attacks[0] | attacks[1] | attacks[2];
+			double_attacks |= all & piece_attacks;
+			all |= piece_attacks;
+		}
+		size_t knights_count = 0;
+		size_t sliders_count = 0;
+		for (size_t i = 0; i < LANES_COUNT; i++) {
+			knights_count += popcnt64(maps[color].knights[i]);
+			sliders_count += popcnt64(maps[color].sliders[i]);
+		}
+		munit_assert_uint64(maps[color].all, ==, all);
+		munit_assert_uint64(maps[color].double_attacks, ==, double_attacks);
+		munit_assert_size(knights_count, ==, knight_moves_count);
+		munit_assert_size(sliders_count, ==, slider_moves_count);
+	}
+}
+
+void
+test_attack_maps(void)
+{
+	uint64_t prng_state = 0;
+	for (size_t i = 0; i < NUMBER_OF_PLAYOUTS; i++) {
+		struct Board board;
+		position_init_from_fen(
+		  &board, "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1");
+		for (size_t j = 0; j < PLAYOUT_LENGTH; j++) {
+			check_attack_maps(&board);
+			struct Move moves[MAX_MOVES];
+			size_t moves_count = gen_legal_moves(moves, &board);
+			if (moves_count == 0) {
+				break;
+			}
+			position_do_move_and_flip(&board, moves + prng_next(&prng_state) % moves_count);
+		}
+	}
+}
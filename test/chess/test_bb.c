@@ -11,7 +11,6 @@ void
 test_magic_generation(void)
 {
 	srand(time(NULL));
-	init_threats();
 	for (size_t i = 0; i < 5000; i++) {
 		Square from = rand() % 64;
 		Bitboard mask = genrand64_int64() & genrand64_int64();
@@ -33,3 +32,24 @@ test_bb_subset(void)
 	}
 	munit_assert_uint(i + 1, ==, 1ULL << popcount64(mask));
 }
+
+void
+test_magics_find(void)
+{
+	struct Magic magics[SQUARES_COUNT];
+	magics_find_bishop(magics, 2, 64, 42);
+	size_t offsets[SQUARES_COUNT];
+	size_t size;
+	Bitboard *attacks =
+	  magics_build_attacks(magics, threats_by_bishop_no_init, offsets, &size);
+	munit_assert_not_null(attacks);
+	for (Square sq = 0; sq < SQUARES_COUNT; sq++) {
+		Bitboard subset = 0;
+		do {
+			size_t i = offsets[sq] + magic_index(magics + sq, subset);
+			munit_assert_size(i, <, size);
+			munit_assert_uint64(attacks[i], ==, threats_by_bishop_no_init(sq, subset));
+		} while ((subset = bb_next_subset(magics[sq].premask, subset)));
+	}
+	free(attacks);
+}
@@ -0,0 +1,62 @@
+#include "chess/board_batch.h"
+#include "chess/fen.h"
+#include "chess/movegen.h"
+#include "chess/position.h"
+#include "munit/munit.h"
+#include "utils.h"
+
+enum
+{
+	NUMBER_OF_PLAYOUTS = 50,
+	PLAYOUT_LENGTH = 120,
+};
+
+static const char *const FENS[] = {
+	"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+	// "Kiwipete", full of pins, castling and en passant.
+	"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+	"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+	"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+	"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+};
+
+static void
+board_batch_check(const struct BoardBatch *batch, struct Board boards[BOARD_BATCH_SIZE])
+{
+	struct BoardBatchResults results;
+	board_batch_analyze(batch, &results);
+	for (size_t i = 0; i < batch->count; i++) {
+		struct Move moves[MAX_MOVES];
+		size_t expected = gen_legal_moves(moves, boards + i);
+		munit_assert_size(results.legal_moves_count[i], ==, expected);
+		munit_assert(position_is_check(boards + i) == (results.checkers[i] != 0));
+	}
+}
+
+void
+test_board_batch(void)
+{
+	uint64_t prng_state = 0;
+	struct BoardBatch batch;
+	struct Board boards[BOARD_BATCH_SIZE];
+	board_batch_clear(&batch);
+	for (size_t i = 0; i < NUMBER_OF_PLAYOUTS; i++) {
+		struct Board board;
+		position_init_from_fen(&board, FENS[i % ARRAY_SIZE(FENS)]);
+		for (size_t j = 0; j < PLAYOUT_LENGTH; j++) {
+			if (board_batch_is_full(&batch)) {
+				board_batch_check(&batch, boards);
+				board_batch_clear(&batch);
+			}
+			boards[batch.count] = board;
+			munit_assert(board_batch_push(&batch, &board));
+			struct Move moves[MAX_MOVES];
+			size_t moves_count = gen_legal_moves(moves, &board);
+			if (moves_count == 0) {
+				break;
+			}
+			position_do_move_and_flip(&board, moves + prng_next(&prng_state) % moves_count);
+		}
+	}
+	board_batch_check(&batch, boards);
+}
@@ -0,0 +1,127 @@
+#include "chess/book.h"
+#include "chess/move.h"
+#include "chess/position.h"
+#include "munit/munit.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BOOK_FILENAME TEST_TMP_DIR "/book.bin"
+
+struct TestBookEntry
+{
+	uint64_t key;
+	uint16_t move;
+	uint16_t weight;
+};
+
+static void
+play(struct Board *pos, const char *str)
+{
+	struct Move mv;
+	string_to_move(str, &mv);
+	position_play_move(pos, &mv);
+}
+
+static int
+test_book_entry_cmp(const void *e1, const void *e2)
+{
+	uint64_t key1 = ((const struct TestBookEntry *)e1)->key;
+	uint64_t key2 = ((const struct TestBookEntry *)e2)->key;
+	return (key1 > key2) - (key1 < key2);
+}
+
+static void
+write_big_endian(FILE *file, uint64_t value, size_t count)
+{
+	while (count-- > 0) {
+		fputc((value >> (count * 8)) & 0xff, file);
+	}
+}
+
+static void
+test_polyglot_keys(void)
+{
+	// From docs/polyglot.html.
+	const char *moves[] = { "e2e4", "d7d5", "e4e5", "f7f5", "e1e2", "e8f7" };
+	const uint64_t keys[] = {
+		0x463b96181691fc9c, 0x823c9b50fd114196, 0x0756b94461c50fb0, 0x662fafb965db29d4,
+		0x22a48b5a8e47ff78, 0x652a607ca3f242c1, 0x00fdd303c946bdd9,
+	};
+	struct Board pos = POSITION_INIT;
+	munit_assert_uint64(position_polyglot_key(&pos), ==, keys[0]);
+	for (size_t i = 0; i < 6; i++) {
+		play(&pos, moves[i]);
+		munit_assert_uint64(position_polyglot_key(&pos), ==, keys[i + 1]);
+	}
+	pos = POSITION_INIT;
+	const char *other_moves[] = { "a2a4", "b7b5", "h2h4", "b5b4", "c2c4" };
+	for (size_t i = 0; i < 5; i++) {
+		play(&pos, other_moves[i]);
+	}
+	munit_assert_uint64(position_polyglot_key(&pos), ==, 0x3c8123ea7b067637);
+	play(&pos, "b4c3");
+	play(&pos, "a1a3");
+	munit_assert_uint64(position_polyglot_key(&pos), ==, 0x5c3f9b829b279560);
+}
+
+void
+test_book(void)
+{
+	test_polyglot_keys();
+	struct Board start = POSITION_INIT;
+	struct Board castling = POSITION_INIT;
+	const char *moves[] = { "e2e4", "e7e5", "g1f3", "b8c6", "f1c4", "f8c5" };
+	for (size_t i = 0; i < 6; i++) {
+		play(&castling, moves[i]);
+	}
+	struct TestBookEntry entries[] = {
+		// 1. e4 and 1. d4.
+		{ position_polyglot_key(&start), 0x31c, 10 },
+		{ position_polyglot_key(&start), 0x2db, 5 },
+		// 1. e5 is illegal, so it's never played.
+		{ position_polyglot_key(&start), 0x324, 100 },
+		// White castles king side, encoded as e1h1.
+		{ position_polyglot_key(&castling), 0x107, 0 },
+		{ 0, 0x31c, 1 },
+		{ UINT64_MAX, 0x31c, 1 },
+	};
+	size_t entries_count = sizeof(entries) / sizeof(entries[0]);
+	qsort(entries, entries_count, sizeof(struct TestBookEntry), test_book_entry_cmp);
+	FILE *file = fopen(BOOK_FILENAME, "wb");
+	munit_assert_not_null(file);
+	for (size_t i = 0; i < entries_count; i++) {
+		write_big_endian(file, entries[i].key, 8);
+		write_big_endian(file, entries[i].move, 2);
+		write_big_endian(file, entries[i].weight, 2);
+		write_big_endian(file, 0, 4);
+	}
+	fclose(file);
+	struct Book *book = book_open(BOOK_FILENAME);
+	munit_assert_not_null(book);
+	char buf[MOVE_STRING_MAX_LENGTH] = { '\0' };
+	struct Move mv;
+	munit_assert_true(book_probe(book, &start, true, 0, &mv));
+	move_to_string(mv, buf);
+	munit_assert_string_equal(buf, "e2e4");
+	// Moves are picked proportionally to their weights.
+	size_t e4_count = 0;
+	for (uint64_t random = 0; random < 15; random++) {
+		munit_assert_true(book_probe(book, &start, false, random, &mv));
+		move_to_string(mv, buf);
+		e4_count += strcmp(buf, "e2e4") == 0;
+	}
+	munit_assert_uint(e4_count, ==, 10);
+	munit_assert_true(book_probe(book, &castling, false, 42, &mv));
+	munit_assert_true(mv.castling);
+	move_to_string(mv, buf);
+	munit_assert_string_equal(buf, "e1g1");
+	play(&start, "e2e4");
+	munit_assert_false(book_probe(book, &start, false, 0, &mv));
+	book_close(book);
+	// Truncated files are rejected.
+	file = fopen(BOOK_FILENAME, "ab");
+	fputc(0, file);
+	fclose(file);
+	munit_assert_null(book_open(BOOK_FILENAME));
+}
@@ -0,0 +1,88 @@
+#include "chess/fen.h"
+#include "chess/move.h"
+#include "chess/movegen.h"
+#include "chess/position.h"
+#include "munit/munit.h"
+#include <string.h>
+
+#define KIWIPETE "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1"
+
+static void
+assert_mailbox_matches_bitboards(const struct Board *pos)
+{
+	struct Board rebuilt;
+	position_empty(&rebuilt);
+	for (Square square = 0; square <= SQUARE_MAX; square++) {
+		position_set_piece_at_square(&rebuilt, square, position_piece_at_square(pos, square));
+	}
+	munit_assert_memory_equal(sizeof(pos->bb), pos->bb, rebuilt.bb);
+}
+
+void
+test_do_move(void)
+{
+	struct Board pos;
+	position_init_from_fen(&pos, KIWIPETE);
+	struct Move moves[MAX_MOVES];
+	size_t moves_count = gen_pseudolegal_moves(moves, &pos);
+	munit_assert_size(moves_count, >, 0);
+	for (size_t i = 0; i < moves_count; i++) {
+		struct Board original = pos;
+		position_do_move_and_flip(&pos, moves + i);
+		assert_mailbox_matches_bitboards(&pos);
+		munit_assert_uint64(pos.hash, ==, position_zobrist(&pos));
+		position_undo_move_and_flip(&pos, moves + i);
+		munit_assert_memory_equal(sizeof(struct Board), &pos, &original);
+	}
+	// The rook follows the king when castling, and castling rights are gone.
+	struct Move castling;
+	string_to_move("e1g1", &castling);
+	position_do_move_and_flip(&pos, &castling);
+	munit_assert_int(pos.castling_rights,
+	                 ==,
+	                 CASTLING_RIGHT(CASTLING_RIGHT_KINGSIDE | CASTLING_RIGHT_QUEENSIDE,
+	                                COLOR_BLACK));
+	munit_assert_int(position_piece_at_square(&pos, square_from_str("f1")).type,
+	                 ==,
+	                 PIECE_TYPE_ROOK);
+	munit_assert_int(
+	  position_piece_at_square(&pos, square_from_str("h1")).type, ==, PIECE_TYPE_NONE);
+	// Promotions and en passant captures.
+	position_init_from_fen(&pos, "4k3/1P6/8/3pP3/8/8/8/4K3 w - d6 0 1");
+	struct Board original = pos;
+	struct Move mv;
+	string_to_move("e5d6", &mv);
+	position_do_move_and_flip(&pos, &mv);
+	munit_assert_true(mv.en_passant);
+	munit_assert_int(
+	  position_piece_at_square(&pos, square_from_str("d5")).type, ==, PIECE_TYPE_NONE);
+	position_undo_move_and_flip(&pos, &mv);
+	munit_assert_memory_equal(sizeof(pos.squares), pos.squares, original.squares);
+	string_to_move("b7b8n", &mv);
+	position_do_move_and_flip(&pos, &mv);
+	munit_assert_int(
+	  position_piece_at_square(&pos, square_from_str("b8")).type, ==, PIECE_TYPE_KNIGHT);
+	assert_mailbox_matches_bitboards(&pos);
+	position_undo_move_and_flip(&pos, &mv);
+	munit_assert_memory_equal(sizeof(struct Board), &pos, &original);
+	// Hashes match Polyglot's, as long as there's no en passant target.
+	pos = POSITION_INIT;
+	munit_assert_uint64(pos.hash, ==, position_zobrist(&pos));
+	const char *line[] = { "e2e4", "d7d5", "e4e5" };
+	for (size_t i = 0; i < 3; i++) {
+		string_to_move(line[i], &mv);
+		position_play_move(&pos, &mv);
+	}
+	munit_assert_uint64(pos.hash, ==, 0x662fafb965db29d4ULL);
+	// Null moves only pass the turn, and they forfeit en passant captures.
+	string_to_move("f7f5", &mv);
+	position_play_move(&pos, &mv);
+	original = pos;
+	struct Move null_move;
+	position_do_null_move(&pos, &null_move);
+	munit_assert_int(pos.side_to_move, ==, COLOR_BLACK);
+	munit_assert_int(pos.en_passant_target, ==, SQUARE_NONE);
+	munit_assert_uint64(pos.hash, ==, position_zobrist(&pos));
+	position_undo_null_move(&pos, &null_move);
+	munit_assert_memory_equal(sizeof(struct Board), &pos, &original);
+}
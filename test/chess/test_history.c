@@ -0,0 +1,41 @@
+#include "chess/history.h"
+#include "chess/move.h"
+#include "chess/position.h"
+#include "munit/munit.h"
+
+static void
+history_play(struct History *history, struct Board *pos, const char *str)
+{
+	struct Move mv;
+	string_to_move(str, &mv);
+	position_play_move(pos, &mv);
+	history_push(history, pos->hash);
+}
+
+void
+test_history(void)
+{
+	struct Board pos = POSITION_INIT;
+	struct History history;
+	history_init(&history);
+	history_reset(&history, &pos);
+	const char *knight_moves[] = { "g1f3", "g8f6", "f3g1", "f6g8" };
+	for (size_t i = 0; i < 4; i++) {
+		munit_assert_false(history_is_repetition(&history, pos.reversible_moves_count));
+		history_play(&history, &pos, knight_moves[i]);
+	}
+	munit_assert_true(history_is_repetition(&history, pos.reversible_moves_count));
+	// Captures and pawn moves make older positions unreachable.
+	munit_assert_false(history_is_repetition(&history, 3));
+	history_play(&history, &pos, "e2e4");
+	history_play(&history, &pos, "g8f6");
+	const char *white_first[] = { "g1f3", "f6g8", "f3g1", "g8f6" };
+	for (size_t i = 0; i < 4; i++) {
+		history_play(&history, &pos, white_first[i]);
+	}
+	munit_assert_true(history_is_repetition(&history, pos.reversible_moves_count));
+	munit_assert_uint(pos.reversible_moves_count, ==, 5);
+	history_pop(&history);
+	munit_assert_false(history_is_repetition(&history, pos.reversible_moves_count));
+	history_delete(&history);
+}
@@ -0,0 +1,48 @@
+#include "chess/fen.h"
+#include "chess/packed.h"
+#include "chess/position.h"
+#include "munit/munit.h"
+#include "utils.h"
+#include <stdio.h>
+#include <string.h>
+
+#define PACKED_FILENAME TEST_TMP_DIR "/positions.bin"
+
+extern const char *const VALID_FEN[];
+
+void
+test_packed(void)
+{
+	munit_assert_uint(sizeof(struct PackedPosition), ==, PACKED_POSITION_SIZE);
+	struct PackedWriter *writer = packed_writer_open(PACKED_FILENAME);
+	munit_assert_not_null(writer);
+	size_t count = 0;
+	for (; *VALID_FEN[count]; count++) {
+		struct Board position;
+		struct PackedPosition packed;
+		position_init_from_fen(&position, VALID_FEN[count]);
+		packed_from_position(&packed, &position);
+		packed.score = count;
+		munit_assert_int(packed_writer_push(writer, &packed), ==, ERR_CODE_NONE);
+	}
+	munit_assert_int(packed_writer_close(writer), ==, ERR_CODE_NONE);
+	struct PackedReader *reader = packed_reader_open(PACKED_FILENAME);
+	munit_assert_not_null(reader);
+	munit_assert_uint(packed_reader_count(reader), ==, count);
+	// Random access, in reverse order.
+	for (size_t i = count; i-- > 0;) {
+		const struct PackedPosition *packed = packed_reader_get(reader, i);
+		struct Board position;
+		char fen[FEN_SIZE];
+		munit_assert_int(packed->score, ==, (int)i);
+		munit_assert_int(packed->result, ==, PACKED_RESULT_UNKNOWN);
+		position_init_from_packed(&position, packed);
+		munit_assert_string_equal(fen_from_position(fen, &position, ' '), VALID_FEN[i]);
+	}
+	packed_reader_close(reader);
+	// Truncated files are rejected.
+	FILE *file = fopen(PACKED_FILENAME, "ab");
+	fputc(0, file);
+	fclose(file);
+	munit_assert_null(packed_reader_open(PACKED_FILENAME));
+}
@@ -0,0 +1,77 @@
+#include "chess/pgn.h"
+#include "chess/position.h"
+#include "munit/munit.h"
+#include "utils.h"
+#include <string.h>
+
+struct PgnCounts
+{
+	size_t moves_count;
+	size_t games_count;
+	size_t invalid_games_count;
+	enum PgnResult last_result;
+	struct Board last_position;
+};
+
+static void
+count_move(void *data, const struct Board *pos, const struct Move *mv)
+{
+	UNUSED(pos);
+	UNUSED(mv);
+	struct PgnCounts *counts = data;
+	counts->moves_count++;
+}
+
+static int
+count_game(void *data, const struct PgnParser *parser)
+{
+	struct PgnCounts *counts = data;
+	counts->games_count++;
+	counts->invalid_games_count += !parser->is_valid;
+	counts->last_result = parser->result;
+	counts->last_position = parser->board;
+	return ERR_CODE_NONE;
+}
+
+void
+test_pgn(void)
+{
+	const char *lines[] = {
+		"[Event \"Test\"]",
+		"[Result \"1-0\"]",
+		"",
+		"1. e4 {A comment",
+		"spanning lines} e5 2.Nf3 (2. f4 exf4) Nc6 $1 3. Bb5 ; The Spanish",
+		"a6 1-0",
+		"[FEN \"4k3/8/8/8/8/8/8/4K3 w - - 0 1\"]",
+		"1. Kd2 Kd8 2. Kxd8 Kc8 *",
+		"1. d4 d5 2. c4",
+	};
+	struct PgnCounts counts = { 0 };
+	struct PgnParser parser;
+	pgn_parser_init(&parser, count_move, count_game, &counts);
+	for (size_t i = 0; i < sizeof(lines) / sizeof(lines[0]); i++) {
+		char *line = strdup(lines[i]);
+		munit_assert_int(pgn_parser_feed(&parser, line), ==, ERR_CODE_NONE);
+		munit_assert_string_equal(line, lines[i]);
+		free(line);
+		if (i == 5) {
+			munit_assert_uint(counts.games_count, ==, 1);
+			munit_assert_uint(counts.moves_count, ==, 6);
+			munit_assert_int(counts.last_result, ==, PGN_RESULT_WHITE_WINS);
+			munit_assert_int(counts.last_position.side_to_move, ==, COLOR_WHITE);
+		} else if (i == 7) {
+			// The illegal "Kxd8" invalidates the second game.
+			munit_assert_uint(counts.games_count, ==, 2);
+			munit_assert_uint(counts.invalid_games_count, ==, 1);
+			munit_assert_uint(counts.moves_count, ==, 8);
+			munit_assert_int(counts.last_result, ==, PGN_RESULT_UNKNOWN);
+		}
+	}
+	munit_assert_uint(counts.games_count, ==, 2);
+	// The last game has no termination marker.
+	munit_assert_int(pgn_parser_finish(&parser), ==, ERR_CODE_NONE);
+	munit_assert_uint(counts.games_count, ==, 3);
+	munit_assert_uint(counts.moves_count, ==, 11);
+	munit_assert_int(counts.last_result, ==, PGN_RESULT_UNKNOWN);
+}
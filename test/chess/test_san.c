@@ -0,0 +1,38 @@
+#include "chess/fen.h"
+#include "chess/move.h"
+#include "chess/position.h"
+#include "chess/san.h"
+#include "munit/munit.h"
+#include <string.h>
+
+void
+test_san(void)
+{
+	struct Board position;
+	struct Move mv;
+	char buf[MOVE_STRING_MAX_LENGTH] = { '\0' };
+	position_init_from_fen(&position, "4k3/8/8/8/8/8/4P3/4K3 w - - 0 1");
+	munit_assert_uint(string_to_move_san("e4", &position, &mv), ==, 2);
+	move_to_string(mv, buf);
+	munit_assert_string_equal(buf, "e2e4");
+	// Illegal and malformed.
+	munit_assert_uint(string_to_move_san("e5", &position, &mv), ==, 0);
+	munit_assert_uint(string_to_move_san("Nf3", &position, &mv), ==, 0);
+	munit_assert_uint(string_to_move_san("xyz", &position, &mv), ==, 0);
+	position_init_from_fen(&position, "4k3/8/8/8/8/R7/5K2/R6R w - - 0 1");
+	// Ambiguous.
+	munit_assert_uint(string_to_move_san("Rd1", &position, &mv), ==, 0);
+	munit_assert_uint(string_to_move_san("Rhd1+!?", &position, &mv), ==, 7);
+	munit_assert_int(mv.source, ==, square_from_str("h1"));
+	munit_assert_uint(string_to_move_san("R1a2", &position, &mv), ==, 4);
+	munit_assert_int(mv.source, ==, square_from_str("a1"));
+	munit_assert_uint(string_to_move_san("Ra1b1", &position, &mv), ==, 5);
+	position_init_from_fen(&position, "8/3P3k/8/8/8/8/8/K7 w - - 0 1");
+	munit_assert_uint(string_to_move_san("d8=N", &position, &mv), ==, 4);
+	munit_assert_int(mv.promotion, ==, PIECE_TYPE_KNIGHT);
+	position_init_from_fen(&position, "r3k2r/8/8/8/8/8/8/R3K2R b KQkq - 0 1");
+	munit_assert_uint(string_to_move_san("O-O-O", &position, &mv), ==, 5);
+	move_to_string(mv, buf);
+	munit_assert_string_equal(buf, "e8c8");
+	munit_assert_int(mv.target, ==, square_from_str("c8"));
+}
@@ -0,0 +1,25 @@
+#include "chess/bb.h"
+#include "chess/threats.h"
+#include "munit/munit.h"
+
+/* The generated tables must agree with the slow way for every square and every
+ * set of obstacles along its rays. */
+void
+test_threats(void)
+{
+	for (Square sq = 0; sq < SQUARES_COUNT; sq++) {
+		munit_assert_uint64(threats_by_king(sq), ==, threats_by_king_no_init(sq));
+		munit_assert_uint64(threats_by_knight(sq), ==, threats_by_knight_no_init(sq));
+		Bitboard rays = threats_by_rook_no_init(sq, 0);
+		Bitboard subset = 0;
+		do {
+			munit_assert_uint64(
+			  threats_by_rook(sq, subset), ==, threats_by_rook_no_init(sq, subset));
+		} while ((subset = bb_next_subset(rays, subset)));
+		rays = threats_by_bishop_no_init(sq, 0);
+		do {
+			munit_assert_uint64(
+			  threats_by_bishop(sq, subset), ==, threats_by_bishop_no_init(sq, subset));
+		} while ((subset = bb_next_subset(rays, subset)));
+	}
+}
@@ -0,0 +1,26 @@
+#include "chess/fen.h"
+#include "chess/position.h"
+#include "core/eval.h"
+#include "core/generated/eval_params.h"
+#include "munit/munit.h"
+#include <math.h>
+#include <string.h>
+
+void
+test_eval_gradient(void)
+{
+	struct Board position;
+	position_init_from_fen(&position, "r3qbk1/pbp3pp/8/2p5/1rNnPP2/1PQPB3/2P3PP/R4R1K b - - 1 16");
+	struct EvalParams gradient;
+	memset(&gradient, 0, sizeof(gradient));
+	float eval = position_eval_with_params(&position, &EVAL_PARAMS, &gradient, 1.0);
+	munit_assert_double_equal(eval, position_eval(&position), 4);
+	// The evaluation is linear in each single parameter, so finite differences
+	// must match the gradient exactly (modulo rounding).
+	for (size_t i = 0; i < EVAL_PARAMS_COUNT; i++) {
+		struct EvalParams params = EVAL_PARAMS;
+		((float *)&params)[i] += 1.0;
+		float delta = position_eval_with_params(&position, &params, NULL, 0.0) - eval;
+		munit_assert_double_equal(delta, ((float *)&gradient)[i], 2);
+	}
+}
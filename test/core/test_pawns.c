@@ -0,0 +1,88 @@
+#include "chess/fen.h"
+#include "chess/mnemonics.h"
+#include "chess/movegen.h"
+#include "chess/position.h"
+#include "core/eval.h"
+#include "core/pawns.h"
+#include "munit/munit.h"
+#include "utils.h"
+
+enum
+{
+	NUMBER_OF_PLAYOUTS = 20,
+	PLAYOUT_LENGTH = 150,
+};
+
+static const char *const FENS[] = {
+	"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+	// Promotions and en passant captures, right away.
+	"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+	"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+};
+
+void
+test_pawn_hash(void)
+{
+	munit_assert_uint64(POSITION_INIT.pawn_hash, ==, position_pawn_zobrist(&POSITION_INIT));
+	uint64_t prng_state = 0;
+	for (size_t i = 0; i < NUMBER_OF_PLAYOUTS; i++) {
+		struct Board board;
+		position_init_from_fen(&board, FENS[i % ARRAY_SIZE(FENS)]);
+		for (size_t j = 0; j < PLAYOUT_LENGTH; j++) {
+			munit_assert_uint64(board.pawn_hash, ==, position_pawn_zobrist(&board));
+			struct Move moves[MAX_MOVES];
+			size_t moves_count = gen_legal_moves(moves, &board);
+			if (moves_count == 0) {
+				break;
+			}
+			position_do_move_and_flip(&board, moves + prng_next(&prng_state) % moves_count);
+		}
+	}
+}
+
+void
+test_pawn_structure(void)
+{
+	struct Board board;
+	struct PawnEntry entry;
+	// Doubled c-pawns, of which only the front one is passed.
+	position_init_from_fen(&board, "4k3/7p/8/3P4/8/2P1P3/2P5/4K3 w - - 0 1");
+	pawn_entry_init(&entry, &board);
+	munit_assert_int(entry.doubled_count[COLOR_WHITE], ==, 1);
+	munit_assert_int(entry.isolated_count[COLOR_WHITE], ==, 0);
+	munit_assert_int(entry.passed_by_rank[COLOR_WHITE][R_3], ==, 2);
+	munit_assert_int(entry.passed_by_rank[COLOR_WHITE][R_5], ==, 1);
+	munit_assert_int(entry.passed_by_rank[COLOR_WHITE][R_2], ==, 0);
+	munit_assert_int(entry.isolated_count[COLOR_BLACK], ==, 1);
+	munit_assert_int(entry.passed_by_rank[COLOR_BLACK][R_2], ==, 1);
+	// Neither d3 nor c5 can advance safely, and nothing can support them.
+	position_init_from_fen(&board, "4k3/8/8/2p5/4P3/3P4/8/4K3 w - - 0 1");
+	pawn_entry_init(&entry, &board);
+	munit_assert_int(entry.backward_count[COLOR_WHITE], ==, 1);
+	munit_assert_int(entry.backward_count[COLOR_BLACK], ==, 1);
+	munit_assert_int(entry.isolated_count[COLOR_BLACK], ==, 1);
+	munit_assert_int(entry.passed_by_rank[COLOR_BLACK][R_4], ==, 0);
+}
+
+void
+test_pawn_table(void)
+{
+	// Tiny, so that entries get overwritten all the time.
+	struct PawnTable *table = pawn_table_new(4 * sizeof(struct PawnEntry));
+	uint64_t prng_state = 0;
+	for (size_t i = 0; i < NUMBER_OF_PLAYOUTS; i++) {
+		struct Board board;
+		position_init_from_fen(&board, FENS[i % ARRAY_SIZE(FENS)]);
+		for (size_t j = 0; j < PLAYOUT_LENGTH; j++) {
+			munit_assert_double_equal(
+			  position_eval_with_pawn_table(&board, table), position_eval(&board), 4);
+			struct Move moves[MAX_MOVES];
+			size_t moves_count = gen_legal_moves(moves, &board);
+			if (moves_count == 0) {
+				break;
+			}
+			position_do_move_and_flip(&board, moves + prng_next(&prng_state) % moves_count);
+		}
+	}
+	pawn_table_delete(table);
+}
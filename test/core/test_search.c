@@ -0,0 +1,96 @@
+#include "chess/fen.h"
+#include "chess/move.h"
+#include "chess/position.h"
+#include "core/search.h"
+#include "engine.h"
+#include "feature_flags.h"
+#include "munit/munit.h"
+#include "utils.h"
+
+static void
+search(const char *fen, float selectivity, int depth, struct SearchResults *results)
+{
+	struct Board board;
+	position_init_from_fen(&board, fen);
+	struct Config config = { .selectivity = selectivity, .multipv = 1 };
+	position_search(&board, NULL, &config, depth, NULL, results);
+}
+
+void
+test_search_selectivity(void)
+{
+	static const float SELECTIVITIES[] = { 0.0, 0.5, 1.0 };
+	struct SearchResults results;
+	// Forward pruning must not get in the way of a forced mate: Re8+ Rxe8
+	// Rxe8#.
+	for (size_t i = 0; i < ARRAY_SIZE(SELECTIVITIES); i++) {
+		search("r5k1/5ppp/8/8/8/8/4RPPP/4R1K1 w - - 0 1", SELECTIVITIES[i], 4, &results);
+		char buf[MOVE_STRING_MAX_LENGTH] = { '\0' };
+		move_to_string(results.best_move, buf);
+		munit_assert_string_equal(buf, "e2e8");
+		munit_assert_int(score_to_mate_in_moves(results.centipawns), ==, 2);
+	}
+	// The more selective, the fewer nodes...
+	static const char *const NODES_FENS[] = {
+		"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+		"r5k1/5ppp/8/8/8/8/4RPPP/4R1K1 w - - 0 1",
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+	};
+	for (size_t i = 0; i < ARRAY_SIZE(NODES_FENS); i++) {
+		search(NODES_FENS[i], SELECTIVITIES[0], 5, &results);
+		size_t exhaustive_nodes_count = results.nodes_count;
+		size_t nodes_count = exhaustive_nodes_count;
+		for (size_t j = 1; j < ARRAY_SIZE(SELECTIVITIES); j++) {
+			search(NODES_FENS[i], SELECTIVITIES[j], 5, &results);
+			munit_assert_size(results.nodes_count, <=, nodes_count);
+			nodes_count = results.nodes_count;
+		}
+		munit_assert_size(nodes_count, <, exhaustive_nodes_count);
+	}
+	// ...not least because of late move reductions...
+	if (ZULOID_ENABLE_SEARCH_DEBUGGING) {
+		search(NODES_FENS[0], 0.5, 5, &results);
+		const struct SearchStats *stats = &results.stats;
+		munit_assert_size(stats->reductions_count, >, 0);
+		munit_assert_size(stats->reduction_researches_count, <=, stats->reductions_count);
+		munit_assert_size(stats->pruned_moves_count, >, 0);
+		munit_assert_size(stats->first_move_cutoffs_count, >, 0);
+		munit_assert_size(stats->first_move_cutoffs_count, <=, stats->beta_cutoffs_count);
+		munit_assert_size(stats->null_move_cutoffs_count, <=, stats->null_moves_count);
+		munit_assert_size(stats->qnodes_count, <, results.nodes_count);
+	}
+	// ...but the same moves, even in quiet positions where a single king step
+	// is worth more to the evaluation than a piece.
+	static const char *const MOVES_FENS[] = {
+		"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+		"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+		"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+	};
+	for (size_t i = 0; i < ARRAY_SIZE(MOVES_FENS); i++) {
+		search(MOVES_FENS[i], SELECTIVITIES[0], 3, &results);
+		char expected[MOVE_STRING_MAX_LENGTH] = { '\0' };
+		move_to_string(results.best_move, expected);
+		for (size_t j = 1; j < ARRAY_SIZE(SELECTIVITIES); j++) {
+			search(MOVES_FENS[i], SELECTIVITIES[j], 3, &results);
+			char buf[MOVE_STRING_MAX_LENGTH] = { '\0' };
+			move_to_string(results.best_move, buf);
+			munit_assert_string_equal(buf, expected);
+		}
+	}
+}
+
+void
+test_search_seldepth(void)
+{
+	struct SearchResults results;
+	// There are no extensions, so only quiescence goes any deeper.
+	search("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 0.5, 1, &results);
+	munit_assert_int(results.depth, ==, 1);
+	munit_assert_int(results.seldepth, ==, 1);
+	search("r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+	       0.5,
+	       2,
+	       &results);
+	munit_assert_int(results.depth, ==, 2);
+	munit_assert_int(results.seldepth, >, 2);
+}
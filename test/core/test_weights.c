@@ -0,0 +1,88 @@
+#include "agent.h"
+#include "core/weights.h"
+#include "munit/munit.h"
+#include "utils.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#define WEIGHTS_FILENAME TEST_TMP_DIR "/weights.bin"
+
+static void
+write_weights_file(const char *filename)
+{
+	static const int64_t alpha[3] = { 1, -2, 3 };
+	static const int32_t bravo[100] = { [0] = 42, [99] = -42 };
+	const char *const names[] = { "alpha", "bravo" };
+	const void *const data[] = { alpha, bravo };
+	const size_t sizes[] = { sizeof(alpha), sizeof(bravo) };
+	FILE *file = fopen(filename, "wb");
+	munit_assert_not_null(file);
+	munit_assert_int(weights_write(file, names, data, sizes, 2), ==, ERR_CODE_NONE);
+	fclose(file);
+}
+
+void
+test_weights(void)
+{
+	write_weights_file(WEIGHTS_FILENAME);
+	{
+		struct Weights *weights = weights_open(WEIGHTS_FILENAME);
+		munit_assert_not_null(weights);
+		size_t size = 0;
+		const int64_t *alpha = weights_tensor(weights, "alpha", &size);
+		munit_assert_not_null(alpha);
+		munit_assert_uint(size, ==, 3 * sizeof(int64_t));
+		munit_assert_uint((uintptr_t)alpha % WEIGHTS_ALIGNMENT, ==, 0);
+		munit_assert_int(alpha[1], ==, -2);
+		const int32_t *bravo = weights_tensor(weights, "bravo", &size);
+		munit_assert_not_null(bravo);
+		munit_assert_uint((uintptr_t)bravo % WEIGHTS_ALIGNMENT, ==, 0);
+		munit_assert_int(bravo[99], ==, -42);
+		munit_assert_null(weights_tensor(weights, "charlie", NULL));
+		weights_close(weights);
+	}
+	// Any corruption in the payload must be caught by the checksum.
+	{
+		FILE *file = fopen(WEIGHTS_FILENAME, "r+b");
+		fseek(file, -1, SEEK_END);
+		fputc(0xff, file);
+		fclose(file);
+		munit_assert_null(weights_open(WEIGHTS_FILENAME));
+	}
+	// Sizes in the header that would wrap around past the end of the file.
+	{
+		const struct
+		{
+			long offset;
+			uint64_t value;
+		} tamperings[] = {
+			{ offsetof(struct WeightsHeader, tensors_count), UINT32_MAX },
+			{ offsetof(struct WeightsHeader, payload_size), UINT64_MAX - 63 },
+			{ sizeof(struct WeightsHeader) + offsetof(struct WeightsTensor, size_in_bytes),
+			  UINT64_MAX - 63 },
+		};
+		for (size_t i = 0; i < ARRAY_SIZE(tamperings); i++) {
+			write_weights_file(WEIGHTS_FILENAME);
+			FILE *file = fopen(WEIGHTS_FILENAME, "r+b");
+			fseek(file, tamperings[i].offset, SEEK_SET);
+			size_t size = tamperings[i].offset ==
+			                  (long)offsetof(struct WeightsHeader, tensors_count)
+			                ? sizeof(uint32_t)
+			                : sizeof(uint64_t);
+			// Little-endian, like the file format.
+			fwrite(&tamperings[i].value, size, 1, file);
+			fclose(file);
+			munit_assert_null(weights_open(WEIGHTS_FILENAME));
+		}
+	}
+	// The agent refuses files without its own tensors.
+	write_weights_file(WEIGHTS_FILENAME);
+	{
+		struct Agent *agent = agent_new();
+		munit_assert_int(agent_load_weights(agent, WEIGHTS_FILENAME), !=, ERR_CODE_NONE);
+		munit_assert_int(agent_load_weights(agent, TEST_TMP_DIR "/nonexistent"), !=, 0);
+		agent_delete(agent);
+	}
+}
@@ -33,23 +33,42 @@ test_pre(const char *function_name)
 
 // clang-format off
 extern void test_960(void);
+extern void test_960_is_deterministic(void);
 extern void test_bb_subset(void);
+extern void test_board_batch(void);
+extern void test_book(void);
 extern void test_attacks(void);
+extern void test_attack_maps(void);
 extern void test_cache_single_key_retrieval(void);
+extern void test_cache_collisions(void);
 extern void test_castling_mask(void);
 extern void test_char_to_file(void);
 extern void test_char_to_piece(void);
 extern void test_color_other(void);
 extern void test_diagonals_dont_overlap(const Bitboard diagonals[15]);
+extern void test_do_move(void);
+extern void test_eval_gradient(void);
 extern void test_fen_conversion(void);
 extern void test_fen_init(void);
+extern void test_history(void);
 extern void test_file_to_char(void);
-extern void test_init(void);
+extern void test_line_reader(void);
+extern void test_logger(void);
 extern void test_magic_generation(void);
+extern void test_magics_find(void);
+extern void test_metrics(void);
+extern void test_packed(void);
+extern void test_pawn_hash(void);
+extern void test_pawn_structure(void);
+extern void test_pawn_table(void);
+extern void test_pgn(void);
 extern void test_piece_to_char(void);
 extern void test_position_is_illegal(void);
 extern void test_position_is_legal(void);
 extern void test_rating(void);
+extern void test_san(void);
+extern void test_search_selectivity(void);
+extern void test_search_seldepth(void);
 extern void test_perft_results(struct Engine *);
 extern void test_engine_call_cecp(struct Engine *);
 extern void test_engine_call_cecp_ping(struct Engine *);
@@ -58,14 +77,21 @@ extern void test_protocol_switch(struct Engine *);
 extern void test_engine_call_uci_empty(struct Engine *);
 extern void test_engine_call_uci_cmd_d(struct Engine *);
 extern void test_engine_call_uci_cmd_debug(struct Engine *);
+extern void test_engine_call_uci_cmd_go_multipv(struct Engine *);
 extern void test_engine_call_uci_cmd_go_perft(struct Engine *);
+extern void test_engine_call_uci_cmd_go_ponder(struct Engine *);
+extern void test_engine_call_uci_cmd_go_ponder_position(struct Engine *);
 extern void test_engine_call_uci_cmd_isready(struct Engine *);
 extern void test_engine_call_uci_cmd_position(struct Engine *);
+extern void test_engine_call_uci_cmd_position_incremental(struct Engine *);
 extern void test_engine_call_uci_cmd_quit(struct Engine *);
+extern void test_engine_call_uci_cmd_stats(struct Engine *);
 extern void test_engine_call_uci_cmd_uci(struct Engine *);
 extern void test_engine_call_uci_unknown_cmd(struct Engine *);
 extern void test_square_to_bb_conversion(void);
+extern void test_threats(void);
 extern void test_utils(void);
+extern void test_weights(void);
 // clang-format on
 
 int
@@ -74,24 +100,43 @@ main(void)
 	init_subsystems();
 	CALL_TEST(test_utils);
 	CALL_TEST(test_960);
+	CALL_TEST(test_960_is_deterministic);
 	CALL_TEST(test_attacks);
+	CALL_TEST(test_attack_maps);
 	CALL_TEST(test_bb_subset);
+	CALL_TEST(test_board_batch);
+	CALL_TEST(test_book);
 	CALL_TEST(test_castling_mask);
 	CALL_TEST(test_cache_single_key_retrieval);
+	CALL_TEST(test_cache_collisions);
 	CALL_TEST(test_char_to_file);
 	CALL_TEST(test_char_to_piece);
 	CALL_TEST(test_color_other);
 	CALL_TEST_WITH_ARGS(test_diagonals_dont_overlap, DIAGONALS_A1H8);
 	CALL_TEST_WITH_ARGS(test_diagonals_dont_overlap, DIAGONALS_A8H1);
+	CALL_TEST(test_do_move);
+	CALL_TEST(test_eval_gradient);
 	CALL_TEST(test_fen_conversion);
 	CALL_TEST(test_fen_init);
+	CALL_TEST(test_history);
 	CALL_TEST(test_file_to_char);
-	CALL_TEST(test_init);
+	CALL_TEST(test_line_reader);
+	CALL_TEST(test_logger);
 	CALL_TEST(test_magic_generation);
+	CALL_TEST(test_magics_find);
+	CALL_TEST(test_metrics);
+	CALL_TEST(test_packed);
+	CALL_TEST(test_pawn_hash);
+	CALL_TEST(test_pawn_structure);
+	CALL_TEST(test_pawn_table);
+	CALL_TEST(test_pgn);
 	CALL_TEST(test_piece_to_char);
 	CALL_TEST(test_position_is_illegal);
 	CALL_TEST(test_position_is_legal);
 	CALL_TEST(test_rating);
+	CALL_TEST(test_san);
+	CALL_TEST(test_search_selectivity);
+	CALL_TEST(test_search_seldepth);
 	CALL_TEST_WITH_TMP_ENGINE(test_engine_call_cecp);
 	CALL_TEST_WITH_TMP_ENGINE(test_engine_call_cecp_ping);
 	CALL_TEST_WITH_TMP_ENGINE(test_engine_call_cecp_quit);
@@ -99,13 +144,20 @@ main(void)
 	CALL_TEST_WITH_TMP_ENGINE(test_engine_call_uci_empty);
 	CALL_TEST_WITH_TMP_ENGINE(test_engine_call_uci_cmd_d);
 	CALL_TEST_WITH_TMP_ENGINE(test_engine_call_uci_cmd_debug);
+	CALL_TEST_WITH_TMP_ENGINE(test_engine_call_uci_cmd_go_multipv);
 	CALL_TEST_WITH_TMP_ENGINE(test_engine_call_uci_cmd_go_perft);
+	CALL_TEST_WITH_TMP_ENGINE(test_engine_call_uci_cmd_go_ponder);
+	CALL_TEST_WITH_TMP_ENGINE(test_engine_call_uci_cmd_go_ponder_position);
 	CALL_TEST_WITH_TMP_ENGINE(test_engine_call_uci_cmd_isready);
 	CALL_TEST_WITH_TMP_ENGINE(test_engine_call_uci_cmd_position);
+	CALL_TEST_WITH_TMP_ENGINE(test_engine_call_uci_cmd_position_incremental);
 	CALL_TEST_WITH_TMP_ENGINE(test_engine_call_uci_cmd_quit);
+	CALL_TEST_WITH_TMP_ENGINE(test_engine_call_uci_cmd_stats);
 	CALL_TEST_WITH_TMP_ENGINE(test_engine_call_uci_cmd_uci);
 	CALL_TEST_WITH_TMP_ENGINE(test_engine_call_uci_unknown_cmd);
 	CALL_TEST(test_square_to_bb_conversion);
+	CALL_TEST(test_threats);
+	CALL_TEST(test_weights);
 	CALL_TEST_WITH_TMP_ENGINE(test_perft_results);
 	puts("All tests passed.");
 	return EXIT_SUCCESS;
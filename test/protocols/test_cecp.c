@@ -7,8 +7,8 @@
 void
 test_engine_call_cecp(struct Engine *engine)
 {
-	engine_call_cecp(engine, "xboard");
-	engine_call_cecp(engine, "protover 2");
+	engine_call_cecp_literal(engine, "xboard");
+	engine_call_cecp_literal(engine, "protover 2");
 	{
 		struct Lines *lines = file_line_by_line(engine->config.output);
 		for (size_t i = 0; i < lines_count(lines); i++) {
@@ -21,10 +21,10 @@ test_engine_call_cecp(struct Engine *engine)
 void
 test_engine_call_cecp_ping(struct Engine *engine)
 {
-	engine_call_cecp(engine, "ping 0");
-	engine_call_cecp(engine, "ping -1");
-	engine_call_cecp(engine, "ping 128");
-	engine_call_cecp(engine, "ping -1025");
+	engine_call_cecp_literal(engine, "ping 0");
+	engine_call_cecp_literal(engine, "ping -1");
+	engine_call_cecp_literal(engine, "ping 128");
+	engine_call_cecp_literal(engine, "ping -1025");
 	{
 		struct Lines *lines = file_line_by_line(engine->config.output);
 		munit_assert_string_equal(lines_nth(lines, 0), "pong 0");
@@ -39,10 +39,10 @@ void
 test_engine_call_cecp_quit(struct Engine *engine)
 {
 	{
-		munit_assert_uint(engine->status, !=, STATUS_EXIT);
+		munit_assert_int(p_atomic_int_get(&engine->status), !=, STATUS_EXIT);
 	}
-	engine_call_cecp(engine, "quit");
+	engine_call_cecp_literal(engine, "quit");
 	{
-		munit_assert_uint(engine->status, ==, STATUS_EXIT);
+		munit_assert_int(p_atomic_int_get(&engine->status), ==, STATUS_EXIT);
 	}
 }
@@ -0,0 +1,34 @@
+#include "munit/munit.h"
+#include "protocols/support/line_reader.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+void
+test_line_reader(void)
+{
+	const char *path = TEST_TMP_DIR "/input.txt";
+	// Longer than the initial buffer, so that it has to grow.
+	char long_line[LINE_READER_MIN_CAPACITY * 3];
+	memset(long_line, 'x', sizeof(long_line) - 1);
+	long_line[sizeof(long_line) - 1] = '\0';
+	FILE *file = fopen(path, "w");
+	munit_assert_not_null(file);
+	fprintf(file, "uci\n\nisready\n%s\nposition startpos\ngo", long_line);
+	fclose(file);
+	file = fopen(path, "r");
+	munit_assert_not_null(file);
+	struct LineReader reader;
+	line_reader_init(&reader, fileno(file));
+	munit_assert_string_equal(line_reader_next(&reader), "uci");
+	munit_assert_string_equal(line_reader_next(&reader), "");
+	munit_assert_string_equal(line_reader_next(&reader), "isready");
+	munit_assert_string_equal(line_reader_next(&reader), long_line);
+	munit_assert_string_equal(line_reader_next(&reader), "position startpos");
+	// No newline at the end.
+	munit_assert_string_equal(line_reader_next(&reader), "go");
+	munit_assert_null(line_reader_next(&reader));
+	munit_assert_null(line_reader_next(&reader));
+	line_reader_free(&reader);
+	fclose(file);
+}
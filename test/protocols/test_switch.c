@@ -6,14 +6,17 @@
 void
 test_protocol_switch(struct Engine *engine)
 {
+	// Commands are tokenized in place, so they can't be literals.
+	char xboard_cmd[] = "xboard";
+	char uci_cmd[] = "uci";
 	{
 		munit_assert(engine->config.protocol == engine_call_uci);
 	}
-	engine->config.protocol(engine, "xboard");
+	engine->config.protocol(engine, xboard_cmd);
 	{
 		munit_assert(engine->config.protocol == engine_call_cecp);
 	}
-	engine->config.protocol(engine, "uci");
+	engine->config.protocol(engine, uci_cmd);
 	{
 		munit_assert(engine->config.protocol == engine_call_uci);
 	}
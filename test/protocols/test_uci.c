@@ -1,16 +1,21 @@
 #include "chess/fen.h"
+#include "chess/move.h"
+#include "chess/movegen.h"
 #include "engine.h"
+#include "feature_flags.h"
 #include "munit/munit.h"
 #include "protocols/uci.h"
 #include "test/utils.h"
 #include "utils.h"
+#include <plibsys.h>
+#include <string.h>
 
 void
 test_engine_call_uci_empty(struct Engine *engine)
 {
-	engine_call_uci(engine, "   ");
-	engine_call_uci(engine, "");
-	engine_call_uci(engine, "\n \t ");
+	engine_call_uci_literal(engine, "   ");
+	engine_call_uci_literal(engine, "");
+	engine_call_uci_literal(engine, "\n \t ");
 	{
 		struct Lines *lines = file_line_by_line(engine->config.output);
 		munit_assert_uint(lines_count(lines), ==, 0);
@@ -20,8 +25,8 @@ test_engine_call_uci_empty(struct Engine *engine)
 void
 test_engine_call_uci_cmd_d(struct Engine *engine)
 {
-	engine_call_uci(engine, "d lichess");
-	engine_call_uci(engine, "d");
+	engine_call_uci_literal(engine, "d lichess");
+	engine_call_uci_literal(engine, "d");
 	{
 		struct Lines *lines = file_line_by_line(engine->config.output);
 		size_t n_lines = lines_count(lines);
@@ -41,7 +46,7 @@ test_engine_call_uci_cmd_d(struct Engine *engine)
 void
 test_engine_call_uci_cmd_go_perft(struct Engine *engine)
 {
-	engine_call_uci(engine, "go perft");
+	engine_call_uci_literal(engine, "go perft");
 	{
 		struct Lines *lines = file_line_by_line(engine->config.output);
 		munit_assert_not_null(strstr(lines_nth(lines, 0), "ERROR"));
@@ -49,10 +54,102 @@ test_engine_call_uci_cmd_go_perft(struct Engine *engine)
 	}
 }
 
+static bool
+lines_contain_bestmove(struct Lines *lines)
+{
+	for (size_t i = 0; i < lines_count(lines); i++) {
+		if (strncmp(lines_nth(lines, i), "bestmove", 8) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void
+test_engine_call_uci_cmd_go_multipv(struct Engine *engine)
+{
+	engine_call_uci_literal(engine, "setoption name MultiPV value 3");
+	engine_call_uci_literal(engine, "position startpos");
+	engine_call_uci_literal(engine, "go depth 2");
+	while (engine->status != STATUS_IDLE) {
+		p_uthread_sleep(1);
+	}
+	engine_call_uci_literal(engine, "stop");
+	struct Lines *lines = file_line_by_line(engine->config.output);
+	size_t depth_2_lines_count = 0;
+	for (size_t i = 0; i < lines_count(lines); i++) {
+		const char *line = lines_nth(lines, i);
+		if (strstr(line, "info depth 2 ")) {
+			char expected[] = "multipv 1 ";
+			expected[8] = '1' + depth_2_lines_count++;
+			munit_assert_not_null(strstr(line, expected));
+			// Each line has both a root move and a reply.
+			const char *pv = strstr(line, " pv ");
+			munit_assert_not_null(pv);
+			munit_assert_not_null(strchr(pv + 4, ' '));
+		}
+	}
+	munit_assert_uint(depth_2_lines_count, ==, 3);
+	munit_assert_not_null(strstr(lines_nth(lines, -1), "bestmove"));
+	lines_delete(lines);
+}
+
+void
+test_engine_call_uci_cmd_go_ponder(struct Engine *engine)
+{
+	engine_call_uci_literal(engine, "position startpos");
+	engine_call_uci_literal(engine, "go ponder depth 2");
+	// Even if the search is over, it mustn't report before "ponderhit".
+	p_uthread_sleep(100);
+	{
+		struct Lines *lines = file_line_by_line(engine->config.output);
+		munit_assert_false(lines_contain_bestmove(lines));
+		lines_delete(lines);
+	}
+	engine_call_uci_literal(engine, "ponderhit");
+	engine_call_uci_literal(engine, "stop");
+	{
+		struct Lines *lines = file_line_by_line(engine->config.output);
+		char *last_line = lines_nth(lines, -1);
+		munit_assert_not_null(last_line);
+		munit_assert_not_null(strstr(last_line, "bestmove"));
+		munit_assert_not_null(strstr(last_line, " ponder "));
+		lines_delete(lines);
+	}
+}
+
+void
+test_engine_call_uci_cmd_go_ponder_position(struct Engine *engine)
+{
+	engine_call_uci_literal(engine, "position startpos");
+	engine_call_uci_literal(engine, "go ponder");
+	// The search must be over before the board changes.
+	engine_call_uci_literal(engine, "position startpos moves e2e4");
+	munit_assert_null(engine->search_thread);
+	munit_assert_int(p_atomic_int_get(&engine->status), ==, STATUS_IDLE);
+	{
+		struct Lines *lines = file_line_by_line(engine->config.output);
+		char *last_line = lines_nth(lines, -1);
+		munit_assert_not_null(last_line);
+		// Interrupted searches still report a legal move.
+		struct Board board = POSITION_INIT;
+		struct Move moves[MAX_MOVES];
+		size_t moves_count = gen_legal_moves(moves, &board);
+		bool is_legal = false;
+		for (size_t i = 0; i < moves_count; i++) {
+			char buf[MOVE_STRING_MAX_LENGTH] = { '\0' };
+			move_to_string(moves[i], buf);
+			is_legal |= strncmp(last_line + strlen("bestmove "), buf, strlen(buf)) == 0;
+		}
+		munit_assert_true(is_legal);
+		lines_delete(lines);
+	}
+}
+
 void
 test_engine_call_uci_cmd_isready(struct Engine *engine)
 {
-	engine_call_uci(engine, "isready");
+	engine_call_uci_literal(engine, "isready");
 	{
 		struct Lines *lines = file_line_by_line(engine->config.output);
 		munit_assert_uint(lines_count(lines), ==, 1);
@@ -69,7 +166,7 @@ test_engine_call_uci_cmd_position(struct Engine *engine)
 		struct Piece piece_at_e4 = position_piece_at_square(&engine->board, e4);
 		munit_assert_uint(piece_at_e4.type, !=, PIECE_TYPE_PAWN);
 	}
-	engine_call_uci(engine, "position current moves e2e4");
+	engine_call_uci_literal(engine, "position current moves e2e4");
 	{
 		struct Piece piece_at_e4 = position_piece_at_square(&engine->board, e4);
 		munit_assert_uint(piece_at_e4.type, ==, PIECE_TYPE_PAWN);
@@ -77,7 +174,7 @@ test_engine_call_uci_cmd_position(struct Engine *engine)
 		munit_assert_uint(lines_count(lines), ==, 0);
 		lines_delete(lines);
 	}
-	engine_call_uci(engine, "position startpos");
+	engine_call_uci_literal(engine, "position startpos");
 	{
 		struct Piece piece_at_e4 = position_piece_at_square(&engine->board, e4);
 		munit_assert_uint(piece_at_e4.type, ==, PIECE_TYPE_NONE);
@@ -87,22 +184,77 @@ test_engine_call_uci_cmd_position(struct Engine *engine)
 	}
 }
 
+static void
+assert_engine_board_eq_fen(struct Engine *engine, const char *fen)
+{
+	char *actual = fen_from_position(NULL, &engine->board, ' ');
+	munit_assert_string_equal(actual, fen);
+	free(actual);
+	munit_assert_uint64(engine->board.hash, ==, position_zobrist(&engine->board));
+	munit_assert_true(engine_game_is_consistent(engine));
+}
+
+void
+test_engine_call_uci_cmd_position_incremental(struct Engine *engine)
+{
+	engine_call_uci_literal(engine, "position startpos moves e2e4 e7e5");
+	engine_call_uci_literal(engine, "position startpos moves e2e4 e7e5 g1f3 b8c6");
+	munit_assert_size(engine->game_moves_count, ==, 4);
+	assert_engine_board_eq_fen(
+	  engine, "r1bqkbnr/pppp1ppp/2n5/4p3/4P3/5N2/PPPP1PPP/RNBQKB1R w KQkq - 2 3");
+	// Takebacks and different lines.
+	engine_call_uci_literal(engine, "position startpos moves e2e4 c7c5");
+	assert_engine_board_eq_fen(
+	  engine, "rnbqkbnr/pp1ppppp/8/2p5/4P3/8/PPPP1PPP/RNBQKBNR w KQkq c6 0 2");
+	engine_call_uci_literal(engine, "position startpos moves e2e4");
+	assert_engine_board_eq_fen(
+	  engine, "rnbqkbnr/pppppppp/8/8/4P3/8/PPPP1PPP/RNBQKBNR b KQkq e3 0 1");
+	engine_call_uci_literal(engine, "position current moves c7c5");
+	munit_assert_size(engine->game_moves_count, ==, 2);
+	munit_assert_size(engine->history.count, ==, 3);
+	// A different starting position means a different game.
+	engine_call_uci_literal(engine,
+	                        "position fen 4k3/8/8/8/8/8/4P3/4K3 w - - 0 1 moves e2e4");
+	munit_assert_size(engine->game_moves_count, ==, 1);
+	assert_engine_board_eq_fen(engine, "4k3/8/8/8/4P3/8/8/4K3 b - e3 0 1");
+}
+
 void
 test_engine_call_uci_cmd_quit(struct Engine *engine)
 {
 	{
 		munit_assert_uint(engine->status, !=, STATUS_EXIT);
 	}
-	engine_call_uci(engine, "quit");
+	engine_call_uci_literal(engine, "quit");
 	{
 		munit_assert_uint(engine->status, ==, STATUS_EXIT);
 	}
 }
 
+void
+test_engine_call_uci_cmd_stats(struct Engine *engine)
+{
+	engine_call_uci_literal(engine, "go depth 2");
+	while (engine->status != STATUS_IDLE) {
+		p_uthread_sleep(1);
+	}
+	engine_call_uci_literal(engine, "stop");
+	engine_call_uci_literal(engine, "%stats");
+	struct Lines *lines = file_line_by_line(engine->config.output);
+	const char *json = lines_nth(lines, -1);
+	munit_assert_char(json[0], ==, '{');
+	munit_assert_not_null(strstr(json, "\"iterations\":["));
+	munit_assert_not_null(strstr(json, "\"first_move_cutoffs\":"));
+	if (ZULOID_ENABLE_SEARCH_DEBUGGING) {
+		munit_assert_not_null(strstr(json, "\"depth\":2"));
+	}
+	lines_delete(lines);
+}
+
 void
 test_engine_call_uci_cmd_uci(struct Engine *engine)
 {
-	engine_call_uci(engine, "uci");
+	engine_call_uci_literal(engine, "uci");
 	{
 		struct Lines *lines = file_line_by_line(engine->config.output);
 		for (size_t i = 0; i < lines_count(lines) - 1; i++) {
@@ -124,7 +276,7 @@ test_engine_call_uci_cmd_debug(struct Engine *engine)
 		munit_assert_uint(lines_count(lines), ==, 0);
 		lines_delete(lines);
 	}
-	engine_call_uci(engine, "debug on");
+	engine_call_uci_literal(engine, "debug on");
 	{
 		ENGINE_LOGF(engine, "VALERIA\n");
 		struct Lines *lines = file_line_by_line(engine->config.output);
@@ -136,7 +288,7 @@ test_engine_call_uci_cmd_debug(struct Engine *engine)
 void
 test_engine_call_uci_unknown_cmd(struct Engine *engine)
 {
-	engine_call_uci(engine, "foobar");
+	engine_call_uci_literal(engine, "foobar");
 	{
 		struct Lines *lines = file_line_by_line(engine->config.output);
 		munit_assert_uint(lines_count(lines), ==, 1);
@@ -21,4 +21,11 @@ file_line_by_line(FILE *stream);
 struct Engine *
 engine_new_tmp(const char *filename);
 
+/* Protocols tokenize commands in place, so string literals are copied first. */
+void
+engine_call_uci_literal(struct Engine *engine, const char *cmd);
+
+void
+engine_call_cecp_literal(struct Engine *engine, const char *cmd);
+
 #endif
@@ -1,4 +1,5 @@
 #include "cache/cache.h"
+#include "chess/fen.h"
 #include "munit/munit.h"
 
 void
@@ -7,4 +8,27 @@ test_cache_single_key_retrieval(void)
 	struct Cache *cache = cache_new(1024);
 	struct CacheEntry *entry = cache_get(cache, &POSITION_INIT);
 	munit_assert_not_null(entry);
+	munit_assert(cache_entry_is_empty(entry));
+	*entry = (struct CacheEntry){ .evaluation = 0.5, .dispersion = 0.25 };
+	entry = cache_get(cache, &POSITION_INIT);
+	munit_assert(!cache_entry_is_empty(entry));
+	munit_assert_double_equal(entry->evaluation, 0.5, 4);
+	munit_assert_double_equal(entry->dispersion, 0.25, 4);
+	cache_clear(cache);
+	munit_assert(cache_entry_is_empty(cache_get(cache, &POSITION_INIT)));
+	cache_delete(cache);
+}
+
+void
+test_cache_collisions(void)
+{
+	// A single slot, so that every position evicts the previous one.
+	struct Cache *cache = cache_new(1);
+	struct Board board;
+	position_init_from_fen(&board, "4k3/8/8/8/8/8/8/4K3 w - - 0 1");
+	cache_get(cache, &POSITION_INIT)->evaluation = 1.0;
+	munit_assert(cache_entry_is_empty(cache_get(cache, &board)));
+	cache_get(cache, &board)->evaluation = -1.0;
+	munit_assert(cache_entry_is_empty(cache_get(cache, &POSITION_INIT)));
+	cache_delete(cache);
 }
@@ -0,0 +1,115 @@
+#include "logger.h"
+#include "munit/munit.h"
+#include "utils.h"
+#include <plibsys.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum
+{
+	TEST_LOGGER_THREADS_COUNT = 4,
+	TEST_LOGGER_RECORDS_COUNT = 100,
+	TEST_LOGGER_LATE_RECORDS_COUNT = 20000,
+};
+
+static void
+test_logf(struct Logger *logger, const char *format, ...)
+{
+	va_list args;
+	va_start(args, format);
+	logger_vlogf(logger, __FILE__, __LINE__, __func__, format, args);
+	va_end(args);
+}
+
+static ppointer
+test_logger_thread_run(ppointer data)
+{
+	for (int i = 0; i < TEST_LOGGER_RECORDS_COUNT; i++) {
+		test_logf(data, "Record %d.\n", i);
+	}
+	return NULL;
+}
+
+static ppointer
+test_logger_late_thread_run(ppointer data)
+{
+	for (int i = 0; i < TEST_LOGGER_LATE_RECORDS_COUNT; i++) {
+		test_logf(data, "Late record %d.\n", i);
+	}
+	return NULL;
+}
+
+/* Records that race with closing the logger must be either written or
+ * discarded, but never left behind for the next log file. */
+static void
+test_logger_close_while_logging(void)
+{
+	const char *path = TEST_TMP_DIR "/log_close.txt";
+	const char *next_path = TEST_TMP_DIR "/log_close_next.txt";
+	remove(path);
+	remove(next_path);
+	struct Logger *logger = logger_new();
+	munit_assert_int(logger_open(logger, path), ==, ERR_CODE_NONE);
+	PUThread *threads[TEST_LOGGER_THREADS_COUNT];
+	for (int i = 0; i < TEST_LOGGER_THREADS_COUNT; i++) {
+		threads[i] = p_uthread_create(test_logger_late_thread_run, logger, true, "test");
+	}
+	p_uthread_sleep(1);
+	munit_assert_int(logger_open(logger, NULL), ==, ERR_CODE_NONE);
+	for (int i = 0; i < TEST_LOGGER_THREADS_COUNT; i++) {
+		p_uthread_join(threads[i]);
+		p_uthread_unref(threads[i]);
+	}
+	munit_assert_int(logger_open(logger, next_path), ==, ERR_CODE_NONE);
+	logger_delete(logger);
+	FILE *file = fopen(next_path, "r");
+	munit_assert_not_null(file);
+	char *line = read_line(file);
+	munit_assert_string_equal(line, "");
+	free(line);
+	fclose(file);
+}
+
+void
+test_logger(void)
+{
+	const char *path = TEST_TMP_DIR "/log.txt";
+	remove(path);
+	struct Logger *logger = logger_new();
+	// Closed loggers discard everything.
+	test_logf(logger, "Discarded.\n");
+	munit_assert_false(logger_is_open(logger));
+	munit_assert_int(logger_open(logger, path), ==, ERR_CODE_NONE);
+	munit_assert_true(logger_is_open(logger));
+	PUThread *threads[TEST_LOGGER_THREADS_COUNT];
+	for (int i = 0; i < TEST_LOGGER_THREADS_COUNT; i++) {
+		threads[i] = p_uthread_create(test_logger_thread_run, logger, true, "test");
+	}
+	for (int i = 0; i < TEST_LOGGER_THREADS_COUNT; i++) {
+		p_uthread_join(threads[i]);
+		p_uthread_unref(threads[i]);
+	}
+	test_logf(logger, "Last record: %s.\n", "bye");
+	logger_flush(logger);
+	FILE *file = fopen(path, "r");
+	munit_assert_not_null(file);
+	size_t lines_count = 0;
+	bool has_last_record = false;
+	while (!feof(file)) {
+		char *line = read_line(file);
+		if (*line) {
+			munit_assert_null(strstr(line, "Discarded"));
+			munit_assert_not_null(strstr(line, "test_logger.c:"));
+			has_last_record |= strstr(line, "@ test_logf -- Last record: bye.") != NULL;
+			lines_count++;
+		}
+		free(line);
+	}
+	fclose(file);
+	munit_assert_true(has_last_record);
+	munit_assert_size(lines_count, ==, TEST_LOGGER_THREADS_COUNT * TEST_LOGGER_RECORDS_COUNT + 1);
+	logger_delete(logger);
+	test_logger_close_while_logging();
+}
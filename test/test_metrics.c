@@ -0,0 +1,36 @@
+#include "metrics.h"
+#include "munit/munit.h"
+#include "utils.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+void
+test_metrics(void)
+{
+	struct Metrics *metrics = metrics_new();
+	metrics_add_search(metrics, 1000, 500000, false);
+	metrics_add_search(metrics, 3000, 1500000, true);
+	char buf[METRICS_MAX_SIZE];
+	size_t length = metrics_sprint(metrics, buf, sizeof(buf));
+	munit_assert_size(length, ==, strlen(buf));
+	munit_assert_not_null(strstr(buf, "\nzuloid_search_seconds_count 2\n"));
+	munit_assert_not_null(strstr(buf, "\nzuloid_search_seconds_sum 2.000000\n"));
+	munit_assert_not_null(strstr(buf, "\nzuloid_search_nodes_total 4000\n"));
+	munit_assert_not_null(strstr(buf, "\nzuloid_nps 2000\n"));
+	munit_assert_not_null(strstr(buf, "\nzuloid_time_losses_total 1\n"));
+	// OpenMetrics requires this terminator.
+	munit_assert_string_equal(buf + length - 6, "# EOF\n");
+	// The file is written once more when exporting stops.
+	const char *path = TEST_TMP_DIR "/metrics.prom";
+	remove(path);
+	munit_assert_int(metrics_export_to_file(metrics, path), ==, ERR_CODE_NONE);
+	munit_assert_int(metrics_export_to_file(metrics, NULL), ==, ERR_CODE_NONE);
+	FILE *file = fopen(path, "r");
+	munit_assert_not_null(file);
+	char *line = read_line(file);
+	munit_assert_not_null(strstr(line, "# TYPE"));
+	free(line);
+	fclose(file);
+	metrics_delete(metrics);
+}
@@ -3,7 +3,6 @@
 #include "chess/magic.h"
 #include "chess/perft.h"
 #include "chess/position.h"
-#include "chess/threats.h"
 #include "engine.h"
 #include "munit/munit.h"
 #include "test/utils.h"
@@ -11,6 +10,9 @@
 
 #define POSITION_1 "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1"
 #define POSITION_2 "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - "
+#define POSITION_3 "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1"
+#define POSITION_4 "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1"
+#define POSITION_5 "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8"
 
 struct PerftTestCase
 {
@@ -22,15 +24,13 @@ struct PerftTestCase
 const struct PerftTestCase TEST_CASES[] = {
 	{ POSITION_1, 0, 1 },    { POSITION_1, 1, 20 },     { POSITION_1, 2, 400 },
 	{ POSITION_1, 3, 8902 }, { POSITION_1, 4, 197281 }, { POSITION_2, 1, 48 },
-	{ POSITION_2, 2, 2039 },
-	//{ POSITION_2, 3, 2812 },   { POSITION_2, 4, 43238 },
-	//{ POSITION_2, 5, 674624 },
+	{ POSITION_2, 2, 2039 }, { POSITION_2, 3, 97862 }, { POSITION_3, 4, 43238 },
+	{ POSITION_3, 5, 674624 }, { POSITION_4, 3, 9467 },  { POSITION_5, 3, 62379 },
 };
 
 void
 test_perft_results(struct Engine *engine)
 {
-	init_threats();
 	for (size_t i = 0; i < ARRAY_SIZE(TEST_CASES); i++) {
 		position_init_from_fen(&engine->board, TEST_CASES[i].fen);
 		{
@@ -1,5 +1,7 @@
 #include "test/utils.h"
 #include "engine.h"
+#include "protocols/cecp.h"
+#include "protocols/uci.h"
 #include "utils.h"
 #include <stdlib.h>
 #include <string.h>
@@ -84,3 +86,19 @@ engine_new_tmp(const char *filename)
 	}
 	return engine;
 }
+
+void
+engine_call_uci_literal(struct Engine *engine, const char *cmd)
+{
+	char *copy = exit_if_null(strdup(cmd));
+	engine_call_uci(engine, copy);
+	free(copy);
+}
+
+void
+engine_call_cecp_literal(struct Engine *engine, const char *cmd)
+{
+	char *copy = exit_if_null(strdup(cmd));
+	engine_call_cecp(engine, copy);
+	free(copy);
+}
@@ -0,0 +1,114 @@
+/* SPDX-License-Identifier: GPL-3.0-only */
+
+/* Generates the attack tables declared in include/chess/generated/threats.h.
+ * The build runs it before compiling the engine, with the path of the C file
+ * to write as its only argument.
+ *
+ * Slider tables are compacted and overlap wherever they can, see
+ * `magics_build_attacks`. */
+
+#include "chess/generated/magics_bishop.h"
+#include "chess/generated/magics_rook.h"
+#include "chess/magic.h"
+#include "chess/threats.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+static void
+export_bitboards(FILE *stream, const char *identifier, const Bitboard *bbs, size_t count)
+{
+	fprintf(stream, "const Bitboard %s[%zu] = {", identifier, count);
+	for (size_t i = 0; i < count; i++) {
+		fprintf(stream, "%s0x%016" PRIx64 "ULL,", i % 4 ? " " : "\n\t", bbs[i]);
+	}
+	fprintf(stream, "\n};\n\n");
+}
+
+static void
+export_leaper(FILE *stream, const char *identifier, Bitboard (*leaper)(Square))
+{
+	Bitboard threats[SQUARES_COUNT];
+	for (Square sq = 0; sq < SQUARES_COUNT; sq++) {
+		threats[sq] = leaper(sq);
+	}
+	export_bitboards(stream, identifier, threats, SQUARES_COUNT);
+}
+
+static int
+export_slider(FILE *stream,
+              const char *name,
+              const struct Magic magics[SQUARES_COUNT],
+              Bitboard (*slider)(Square, Bitboard))
+{
+	size_t offsets[SQUARES_COUNT];
+	size_t size;
+	Bitboard *attacks = magics_build_attacks(magics, slider, offsets, &size);
+	if (!attacks) {
+		return EXIT_FAILURE;
+	}
+	fprintf(stream, "const Bitboard BB_MASK_%s[SQUARES_COUNT] = {", name);
+	for (Square sq = 0; sq < SQUARES_COUNT; sq++) {
+		fprintf(stream, "%s0x%016" PRIx64 "ULL,", sq % 4 ? " " : "\n\t", magics[sq].premask);
+	}
+	fprintf(stream, "\n};\n\n");
+	// Black magics hash `occupancy | ~premask`, i.e. `(occupancy & premask) |
+	// ~premask`.
+	fprintf(stream, "const Bitboard BB_FILL_%s[SQUARES_COUNT] = {", name);
+	for (Square sq = 0; sq < SQUARES_COUNT; sq++) {
+		Bitboard fill = magics[sq].black ? ~magics[sq].premask : 0;
+		fprintf(stream, "%s0x%016" PRIx64 "ULL,", sq % 4 ? " " : "\n\t", fill);
+	}
+	fprintf(stream, "\n};\n\n");
+	fprintf(stream, "const uint64_t BB_MULTIPLIERS_%s[SQUARES_COUNT] = {", name);
+	for (Square sq = 0; sq < SQUARES_COUNT; sq++) {
+		fprintf(
+		  stream, "%s0x%016" PRIx64 "ULL,", sq % 4 ? " " : "\n\t", magics[sq].multiplier);
+	}
+	fprintf(stream, "\n};\n\n");
+	fprintf(stream, "const unsigned char BB_SHIFTS_%s[SQUARES_COUNT] = {", name);
+	for (Square sq = 0; sq < SQUARES_COUNT; sq++) {
+		fprintf(stream, "%s%d,", sq % 16 ? " " : "\n\t", magics[sq].rshift);
+	}
+	fprintf(stream, "\n};\n\n");
+	fprintf(stream, "const size_t BB_OFFSETS_%s[SQUARES_COUNT] = {", name);
+	for (Square sq = 0; sq < SQUARES_COUNT; sq++) {
+		fprintf(stream, "%s%zu,", sq % 8 ? " " : "\n\t", offsets[sq]);
+	}
+	fprintf(stream, "\n};\n\n");
+	char identifier[32];
+	snprintf(identifier, sizeof(identifier), "BB_ATTACKS_%s", name);
+	export_bitboards(stream, identifier, attacks, size);
+	free(attacks);
+	return EXIT_SUCCESS;
+}
+
+int
+main(int argc, char **argv)
+{
+	if (argc != 2) {
+		fputs("Usage: gen_threats <output.c>\n", stderr);
+		return EXIT_FAILURE;
+	}
+	FILE *stream = fopen(argv[1], "w");
+	if (!stream) {
+		fprintf(stderr, "[ERROR] Can't open '%s'.\n", argv[1]);
+		return EXIT_FAILURE;
+	}
+	fprintf(stream,
+	        "/* SPDX-License-Identifier: GPL-3.0-only */\n\n"
+	        "/* Generated by tools/gen_threats.c. Do not edit. */\n\n"
+	        "#include \"chess/generated/threats.h\"\n\n");
+	export_leaper(stream, "THREATS_BY_KNIGHT", threats_by_knight_no_init);
+	export_leaper(stream, "THREATS_BY_KING", threats_by_king_no_init);
+	int status = export_slider(stream, "BISHOP", MAGICS_BISHOP, threats_by_bishop_no_init);
+	if (status == EXIT_SUCCESS) {
+		status = export_slider(stream, "ROOK", MAGICS_ROOK, threats_by_rook_no_init);
+	}
+	if (fclose(stream) != 0 || status != EXIT_SUCCESS) {
+		fprintf(stderr, "[ERROR] Can't write to '%s'.\n", argv[1]);
+		remove(argv[1]);
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}